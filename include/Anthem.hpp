@@ -3,19 +3,27 @@
 
 #include "Global.hpp"
 #include "Util.hpp"
+#include "Denormals.hpp"
+#include "Arena.hpp"
+#include "EngineContext.hpp"
 
 #include "FM.hpp"
 #include "Noise.hpp"
 #include "Operator.hpp"
+#include "OperatorBank.hpp"
 
 #include "Reverb.hpp"
+#include "ConvolutionReverb.hpp"
+#include "Chorus.hpp"
 #include "Delay.hpp"
 #include "EffectBlock.hpp"
+#include "EffectChain.hpp"
 #include "Flanger.hpp"
 #include "Delay.hpp"
 #include "Filter.hpp"
 #include "Echo.hpp"
 
+#include "AudioBuffer.hpp"
 #include "AudioOutput.hpp"
 #include "Midi.hpp"
 #include "Mixer.hpp"
@@ -25,10 +33,23 @@
 #include "LFO.hpp"
 #include "Macro.hpp"
 
+#include <memory>
 #include <vector>
 
 class Anthem
 {
+    // All units use this instance's samplerate and tempo,
+    // as they take the context current at construction
+    EngineContext _context;
+    
+    EngineContext::Scope _contextScope;
+    
+    // Constructed before and destroyed after all units, which
+    // take their memory from it while the scope is open
+    Arena _arena;
+    
+    Arena::Scope _scope;
+    
 public:
     
     enum Units { A, B, C, D };
@@ -37,23 +58,35 @@ public:
     
     using count_t = std::size_t;
     
-    Anthem();
+    // Without devices, no MIDI port or audio device is opened
+    // and samples are only rendered by calling process()
+    explicit Anthem(const EngineContext& context = EngineContext::getDefault(),
+                    bool devices = true);
     
     void setNote(note_t note, bool on);
     
+    // Renders the next buffer.size() frames
+    void process(AudioBuffer& buffer);
+    
     count_t getSampleCount() const;
     
     double getPassedTime() const;
     
-    Operator operators [4];
+    const Arena& getArena() const;
     
-    LFOUnit lfos [4];
+    EngineContext& getContext();
     
-    Filter filters [2];
+    // In the order they are processed
+    Noise noise;
     
-    EffectBlock effects [2];
+    // The per-sample state of the operators
+    OperatorBank bank;
     
-    Noise noise;
+    Operator operators [4];
+    
+    FM fm;
+    
+    LFOUnit lfos [4];
     
     Envelope envelopes [4];
     
@@ -61,13 +94,18 @@ public:
     
     Crossfader crossfaders [4];
     
-    FM fm;
+    Filter filters [2];
+    
+    EffectBlock effects [2];
+    
+    EffectChain chain;
     
     Mixer mixer;
     
-    Midi midi;
+    // Null without devices
+    std::unique_ptr<Midi> midi;
     
-    AudioOutput audio;
+    std::unique_ptr<AudioOutput> audio;
     
 private:
     
@@ -75,9 +113,7 @@ private:
     
     Anthem& operator=(const Anthem&);
     
-    friend class AudioOutput;
-    
-    Sample _tick();
+    double _tick();
     
     void _update();
     
@@ -87,6 +123,8 @@ private:
     
     count_t _count;
     
+    static const std::size_t _arenaSize;
+    
 };
 
 #endif
@@ -14,6 +14,7 @@
 #define __Anthem__FM__
 
 class Operator;
+class OperatorBank;
 enum class Mode;
 
 /*************************************************************************************************//*!
@@ -63,6 +64,26 @@ public:
     /*! Returns a synthesized sample. */
     double tick();
     
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Synthesizes one sample for every set of a bank with the current algorithm.
+    *
+    *  @details     The Operator chain of one set is serial, so instead of ticking the Operators
+    *               one after the other, each step of the algorithm is performed for the same
+    *               Operator position of all sets at once, on contiguous slots. The Operators'
+    *               modes must match the algorithm. The LEVEL ModDocks are not ticked here, call
+    *               Operator::modulateLevel() for the active Operators first. The phases are not
+    *               advanced, call OperatorBank::update() for that. The output is the same as
+    *               tick()'s for the Operators of each set.
+    *
+    *  @param       bank The bank.
+    *
+    *  @param       output An array of bank.sets() values, one sample per set.
+    *
+    *****************************************************************************************************/
+    
+    void tick(OperatorBank& bank, double* output) const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Sets the currently used FM algorithm.
@@ -80,6 +101,17 @@ public:
     /*! Returns the currently used algorithm. */
     unsigned short getAlgorithm() const;
     
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Whether the Operators are silent.
+    *
+    *  @details     That is the case when none of them is both active and playing a note, see
+    *               Operator::hasNote(). Synthesis can then be skipped for the block.
+    *
+    *****************************************************************************************************/
+    
+    bool isSilent() const;
+    
 private:
     
     /*! Returns an Operator's tick if active, else 0. */
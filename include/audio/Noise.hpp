@@ -15,9 +15,8 @@
 
 #include "Units.hpp"
 
-#include <random>
-
-class Filter;
+#include <cstddef>
+#include <cstdint>
 
 /*********************************************************************************************//*!
 *
@@ -59,6 +58,14 @@ class Filter;
 *               -# __Violet noise__'s frequency spectrum shows a 6dB increase per octave. It can also
 *                  be generated by differentiating white noise.
 *
+*               White noise comes from a counter-based generator: each value is a hash of the seed
+*               and its position in the stream, so a whole block can be computed in one loop
+*               without any dependency between samples. The same seed always produces the same
+*               noise, which makes offline renders reproducible. Colors are produced with cheap
+*               dedicated filters: Paul Kellet's three-pole approximation for pink noise, a leaky
+*               integrator for red noise and first differences of pink and white noise for blue
+*               and violet noise respectively.
+*
 *               References:
 *
 *               + http://www.acousticfields.com/white-noise-definition-vs-pink-noise/
@@ -67,6 +74,8 @@ class Filter;
 *
 *               + http://www.mediacollege.com/audio/noise/
 *
+*               + http://www.firstpr.com.au/dsp/pink-noise/
+*
 *  @todo        Implement gray noise.
 *
 *************************************************************************************************/
@@ -98,9 +107,11 @@ public:
     *
     *  @param       amp The initial amplitude value between 0 and 1. Defaults to 1.
     *
+    *  @param       seed The seed for the random number generator.
+    *
     **************************************************************************************************************************/
     
-    Noise(unsigned short color = 0, double amp = 1);
+    Noise(unsigned short color = 0, double amp = 1, std::uint64_t seed = 0);
     
     Noise(const Noise& other);
     
@@ -124,6 +135,36 @@ public:
     
     void update();
     
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Generates a block of noise samples.
+    *
+    *  @details     The amplitude ModDock is ticked once per block and the amplitude is ramped
+    *               linearly across the block. The block is overwritten, not added to.
+    *
+    *  @param       block A pointer to the block to write to.
+    *
+    *  @param       size The number of samples to generate.
+    *
+    *  @return      Whether the block is silent, i.e. the amplitude was zero throughout.
+    *
+    *****************************************************************************************************/
+    
+    bool generate(double* block, std::size_t size);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Seeds the random number generator and resets the noise stream.
+    *
+    *  @param       seed The new seed.
+    *
+    *****************************************************************************************************/
+    
+    void setSeed(std::uint64_t seed);
+    
+    /*! Returns the current seed. */
+    std::uint64_t getSeed() const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Sets the noise color.
@@ -152,8 +193,11 @@ public:
     
 private:
     
-    /*! Filter that changes the noise color */
-    std::unique_ptr<Filter> _filter;
+    /*! Writes size white noise values in the range [-1,1) to block */
+    void _white(double* block, std::size_t size);
+    
+    /*! Filters a block of white noise in place according to the current color */
+    void _colorize(double* block, std::size_t size);
     
     /*! Current noise color */
     unsigned short _color;
@@ -161,11 +205,23 @@ private:
     /*! Current random value */
     double _rval;
     
-    /*! Mersenne-twister random number generator */
-    std::mt19937 _rgen;
+    /*! The seed of the random number generator */
+    std::uint64_t _seed;
+    
+    /*! The position in the random number stream */
+    std::uint64_t _counter;
+    
+    /*! Pink noise filter state (three one-pole low passes) */
+    double _pink [3];
+    
+    /*! Red noise integrator state */
+    double _red;
+    
+    /*! The last input value, for differentiating (blue and violet) */
+    double _last;
     
-    /*! Random number distribution (uniform) */
-    std::uniform_real_distribution<double> _dist;
+    /*! The amplitude at the end of the last block */
+    double _lastAmp;
 };
 
 #endif /* defined(__Anthem__Noise__) */
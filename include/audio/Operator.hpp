@@ -13,19 +13,27 @@
 #ifndef __Anthem__Operator__
 #define __Anthem__Operator__
 
-#include "Oscillator.hpp"
 #include "Units.hpp"
+#include "OperatorBank.hpp"
+
+#include <memory>
+
+class Wavetable;
 
 /*************************************************************************************************//*!
 *
 *  @brief       The Operator class.
 *
-*  @details     Operators are advanced Oscillators used for FM synthesis. They are the interface
+*  @details     Operators are advanced oscillators used for FM synthesis. They are the interface
 *               users ultimately interact with when producing and synthesizing music.
 *
+*               An Operator is a view into a slot of an OperatorBank, which holds its per-sample
+*               state. A new Operator has a bank of its own, bind() moves it into a slot of a
+*               shared bank so that it is advanced together with the other Operators there.
+*
 *****************************************************************************************************/
 
-class Operator : public Oscillator, public GenUnit
+class Operator : public GenUnit
 {
     
 public:
@@ -63,6 +71,35 @@ public:
              short phaseOffset = 0,
              double ratio = 1);
     
+    /*! Copies other's state into a bank of its own. */
+    Operator(const Operator& other);
+    
+    /*! Copies other's state into the current slot. */
+    Operator& operator= (const Operator& other);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Moves the Operator into a slot of an OperatorBank.
+    *
+    *  @details     The Operator's current state is copied into the slot, which the Operator
+    *               uses from then on. The bank must outlive the Operator.
+    *
+    *  @param       bank The OperatorBank.
+    *
+    *  @param       slot The slot, e.g. from OperatorBank::slot().
+    *
+    *  @throws      std::out_of_range if slot is not in the bank.
+    *
+    *****************************************************************************************************/
+    
+    void bind(OperatorBank& bank, OperatorBank::size_t slot);
+    
+    /*! Returns the OperatorBank the Operator is a view into. */
+    const OperatorBank& getBank() const;
+    
+    /*! Returns the Operator's slot in its OperatorBank. */
+    OperatorBank::size_t getSlot() const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Ticks a sample.
@@ -75,9 +112,18 @@ public:
     
     /*************************************************************************************************//*!
     *
-    *  @brief       Increment's the Operator's wavetable index.
+    *  @brief       Applies the LEVEL ModDock, if in use, to the Operator's bank slot.
+    *
+    *  @details     tick() does this itself. When the bank is ticked directly, e.g. with
+    *               FM::tick(OperatorBank&, double*), call this once per sample beforehand.
     *
-    *  @see         Oscillator::update()
+    *****************************************************************************************************/
+    
+    void modulateLevel();
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Increment's the Operator's wavetable index, if active.
     *
     *****************************************************************************************************/
     
@@ -95,9 +141,40 @@ public:
     
     void modulateFrequency(double value);
     
-    /*! @copydoc Oscillator::getFrequency() */
+    /*! Returns the current frequency, including the offset. */
     double getFrequency() const;
     
+    /*! Sets the wavetable by its id in the WavetableDatabase. */
+    void setWavetable(unsigned short id);
+    
+    /*! Returns the current wavetable. */
+    std::shared_ptr<const Wavetable> getWavetable() const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Sets the phase offset.
+    *
+    *  @param       degrees The offset, in degrees.
+    *
+    *****************************************************************************************************/
+    
+    void setPhaseOffset(short degrees);
+    
+    /*! Returns the phase offset, in degrees. */
+    double getPhaseOffset() const;
+    
+    /*! Resets the phase to the phase offset. */
+    void reset();
+    
+    /*! Activates or deactivates the Operator, inactive Operators stand still. */
+    void setActive(bool state);
+    
+    /*! Sets the amplitude until the level or note changes. */
+    void setAmp(double amp);
+    
+    /*! Returns the current amplitude. */
+    double getAmp() const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Sets the Operator's note.
@@ -116,6 +193,9 @@ public:
     
     void setSilent();
     
+    /*! Whether the Operator plays a note, i.e. setNote() was called since setSilent(). */
+    bool hasNote() const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Returns the Operator's current note.
@@ -236,33 +316,43 @@ public:
     
 private:
     
+    /*! Copies the state of a slot into the Operator's slot */
+    void _copyState(const OperatorBank& bank, OperatorBank::size_t slot);
+    
+    /*! Updates the real frequency and the amplitude after a frequency change */
+    void _updateFrequency();
+    
+    /*! The bank of its own, null once bound to another bank */
+    std::unique_ptr<OperatorBank, Arena::Deleter> _ownBank;
+    
+    /*! The bank holding the per-sample state (index, increments,
+        modulation, amplitude, level, real frequency and wavetable) */
+    OperatorBank* _bank;
+    
+    /*! The slot in _bank */
+    OperatorBank::size_t _slot;
+    
     /*! Current mode - FM or ADDITIVE */
     Mode _mode;
     
     /*! The max/min boundary for the current mode. */
     double _boundary;
     
-    /*! The current fm modulation level */
-    double _level;
-    
     /*! The frequency ratio of the Operator
         relative to the current note */
     double _ratio;
     
-    /*! Index increment offset from frequency modulaton */
-    double _modOffset;
-    
-    /*! Current frequency offset value in table index increment */
-    double _indexOffset;
-    
     /*! Current frequency offset value in Hertz */
     double _freqOffset;
     
     /*! Current frequency offset value in semitones */
     double _semitoneOffset;
     
-    /*! The real current frequency, _freq (which is _noteFreq * _ratio) + _freqOffset*/
-    double _realFreq;
+    /*! The frequency of the note times the ratio */
+    double _freq;
+    
+    /*! The phase offset, in wavetable samples */
+    double _phaseOffset;
     
     /*! The frequency of the original note, without any ratio */
     double _noteFreq;
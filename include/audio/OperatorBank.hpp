@@ -0,0 +1,188 @@
+/*********************************************************************************************//*!
+*
+*  @file        OperatorBank.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the OperatorBank class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__OperatorBank__
+#define __Anthem__OperatorBank__
+
+#include "Arena.hpp"
+
+#include <cstddef>
+#include <vector>
+
+class EngineContext;
+
+/*************************************************************************************************//*!
+*
+*  @brief       The per-sample state of a number of Operators, stored as struct-of-arrays.
+*
+*  @details     A bank holds one or more sets of four Operators (one set per note or instance
+*               of the synth). Each field of the Operators' audio-rate state (wavetable index,
+*               increments, amplitude and so on) is a contiguous array, with the Operators of
+*               the same position (A, B, C or D) in all sets next to each other. The kernels
+*               below work on a contiguous range of slots, so advancing the phase of all
+*               Operators of a bank is a single loop the compiler vectorizes, as is ticking or
+*               modulating the same Operator position across all sets.
+*
+*               Operator objects are views into a bank slot, which holds everything that
+*               changes per sample, while the Operators keep their control-rate parameters
+*               (ratio, offsets, mode) and ModDocks. Inactive Operators have a gate of zero: they
+*               output silence and their phase stands still.
+*
+*****************************************************************************************************/
+
+class OperatorBank
+{
+    
+public:
+    
+    typedef std::size_t size_t;
+    
+    typedef unsigned short index_t;
+    
+    /*! The number of Operators per set. */
+    static const index_t setSize = 4;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Constructs an OperatorBank.
+    *
+    *  @details     All slots start out inactive, silent and with the sine wavetable. The bank
+    *               uses the EngineContext current at construction.
+    *
+    *  @param       sets The number of sets of four Operators.
+    *
+    *  @throws      std::invalid_argument if sets is zero.
+    *
+    *****************************************************************************************************/
+    
+    OperatorBank(size_t sets = 1);
+    
+    /*! Returns the number of sets. */
+    size_t sets() const;
+    
+    /*! Returns the number of slots, four per set. */
+    size_t size() const;
+    
+    /*! Returns the slot of an Operator position (A-D) in a set. */
+    size_t slot(index_t position, size_t set) const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Ticks a range of slots.
+    *
+    *  @details     output[n] = wave(first + n) * amp(first + n) * gate(first + n)
+    *
+    *  @param       first The first slot.
+    *
+    *  @param       count The number of slots.
+    *
+    *  @param       output An array of at least count values.
+    *
+    *****************************************************************************************************/
+    
+    void tick(size_t first, size_t count, double* output) const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Frequency modulates a range of slots and ticks them.
+    *
+    *  @details     The values are converted to index increments, which are added to the slots'
+    *               increments on the next update, and then replaced with the slots' ticks.
+    *
+    *  @param       first The first slot.
+    *
+    *  @param       count The number of slots.
+    *
+    *  @param       values The modulation values in Hertz, replaced by the output.
+    *
+    *****************************************************************************************************/
+    
+    void modulate(size_t first, size_t count, double* values);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Adds the ticks of a range of slots to values.
+    *
+    *  @details     values[n] = (values[n] + tick(first + n)) * gate(first + n), so an inactive
+    *               Operator silences the values passed through it, like in FM::tick().
+    *
+    *  @param       first The first slot.
+    *
+    *  @param       count The number of slots.
+    *
+    *  @param       values The values to add to, replaced by the output.
+    *
+    *****************************************************************************************************/
+    
+    void add(size_t first, size_t count, double* values) const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Advances the phase of a range of slots by one sample.
+    *
+    *  @param       first The first slot.
+    *
+    *  @param       count The number of slots.
+    *
+    *****************************************************************************************************/
+    
+    void update(size_t first, size_t count);
+    
+    /*! Advances the phase of all slots by one sample. */
+    void update();
+    
+private:
+    
+    friend class Operator;
+    
+    OperatorBank(const OperatorBank&);
+    
+    OperatorBank& operator= (const OperatorBank&);
+    
+    /*! The EngineContext current at construction */
+    const EngineContext* _context;
+    
+    /*! The number of sets */
+    size_t _sets;
+    
+    /*! All fields, one row of size() values after the other */
+    std::vector<double, Arena::Allocator<double>> _memory;
+    
+    /*! The wavetable ids */
+    std::vector<unsigned short, Arena::Allocator<unsigned short>> _wavetable;
+    
+    /*! The current wavetable index */
+    double* _index;
+    
+    /*! The wavetable index increment per sample for the note */
+    double* _incr;
+    
+    /*! The index increment for the frequency offset */
+    double* _indexOffset;
+    
+    /*! The index increment from frequency modulation */
+    double* _modOffset;
+    
+    /*! The amplitude, the level times the frequency in FM mode */
+    double* _amp;
+    
+    /*! The level, between 0 and 10 in FM mode and 0 and 1 in additive mode */
+    double* _level;
+    
+    /*! The frequency including the offset */
+    double* _realFreq;
+    
+    /*! 1 if active, else 0 */
+    double* _gate;
+};
+
+#endif /* defined(__Anthem__OperatorBank__) */
@@ -16,6 +16,7 @@
 #include <memory>
 
 class Wavetable;
+class EngineContext;
 
 /*************************************************************************************************//*!
 *
@@ -71,6 +72,31 @@ public:
     
     virtual void update();
     
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Advances the oscillator's index by a number of samples at once.
+    *
+    *  @details     Equivalent to calling Oscillator::update() samples times, for oscillators
+    *               that are only evaluated at control rate.
+    *
+    *  @param       samples The number of samples to advance by.
+    *
+    *****************************************************************************************************/
+    
+    void advance(unsigned long samples);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Returns the value the oscillator would tick some samples from now.
+    *
+    *  @details     Does not change the oscillator, for precomputing its output.
+    *
+    *  @param       samples The number of samples from now, may be negative.
+    *
+    *****************************************************************************************************/
+    
+    double peek(double samples) const;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Sets the oscillator's frequency.
@@ -127,13 +153,13 @@ public:
     
     /*************************************************************************************************//*!
     *
-    *  @brief       Returns the oscillator's wavetable id.
+    *  @brief       Returns the oscillator's wavetable.
     *
-    *  @return      The wavetable id.
+    *  @details     Shares ownership, so never call this on the audio thread.
     *
     *****************************************************************************************************/
     
-    virtual std::shared_ptr<Wavetable> getWavetable() const;
+    virtual std::shared_ptr<const Wavetable> getWavetable() const;
     
     /*************************************************************************************************//*!
     *
@@ -160,8 +186,12 @@ protected:
     /*! The current phase offset value */
     double _phaseOffset;
     
-    /*! The wavetable member currently in use */
-    std::shared_ptr<Wavetable> _wavetable;
+    /*! The id of the wavetable in use, looked up in the WavetableDatabase
+        on every tick so that replaced tables are picked up immediately */
+    unsigned short _wavetable;
+    
+    /*! The EngineContext current at construction */
+    const EngineContext* _context;
 };
 
 #endif /* defined(__Anthem__Oscillator__) */
@@ -0,0 +1,201 @@
+/*********************************************************************************************//*!
+*
+*  @file        Chorus.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the Chorus effect class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__Chorus__
+#define __Anthem__Chorus__
+
+#include "Units.hpp"
+#include "DelayLine.hpp"
+
+#include <memory>
+
+class LFO;
+
+/************************************************************************************************//*!
+*
+*  @brief       Chorus class
+*
+*  @details     Mixes the signal with several copies of itself, each read from a shared delay
+*               line at a delay time modulated by its own LFO. The LFOs run at the same rate but
+*               are spread evenly in phase, so the voices drift against each other and the sound
+*               thickens without the comb filtering of a Flanger.
+*
+*               The LFOs are evaluated at control rate, once per chunk of up to 64 samples, and
+*               each voice's delay time ramps linearly between those values, so the per-sample
+*               work is just the interpolated read from the delay line.
+*
+*               In stereo, each channel has its own delay line. The right channel's voices are
+*               modulated inversely to the left channel's, so the two channels are decorrelated
+*               and the chorus widens the image.
+*
+*************************************************************************************************/
+
+class Chorus : public EffectUnit
+{
+public:
+    
+    /*! The maximum delay time (center + depth), in seconds. */
+    static const double maxDelay;
+    
+    /*! The number of voices. */
+    static const unsigned short voices = 3;
+    
+    /***********************************************************************************************//*!
+    *
+    *  @brief       Constructs a Chorus object.
+    *
+    *  @param       center The center delay time of the voices, in seconds.
+    *
+    *  @param       depth The maximum delay time added/subtracted from the center value, in seconds.
+    *
+    *  @param       rate The rate of the voices' LFOs, in Hertz.
+    *
+    *  @param       dryWet How much of the chorused signal should be mixed into the final signal.
+    *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
+    ************************************************************************************************/
+    
+    Chorus(double center = 0.02,
+           double depth = 0.003,
+           double rate = 0.8,
+           double dryWet = 0.5);
+    
+    /*! @copydoc Delay::Delay(const Delay&, bool) */
+    Chorus(const Chorus& other, bool copySamples = true);
+    
+    ~Chorus();
+    
+    /*! @copydoc EffectUnit::clone() */
+    Chorus* clone() const;
+    
+    Chorus& operator= (const Chorus& other);
+    
+    /*! @copydoc EffectUnit::process() */
+    double process(double sample);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a block of samples in place.
+    *
+    *  @details     Delay times shorter than a chunk are clamped to the chunk
+    *               size, which only affects settings where the center is
+    *               within a millisecond or so of the depth.
+    *
+    *  @param       block A pointer to the samples to process.
+    *
+    *  @param       size The number of samples in the block.
+    *
+    **************************************************************************/
+    
+    void processBlock(double* block, std::size_t size);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place.
+    *
+    *  @details     When a voice's delay time on the left channel is above the
+    *               center, it is as far below it on the right channel.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    **************************************************************************/
+    
+    void processStereo(double* left, double* right, std::size_t size);
+    
+    /*! Returns the longest delay time, in samples. */
+    std::size_t getTailLength() const;
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Sets the center delay time.
+    *
+    *  @param       center The new center delay time in seconds.
+    *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
+    **************************************************************************/
+    
+    void setCenter(double center);
+    
+    /*! Returns the center delay time, in seconds. */
+    double getCenter() const;
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Sets the depth of the delay time modulation.
+    *
+    *  @param       depth The new depth value, in seconds.
+    *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
+    **************************************************************************/
+    
+    void setDepth(double depth);
+    
+    /*! Returns the depth, in seconds. */
+    double getDepth() const;
+    
+    /*! Sets the rate of the voices' LFOs, in Hertz. */
+    void setRate(double rate);
+    
+    /*! Returns the rate of the voices' LFOs, in Hertz. */
+    double getRate() const;
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Sets how the delay line is interpolated.
+    *
+    *  @param       interpolation A member of DelayLine::Interpolation.
+    *
+    **************************************************************************/
+    
+    void setInterpolation(unsigned short interpolation);
+    
+    /*! Returns the interpolation method, a member of DelayLine::Interpolation. */
+    unsigned short getInterpolation() const;
+    
+private:
+    
+    /*! The maximum number of samples processed at once by processBlock() */
+    static const std::size_t _chunkSize = DelayLine::chunkSize;
+    
+    /*! Returns the chunk size for the current settings, sets minimum to the shortest delay time */
+    std::size_t _chunkLimit(double& minimum) const;
+    
+    /*! Center delay time around which the voices are modulated. */
+    double _center;
+    
+    /*! The interpolation method, a member of DelayLine::Interpolation. */
+    unsigned short _interpolation;
+    
+    /*! The last delay time of each voice, in samples. */
+    double _lengths [voices];
+    
+    /*! The last delay time of each voice on the right channel, in samples. */
+    double _lengthsRight [voices];
+    
+    /*! The LFOs modulating each voice's delay time. */
+    std::unique_ptr<LFO[], Arena::Deleter> _lfos;
+    
+    /*! The delay line shared by all voices. */
+    DelayLine _line;
+    
+    /*! The delay line of the right channel. */
+    DelayLine _lineRight;
+};
+
+#endif /* defined(__Anthem__Chorus__) */
@@ -0,0 +1,249 @@
+/*********************************************************************************************//*!
+*
+*  @file        ConvolutionReverb.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the ConvolutionReverb effect.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__ConvolutionReverb__
+#define __Anthem__ConvolutionReverb__
+
+#include "Units.hpp"
+#include "FFT.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/************************************************************************************************//*!
+*
+*  @brief       A convolution reverb.
+*
+*  @details     Convolves the signal with an impulse response (IR), usually a recording of a real
+*               room, loaded from a wavefile. Direct convolution would cost one multiplication per
+*               IR sample per output sample, which is far too slow for IRs several seconds long.
+*               Instead the IR is split into partitions of equal size, each of which is
+*               transformed to the frequency domain once, when the IR is set. The input is
+*               collected into blocks of the same size; each block is transformed and kept in a
+*               frequency-domain delay line, and the output is the sum of all past input spectra
+*               multiplied with their respective IR partition's spectrum (uniformly partitioned
+*               overlap-save convolution).
+*
+*               The cost per sample is thus independent of the partition size for the FFTs and
+*               proportional to the IR length for the spectral multiply-adds, and the latency is
+*               constant at one partition. All memory is allocated when the IR is set, none while
+*               processing.
+*
+*               Everything that depends on the IR is built on the control thread and handed to
+*               the audio thread with a single atomic exchange, like an EffectChain's list of
+*               units. The audio thread announces the state it is processing, and setting the
+*               IR only returns, freeing the old state, once the audio thread no longer uses it.
+*
+*               References:
+*
+*               + Wefers, F. (2014). Partitioned convolution algorithms for real-time auralization.
+*                 Logos Verlag Berlin.
+*
+*************************************************************************************************/
+
+class ConvolutionReverb : public EffectUnit
+{
+
+public:
+
+    enum Docks { DRYWET };
+
+    typedef std::size_t size_t;
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Constructs a ConvolutionReverb object.
+    *
+    *  @param       partitionSize The size of the IR partitions and thus the latency, in samples.
+    *               Must be a power of two.
+    *
+    *  @param       dryWet How much of the reverberated signal should be mixed into the final signal.
+    *
+    *  @throws      std::invalid_argument if partitionSize is not a power of two.
+    *
+    *************************************************************************************************/
+
+    ConvolutionReverb(size_t partitionSize = 256, double dryWet = 0.3);
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Copies a ConvolutionReverb.
+    *
+    *  @details     The spectra of the impulse response are immutable and shared between copies.
+    *
+    *  @param       other The ConvolutionReverb to copy.
+    *
+    *  @param       copySamples Whether to copy the input history or to start out silent.
+    *
+    *************************************************************************************************/
+
+    ConvolutionReverb(const ConvolutionReverb& other, bool copySamples = true);
+
+    ~ConvolutionReverb();
+
+    /*! @copydoc EffectUnit::clone() */
+    ConvolutionReverb* clone() const;
+
+    /*! @copydoc EffectUnit::process() */
+    double process(double sample);
+
+    /*! @copydoc EffectUnit::processBlock() */
+    void processBlock(double* block, std::size_t size);
+
+    /*! Processes a stereo block in place, convolving each channel with the IR on its own. */
+    void processStereo(double* left, double* right, std::size_t size);
+    
+    /*! Returns the length of the impulse response plus the latency, in samples. */
+    size_t getTailLength() const;
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Loads an impulse response from a wavefile.
+    *
+    *  @details     Multi-channel files are mixed down to mono and files at a different samplerate
+    *               are resampled. Allocates memory, so do not call this on the audio thread.
+    *
+    *  @param       fname The path to the wavefile.
+    *
+    *  @throws      FileOpenError or ParseError if the wavefile cannot be read.
+    *
+    *************************************************************************************************/
+
+    void loadImpulseResponse(const std::string& fname);
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Sets the impulse response.
+    *
+    *  @details     The IR is normalized to unit energy, so that IRs of different lengths and
+    *               levels result in similar loudness. Allocates memory, so do not call this on
+    *               the audio thread. Once this method returns, the audio thread no longer uses
+    *               the previous IR.
+    *
+    *  @param       ir The impulse response, at the global samplerate.
+    *
+    *************************************************************************************************/
+
+    void setImpulseResponse(const std::vector<double>& ir);
+
+    /*! Removes the impulse response, the effect then passes signals through unchanged. */
+    void clearImpulseResponse();
+
+    /*! Whether or not an impulse response is set. */
+    bool hasImpulseResponse() const;
+
+    /*! Returns the length of the impulse response, in seconds. */
+    double getLength() const;
+
+    /*! Returns the latency of the wet signal, in samples. */
+    size_t getLatency() const;
+
+    /*! @copydoc EffectUnit::setDryWet() */
+    void setDryWet(double dw);
+
+    /*! @copydoc EffectUnit::getDryWet() */
+    double getDryWet() const;
+
+private:
+
+    typedef FFT::complex_t complex_t;
+
+    /*! The input and output of one channel */
+    struct Channel
+    {
+        Channel(size_t partitionSize, size_t bins, size_t partitions)
+        : history(partitions * bins, 0),
+          input(2 * partitionSize, 0),
+          output(partitionSize, 0)
+        { }
+
+        /*! The frequency-domain delay line of input spectra, _bins per partition */
+        std::vector<complex_t> history;
+
+        /*! The last two blocks of input, the second one being filled */
+        std::vector<double> input;
+
+        /*! The block of output being played back */
+        std::vector<double> output;
+    };
+
+    /*! Everything that depends on the IR, as processed on the audio thread */
+    struct State
+    {
+        State(size_t partitionSize, size_t bins, size_t partitionCount, size_t irLength)
+        : partitions(partitionCount),
+          length(irLength),
+          channels { Channel(partitionSize, bins, partitionCount),
+                     Channel(partitionSize, bins, partitionCount) },
+          newest(0),
+          position(0)
+        { }
+
+        /*! The number of IR partitions */
+        size_t partitions;
+
+        /*! The length of the IR, in samples */
+        size_t length;
+
+        /*! The spectra of the IR partitions, _bins per partition, shared by copies */
+        std::shared_ptr<const std::vector<complex_t>> spectra;
+
+        /*! The left (or mono) and right channel */
+        Channel channels [2];
+
+        /*! The partition in the histories holding the newest input spectrum */
+        size_t newest;
+
+        /*! The position in the current input and output blocks */
+        size_t position;
+    };
+
+    /*! Convolves the last full block of input of the first channels, refilling their output */
+    void _convolve(State& state, unsigned short channels);
+
+    /*! Announces and returns the live state, null without an IR */
+    State* _acquire();
+
+    /*! Makes state the live state and frees the old one once the audio thread is done with it */
+    void _publish(State* state);
+
+    /*! The partition size, in samples */
+    size_t _partitionSize;
+
+    /*! The number of spectral bins stored per partition (the rest are conjugates) */
+    size_t _bins;
+
+    /*! The number of IR partitions of the live state, for the control thread */
+    std::atomic<size_t> _partitions;
+
+    /*! The length of the IR of the live state, in samples */
+    std::atomic<size_t> _length;
+
+    /*! The FFT, of twice the partition size */
+    FFT _fft;
+
+    /*! The state to process, null without an IR */
+    std::atomic<State*> _live;
+
+    /*! The state the audio thread is currently processing, if any */
+    std::atomic<State*> _hazard;
+
+    /*! Scratch memory for transforms on the audio thread */
+    std::vector<complex_t> _work;
+
+    /*! Scratch memory for accumulating spectra */
+    std::vector<complex_t> _accumulator;
+};
+
+#endif /* defined(__Anthem__ConvolutionReverb__) */
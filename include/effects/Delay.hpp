@@ -14,8 +14,7 @@
 #define __Anthem__Delay__
 
 #include "Units.hpp"
-
-#include <vector>
+#include "DelayLine.hpp"
 
 /*************************************************************************//*!
 *
@@ -51,7 +50,9 @@ public:
     *
     *  @param       feedbackLevel The amount of output from the delay line to feed back.
     *
-    *  @param       capacity The total capacity of the delay line, in seconds (must exceed length). 
+    *  @param       capacity The maximum length of the delay line, in seconds. Memory is allocated
+    *               for exactly this much delay, so it should be as small as the use allows.
+    *               Defaults to 0, meaning the delay line's capacity is delayLength.
     *
     **************************************************************************************************/
     
@@ -59,14 +60,28 @@ public:
           double decayTime = 4,
           double decayRate = 0.001,
           double feedbackLevel = 0,
-          double capacity = 10);
+          double capacity = 0);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Copies a Delay.
+    *
+    *  @param       other The Delay to copy.
+    *
+    *  @param       copySamples Whether to copy the contents of the delay
+    *               lines or to start out silent, see clone().
+    *
+    ****************************************************************************/
     
-    Delay(const Delay& other);
+    Delay(const Delay& other, bool copySamples = true);
     
     Delay& operator=(const Delay& other);
     
     virtual ~Delay() { }
     
+    /*! @copydoc EffectUnit::clone() */
+    virtual Delay* clone() const;
+    
     /*************************************************************************//*!
     *
     *  @brief       Processes a sample.
@@ -83,6 +98,58 @@ public:
     
     virtual double process(double sample);
     
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a block of samples in place.
+    *
+    *  @details     The ModDocks are ticked once per block. The block is read
+    *               from and written to the delay line in chunks no longer
+    *               than the delay, so that no chunk depends on itself.
+    *
+    *  @param       block A pointer to the samples to process.
+    *
+    *  @param       size The number of samples in the block.
+    *
+    ****************************************************************************/
+    
+    virtual void processBlock(double* block, std::size_t size);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place.
+    *
+    *  @details     Each channel has its own delay line, the parameters and
+    *               their modulation are shared. In ping-pong mode the
+    *               channels feed each other instead of themselves.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    ****************************************************************************/
+    
+    virtual void processStereo(double* left, double* right, std::size_t size);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Sets whether or not echoes alternate between the channels.
+    *
+    *  @details     Only affects processStereo().
+    *
+    *  @param       state The new ping-pong state.
+    *
+    ****************************************************************************/
+    
+    void setPingPong(bool state);
+    
+    /*! Whether or not echoes alternate between the channels. */
+    bool isPingPong() const;
+    
+    /*! Returns the delay time plus a sample of interpolation, in samples. */
+    virtual std::size_t getTailLength() const;
+    
     /*! @copydoc EffectUnit::setDryWet() */
     virtual void setDryWet(double dw);
     
@@ -109,6 +176,16 @@ public:
     
     virtual double getDelayTime() const;
     
+    /*************************************************************************//*!
+    *
+    *  @brief       Returns the maximum length of the delay line.
+    *
+    *  @return      The delay line's capacity, in seconds.
+    *
+    ****************************************************************************/
+    
+    double getCapacity() const;
+    
     /*************************************************************************//*!
     *
     *  @brief       Sets the time for the delay to fade out.
@@ -172,9 +249,9 @@ public:
     
     /************************************************************************************************//*!
     *
-    *  @brief       Sets an offset in the delay line.
+    *  @brief       Returns the sample at an offset in the delay line.
     *
-    *  @param       offset The new offset, in samples.
+    *  @param       offset The offset from the write position, in samples.
     *
     *************************************************************************************************/
     
@@ -182,26 +259,26 @@ public:
     
 protected:
     
-    typedef std::vector<double> Buffer;
-    
-    typedef Buffer::iterator iterator;
+    /*! The maximum number of samples processed at once by processBlock() */
+    static const size_t _chunkSize = 64;
     
-    typedef Buffer::const_iterator const_iterator;
+    /*! Returns the buffer size needed for a delay line of the given length, in seconds */
+    size_t _samplesFor(double seconds) const;
     
-    /*! Calculates the _decayValue based on the decay rate, time and delay length*/
-    void _calcDecay();
+    /*! Ticks the ModDocks and updates the parameters they control */
+    void _modulate();
     
-    /*! Increments and boundary checks the write pointer */
-    inline void _writeAndIncrement(double sample);
+    /*! Processes a sample without modulation or dry/wet, returns the delayed sample */
+    double _tick(double sample);
     
-    /*! Integral part of the read position */
-    int _readIntegral;
+    /*! Like _tick(double), on the given delay line */
+    double _tick(DelayLine& line, double sample);
     
-    /*! Fractional part of the read position */
-    double _readFractional;
+    /*! Calculates the _decayValue based on the decay rate, time and delay length*/
+    void _calcDecay();
     
-    /*! The pointer to the write index */
-    iterator _write;
+    /*! The delay time, in samples */
+    double _delayTime;
     
     /*! The attenuation value with which to multiply the output */
     double _decayValue;
@@ -215,8 +292,17 @@ protected:
     /*! The value determining how much of the output signal is fed back into the delay line */
     double _feedback;
     
-    /*! The delay line */
-    Buffer _buffer;
+    /*! The maximum delay time, in samples */
+    size_t _capacity;
+    
+    /*! Whether or not echoes alternate between the channels */
+    bool _pingPong;
+    
+    /*! The delay line, of the left channel in stereo */
+    DelayLine _line;
+    
+    /*! The delay line of the right channel */
+    DelayLine _lineRight;
 };
 
 /************************************************************************************************//*!
@@ -233,11 +319,42 @@ struct AllPassDelay : public Delay
     AllPassDelay(const double& delayLength = 1,
                  const double& decayTime = 4,
                  const double& decayRate = 0.001,
-                 const double& feedbackLevel = 1)
-    : Delay(delayLength,decayTime,decayRate,feedbackLevel)
+                 const double& feedbackLevel = 1,
+                 const double& capacity = 0)
+    : Delay(delayLength,decayTime,decayRate,feedbackLevel,capacity)
+    { }
+    
+    /*! @copydoc Delay::Delay(const Delay&, bool) */
+    AllPassDelay(const AllPassDelay& other, bool copySamples = true)
+    : Delay(other, copySamples)
     { }
     
+    /*! @copydoc Delay::operator=() */
+    AllPassDelay& operator=(const AllPassDelay& other)
+    {
+        Delay::operator=(other);
+        
+        return *this;
+    }
+    
+    /*! @copydoc EffectUnit::clone() */
+    AllPassDelay* clone() const;
+    
     /*! @copydoc Delay::process() */
     double process(double sample);
+    
+    /*! @copydoc Delay::processBlock() */
+    void processBlock(double* block, std::size_t size);
+    
+    /*! Processes a stereo block in place, each channel with its own delay line. */
+    void processStereo(double* left, double* right, std::size_t size);
+    
+private:
+    
+    /*! Processes a sample on the given delay line */
+    double _tick(DelayLine& line, double sample);
+    
+    /*! Processes a block of samples in place on the given delay line */
+    void _process(DelayLine& line, double* block, std::size_t size);
 };
 #endif /* defined(__Anthem__Delay__) */
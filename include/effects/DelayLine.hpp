@@ -0,0 +1,181 @@
+/*********************************************************************************************//*!
+*
+*  @file        DelayLine.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the DelayLine class, the ring buffer underlying all delay effects.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__DelayLine__
+#define __Anthem__DelayLine__
+
+#include "Arena.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/*********************************************************************************************//*!
+*
+*  @brief       Ring buffer for delay effects.
+*
+*  @details     The capacity of a DelayLine is always a power of two, so positions wrap around
+*               with a bit mask rather than with comparisons. Samples can be written and read
+*               one at a time or in whole blocks, in which case the wrap-around is handled
+*               once per block by splitting the copy at the end of the buffer.
+*
+*               All delays are measured relative to the next sample to be written: a delay
+*               of 1 is the most recently written sample. When reading a block, sample n of
+*               the block is delayed relative to the n-th sample written after the read, so
+*               reading a block and then writing a block of the same size is equivalent to
+*               reading and writing sample by sample, provided the delay is at least as long
+*               as the block.
+*
+*               Samples too small to be audible are written as zeros, so that signals decaying
+*               in a feedback loop through the line never become denormal.
+*
+*************************************************************************************************/
+
+class DelayLine
+{
+
+public:
+
+    typedef std::size_t size_t;
+
+    /*! The number of samples read at once by the modulated read(), which splits longer blocks. */
+    static const size_t chunkSize = 64;
+
+    /*! Interpolation methods for modulated reads */
+    enum Interpolation
+    {
+        LINEAR,
+        CUBIC
+    };
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Constructs a DelayLine.
+    *
+    *  @param       capacity The minimum capacity in samples. The actual
+    *               capacity is the next power of two.
+    *
+    ****************************************************************************/
+
+    DelayLine(size_t capacity = 1);
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Sets the capacity of the DelayLine and clears it.
+    *
+    *  @details     Allocates memory, so never call this on the audio thread.
+    *
+    *  @param       capacity The minimum capacity in samples.
+    *
+    ****************************************************************************/
+
+    void resize(size_t capacity);
+
+    /*! Returns the capacity, in samples. */
+    size_t capacity() const;
+
+    /*! Sets all samples to zero. */
+    void clear();
+
+    /*! Writes a sample and advances the write position. */
+    void write(double sample);
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Writes a block of samples and advances the write position.
+    *
+    *  @param       block A pointer to the samples to write.
+    *
+    *  @param       size The number of samples, at most capacity().
+    *
+    ****************************************************************************/
+
+    void write(const double* block, size_t size);
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Reads a sample at an integral delay.
+    *
+    *  @param       delay The delay in samples, between 1 and capacity().
+    *
+    ****************************************************************************/
+
+    double read(size_t delay) const;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Reads a sample at a fractional delay.
+    *
+    *  @details     Linearly interpolates between the two nearest samples.
+    *
+    *  @param       delay The delay in samples, between 1 and capacity() - 1.
+    *
+    ****************************************************************************/
+
+    double read(double delay) const;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Reads a block of samples at a fixed fractional delay.
+    *
+    *  @details     The block is read in at most two contiguous runs, whose
+    *               interpolation loops have no dependencies between samples.
+    *
+    *  @param       block A pointer to write the samples to.
+    *
+    *  @param       size The number of samples, at most delay.
+    *
+    *  @param       delay The delay in samples, between 1 and capacity() - 1.
+    *
+    ****************************************************************************/
+
+    void read(double* block, size_t size, double delay) const;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Reads a block of samples, each at its own fractional delay.
+    *
+    *  @details     Used for modulated delay times (flanging, chorus). Cubic
+    *               (4-point Hermite) interpolation avoids the high frequency
+    *               loss linear interpolation causes for delays moving slowly
+    *               between samples, at about twice the cost. The positions
+    *               and weights are computed for the whole block before the
+    *               samples are fetched, chunkSize samples at a time.
+    *
+    *  @param       block A pointer to write the samples to.
+    *
+    *  @param       delays The delay for each sample of the block, none
+    *               shorter than the block size (plus one for CUBIC).
+    *
+    *  @param       size The number of samples.
+    *
+    *  @param       interpolation The interpolation method, defaults to LINEAR.
+    *
+    ****************************************************************************/
+
+    void read(double* block,
+              const double* delays,
+              size_t size,
+              unsigned short interpolation = LINEAR) const;
+
+private:
+
+    /*! The samples, in the current Arena if any */
+    std::vector<double, Arena::Allocator<double>> _buffer;
+
+    /*! The capacity minus one, for wrapping positions */
+    size_t _mask;
+
+    /*! The position of the next sample to write */
+    size_t _write;
+};
+
+#endif /* defined(__Anthem__DelayLine__) */
@@ -38,7 +38,8 @@ struct Echo : public Delay
     *
     *  @param       feedbackLevel How much of the output to feed back into the delay line.
     *
-    *  @param       capacity The total capacity of the delay line, in seconds (must exceed length).
+    *  @param       capacity The maximum length of the delay line, in seconds. Defaults to 0,
+    *               meaning the delay line's capacity is delayLength.
     *
     *************************************************************************************************/
     
@@ -46,10 +47,16 @@ struct Echo : public Delay
          double decayTime = 4,
          double decayRate = 0.01,
          double feedbackLevel = 1,
-         double capacity = 10);
+         double capacity = 0);
+    
+    /*! @copydoc Delay::Delay(const Delay&, bool) */
+    Echo(const Echo& other, bool copySamples = true);
     
     ~Echo();
     
+    /*! @copydoc EffectUnit::clone() */
+    Echo* clone() const;
+    
     /************************************************************************************************//*!
     *
     *  @brief       Processes a sample.
@@ -64,6 +71,12 @@ struct Echo : public Delay
     *************************************************************************************************/
     
     double process(double sample);
+    
+    /*! @copydoc Delay::processBlock() */
+    void processBlock(double* block, std::size_t size);
+    
+    /*! @copydoc Delay::processStereo() */
+    void processStereo(double* left, double* right, std::size_t size);
 };
 
 
@@ -13,13 +13,16 @@
 #ifndef Anthem_EffectBlock_hpp
 #define Anthem_EffectBlock_hpp
 
+#include "Units.hpp"
+
 #include <memory>
 
-class EffectUnit;
 class Delay;
 class Echo;
 class Reverb;
 class Flanger;
+class ConvolutionReverb;
+class Chorus;
 
 /************************************************************************************************//*!
 *
@@ -27,16 +30,25 @@ class Flanger;
 *
 *  @details     The EffectBlock class makes it easy to access all effects from one interface
 *               rather than having to maintain an object for each effect. What is especially
-*               useful is that the process() method processes a sample for the currently set
+*               useful is that the processBlock() method processes a block for the currently set
 *               effect. The underlying effects can be accessed to modify their properties.
+*               An EffectBlock is itself an EffectUnit, so it can be placed in an EffectChain.
+*
+*               Effects, and with them their delay lines, are only created once they are
+*               selected via setEffectType() or accessed, so an EffectBlock only holds memory
+*               for the effects actually in use. Both happen on the control thread, never in
+*               process(), so no allocation takes place on the audio thread.
 *
 *************************************************************************************************/
 
-class EffectBlock
+class EffectBlock : public EffectUnit
 {
     
 public:
     
+    /*! The maximum delay time of the Delay and Echo effects, in seconds */
+    static const unsigned short maxDelayTime = 10;
+    
     /*! Currently available effects */
     enum EffectTypes
     {
@@ -44,7 +56,9 @@ public:
         DELAY,
         ECHO,
         REVERB,
-        FLANGER
+        FLANGER,
+        CONVOLUTION,
+        CHORUS
     };
     
     /*************************************************************************//*!
@@ -61,12 +75,7 @@ public:
     
     /*************************************************************************//*!
     *
-    *  @brief       Processes a sample for the currently selected effect.
-    *
-    *  @details     The call is forwarded to the process() method of the effect
-    *               that the internal polymorphic pointer currently points to.
-    *
-    *  @param       sample The sample to process.
+    *  @brief       Processes a sample with the currently selected effect.
     *
     *  @throws      std::invalid_argument if current type is NONE.
     *
@@ -76,65 +85,82 @@ public:
     
     /*************************************************************************//*!
     *
-    *  @brief       Sets the current effect type.
+    *  @brief       Processes a block with the currently selected effect.
     *
-    *  @param       efffectType The new effectType.
+    *  @details     The call is forwarded to the processBlock() method of the
+    *               effect that the internal polymorphic pointer currently
+    *               points to.
     *
-    *  @see         EffectTypes
+    *  @param       block A pointer to the samples to process.
+    *
+    *  @param       size The number of samples in the block.
+    *
+    *  @throws      std::invalid_argument if current type is NONE.
     *
     ****************************************************************************/
     
-    void setEffectType(unsigned short effectType);
+    void processBlock(double* block, std::size_t size);
     
     /*************************************************************************//*!
     *
-    *  @brief       Returns the current effect type.
+    *  @brief       Processes a stereo block with the currently selected effect.
     *
-    *  @see         EffectTypes
+    *  @throws      std::invalid_argument if current type is NONE.
     *
     ****************************************************************************/
     
-    unsigned short getEffectType() const;
+    void processStereo(double* left, double* right, std::size_t size);
+    
+    /*! Returns the tail length of the currently selected effect, in samples. */
+    std::size_t getTailLength() const;
+    
+    /*! Clones the block along with all effects it has created, see EffectUnit::clone(). */
+    EffectBlock* clone() const;
     
     /*************************************************************************//*!
     *
-    *  @brief       Sets the active property of the EffectBlock.
+    *  @brief       Sets the current effect type.
+    *
+    *  @details     Creates the effect if it does not exist yet. Previously
+    *               selected effects are kept, with their settings.
     *
-    *  @detail      An inactive EffectBlock will return the sample supplied to
-    *               process() immediately, without any processing.
+    *  @param       efffectType The new effectType.
     *
-    *  @param       state The new boolean state.
+    *  @see         EffectTypes
     *
     ****************************************************************************/
     
-    void setActive(bool state);
+    void setEffectType(unsigned short effectType);
     
     /*************************************************************************//*!
     *
-    *  @brief       Whether or not the EffectBlock is currently active.
+    *  @brief       Returns the current effect type.
     *
-    *  @return      Boolean, true if active, else false.
+    *  @see         EffectTypes
     *
     ****************************************************************************/
     
-    bool isActive() const;
+    unsigned short getEffectType() const;
     
-    /*! Returns a reference to the Delay object. */
-    Delay& delay() const;
+    /*! Returns a reference to the Delay object, creating it if necessary. */
+    Delay& delay();
     
-    /*! Returns a reference to the Echo object. */
-    Echo& echo() const;
+    /*! Returns a reference to the Echo object, creating it if necessary. */
+    Echo& echo();
     
-    /*! Returns a reference to the Reverb object. */
-    Reverb& reverb() const;
+    /*! Returns a reference to the Reverb object, creating it if necessary. */
+    Reverb& reverb();
     
-    /*! Returns a reference to the Flanger object. */
-    Flanger& flanger() const;
+    /*! Returns a reference to the Flanger object, creating it if necessary. */
+    Flanger& flanger();
     
-private:
+    /*! Returns a reference to the ConvolutionReverb object, creating it if necessary. */
+    ConvolutionReverb& convolution();
     
-    /*! Whether or not the EffectBlock is active. */
-    bool _active;
+    /*! Returns a reference to the Chorus object, creating it if necessary. */
+    Chorus& chorus();
+    
+private:
     
     /*! The polymorphic pointer to the currently selected EffectUnit. */
     EffectUnit* _curr;
@@ -142,17 +168,23 @@ private:
     /*! The currently selected EffectType. */
     unsigned short _effectType;
     
-    /*! Smart pointer to Delay object. */
-    std::unique_ptr<Delay> _delay;
+    /*! Smart pointer to Delay object, null until first used. */
+    std::unique_ptr<Delay, Arena::Deleter> _delay;
+    
+    /*! Smart pointer to Echo object, null until first used. */
+    std::unique_ptr<Echo, Arena::Deleter> _echo;
+    
+    /*! Smart pointer to Reverb object, null until first used. */
+    std::unique_ptr<Reverb, Arena::Deleter> _reverb;
     
-    /*! Smart pointer to Echo object. */
-    std::unique_ptr<Echo> _echo;
+    /*! Smart pointer to Flanger object, null until first used. */
+    std::unique_ptr<Flanger, Arena::Deleter> _flanger;
     
-    /*! Smart pointer to Reverb object. */
-    std::unique_ptr<Reverb> _reverb;
+    /*! Smart pointer to ConvolutionReverb object, null until first used. */
+    std::unique_ptr<ConvolutionReverb, Arena::Deleter> _convolution;
     
-    /*! Smart pointer to Flanger object. */
-    std::unique_ptr<Flanger> _flanger;
+    /*! Smart pointer to Chorus object, null until first used. */
+    std::unique_ptr<Chorus, Arena::Deleter> _chorus;
 };
 
 #endif
@@ -0,0 +1,214 @@
+/*********************************************************************************************//*!
+*
+*  @file        EffectChain.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the EffectChain class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__EffectChain__
+#define __Anthem__EffectChain__
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class EffectUnit;
+
+/************************************************************************************************//*!
+*
+*  @brief       An ordered chain of insert effects.
+*
+*  @details     An EffectChain holds any number of EffectUnits (filters, effects or whole
+*               EffectBlocks) in a user-defined order and processes a block through each of them
+*               in turn, in stereo. The chain does not own its units.
+*
+*               The chain is edited on the control thread only. Every edit compiles a new list of
+*               the units to process, leaving out bypassed slots entirely, and swaps it in with a
+*               single atomic exchange, so process() never locks, allocates or even looks at a
+*               bypassed slot. The audio thread announces the list it is processing, and an edit
+*               only returns, freeing the old list, once the audio thread no longer uses it. After
+*               removeUnit() returns, the removed unit may thus be destroyed right away.
+*
+*               Units that are bypassed keep their state, units that are inactive (see
+*               Unit::setActive()) are skipped at run time.
+*
+*************************************************************************************************/
+
+class EffectChain
+{
+    
+public:
+    
+    typedef std::size_t size_t;
+    
+    EffectChain();
+    
+    ~EffectChain();
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a block through all units of the chain in order.
+    *
+    *  @details     Called on the audio thread only. Silence is passed from
+    *               unit to unit, so units whose input and tail are silent
+    *               are skipped (see EffectUnit::render()).
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    *  @param       silent Whether the input block is silent.
+    *
+    *  @return      Whether the output block is silent.
+    *
+    ****************************************************************************/
+    
+    bool process(double* left, double* right, std::size_t size, bool silent = false);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Appends a unit to the end of the chain.
+    *
+    *  @param       unit The unit to append.
+    *
+    *  @throws      std::invalid_argument if unit is null.
+    *
+    ****************************************************************************/
+    
+    void addUnit(EffectUnit* unit);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Inserts a unit into the chain.
+    *
+    *  @param       index The slot to insert the unit at, up to size().
+    *
+    *  @param       unit The unit to insert.
+    *
+    *  @throws      std::invalid_argument if unit is null.
+    *
+    *  @throws      std::out_of_range if index is greater than size().
+    *
+    ****************************************************************************/
+    
+    void insertUnit(size_t index, EffectUnit* unit);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Removes a unit from the chain.
+    *
+    *  @details     Once this method returns, the audio thread no longer
+    *               uses the unit.
+    *
+    *  @param       index The slot of the unit to remove.
+    *
+    *  @throws      std::out_of_range if index is out of range.
+    *
+    ****************************************************************************/
+    
+    void removeUnit(size_t index);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Moves a unit to another slot.
+    *
+    *  @param       from The slot of the unit to move.
+    *
+    *  @param       to The slot to move the unit to, the units in between
+    *               are shifted by one.
+    *
+    *  @throws      std::out_of_range if either index is out of range.
+    *
+    ****************************************************************************/
+    
+    void moveUnit(size_t from, size_t to);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Returns the unit in a slot.
+    *
+    *  @throws      std::out_of_range if index is out of range.
+    *
+    ****************************************************************************/
+    
+    EffectUnit* getUnit(size_t index) const;
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Bypasses a slot or takes it back into the chain.
+    *
+    *  @param       index The slot.
+    *
+    *  @param       state Whether or not to bypass the slot.
+    *
+    *  @throws      std::out_of_range if index is out of range.
+    *
+    ****************************************************************************/
+    
+    void setBypassed(size_t index, bool state);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Whether or not a slot is bypassed.
+    *
+    *  @throws      std::out_of_range if index is out of range.
+    *
+    ****************************************************************************/
+    
+    bool isBypassed(size_t index) const;
+    
+    /*! Returns the number of slots, including bypassed ones. */
+    size_t size() const;
+    
+    /*! Removes all units. */
+    void clear();
+    
+private:
+    
+    /*! A slot of the chain, as edited on the control thread */
+    struct Slot
+    {
+        Slot(EffectUnit* u = nullptr)
+        : unit(u), bypassed(false)
+        { }
+        
+        EffectUnit* unit;
+        
+        bool bypassed;
+    };
+    
+    /*! The compiled chain, as processed on the audio thread */
+    typedef std::vector<EffectUnit*> chain_t;
+    
+    EffectChain(const EffectChain&);
+    
+    EffectChain& operator= (const EffectChain&);
+    
+    /*! Throws std::out_of_range if index is not a slot */
+    void _check(size_t index) const;
+    
+    /*! Compiles the slots into a new chain and swaps it in */
+    void _rebuild();
+    
+    /*! The slots, guarded by _mutex */
+    std::vector<Slot> _slots;
+    
+    /*! Serializes edits from multiple control threads */
+    mutable std::mutex _mutex;
+    
+    /*! The chain to process */
+    std::atomic<chain_t*> _live;
+    
+    /*! The chain the audio thread is currently processing, if any */
+    std::atomic<chain_t*> _hazard;
+};
+
+#endif /* defined(__Anthem__EffectChain__) */
@@ -83,6 +83,9 @@ public:
            double q = 1,
            double gain = 0);
     
+    /*! @copydoc EffectUnit::clone() */
+    Filter* clone() const;
+    
     /*************************************************************************//*!
     *
     *  @brief       Filters a sample.
@@ -95,6 +98,24 @@ public:
     
     double process(double sample);
     
+    /*************************************************************************//*!
+    *
+    *  @brief       Filters a stereo block.
+    *
+    *  @details     The channels are filtered with the same coefficients,
+    *               which are only modulated once per sample, as the two
+    *               lanes of an SSE2 register where available.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    ****************************************************************************/
+    
+    void processStereo(double* left, double* right, std::size_t size);
+    
     /*! @copydoc EffectUnit::setDryWet() */
     void setDryWet(double dw);
     
@@ -203,6 +224,9 @@ private:
     
     void _calcCoefs();
     
+    /*! Ticks the ModDocks and recalculates the coefficients if necessary */
+    void _modulate();
+    
     /*! The filter mode */
     unsigned short _mode;
     
@@ -224,6 +248,12 @@ private:
     /*! The second delay variable _x{n-2}*/
     double _delayB;
     
+    /*! The first delay variable of the right channel */
+    double _delayRightA;
+    
+    /*! The second delay variable of the right channel */
+    double _delayRightB;
+    
     /*! The first output coefficient */
     double coefA1_;
     
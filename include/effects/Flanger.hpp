@@ -14,8 +14,8 @@
 #define Anthem_Flanger_hpp
 
 #include "Units.hpp"
+#include "DelayLine.hpp"
 
-class Delay;
 class LFO;
 
 /************************************************************************************************//*!
@@ -31,6 +31,9 @@ class Flanger : public EffectUnit
 {
 public:
     
+    /*! The maximum delay time (center + depth), in seconds. */
+    static const double maxDelay;
+    
     /***********************************************************************************************//*!
     *
     *  @brief       Constructs a Flanger object.
@@ -43,6 +46,8 @@ public:
     *
     *  @param       feedback Controls the brightness/coloration of the produced sound.
     *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
     ************************************************************************************************/
     
     Flanger(double center = 0.01,
@@ -50,10 +55,14 @@ public:
             double rate = 0.1,
             double feedback = 0);
     
-    Flanger(const Flanger& other);
+    /*! @copydoc Delay::Delay(const Delay&, bool) */
+    Flanger(const Flanger& other, bool copySamples = true);
     
     ~Flanger();
     
+    /*! @copydoc EffectUnit::clone() */
+    Flanger* clone() const;
+    
     Flanger& operator= (const Flanger& other);
     
     /*************************************************************************//*!
@@ -72,12 +81,51 @@ public:
     
     double process(double sample);
     
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a block of samples in place.
+    *
+    *  @details     The LFO is evaluated at control rate, once per chunk of
+    *               the block, and the delay time ramps linearly between those
+    *               values. The delay times are computed for the whole chunk
+    *               first and then read from the delay line at once.
+    *
+    *  @param       block A pointer to the samples to process.
+    *
+    *  @param       size The number of samples in the block.
+    *
+    **************************************************************************/
+    
+    void processBlock(double* block, std::size_t size);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place.
+    *
+    *  @details     Each channel has its own delay line and LFO, the right
+    *               channel's LFO running 90 degrees ahead of the left one's.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    **************************************************************************/
+    
+    void processStereo(double* left, double* right, std::size_t size);
+    
+    /*! Returns the longest delay time, in samples. */
+    std::size_t getTailLength() const;
+    
     /*************************************************************************//*!
     *
     *  @brief       Sets the center/nominal delay time.
     *
     *  @param       center The new center delay time in seconds.
     *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
     **************************************************************************/
     
     void setCenter(double center);
@@ -100,6 +148,8 @@ public:
     *
     *  @param       depth The new depth value, in seconds.
     *
+    *  @throws      std::invalid_argument if center + depth exceeds maxDelay.
+    *
     **************************************************************************/
     
     void setDepth(double depth);
@@ -158,11 +208,37 @@ private:
     /*! Feedback level, controls coloration of sound. */
     double _feedback;
     
+    /*! Processes one sample of a channel, sets length to the delay time used. */
+    double _tick(double sample, LFO& lfo, DelayLine& line, double& length);
+    
+    /*! Processes one channel in chunks of at most chunkSize samples. */
+    void _processChannel(double* block,
+                         std::size_t size,
+                         std::size_t chunkSize,
+                         LFO& lfo,
+                         DelayLine& line,
+                         double& length);
+    
+    /*! The last delay time, in samples. */
+    double _length;
+    
+    /*! The last delay time of the right channel, in samples. */
+    double _lengthRight;
+    
     /*! LFO to modulate center value. */
-    std::unique_ptr<LFO> _lfo;
+    std::unique_ptr<LFO, Arena::Deleter> _lfo;
+    
+    /*! LFO to modulate the right channel's center value. */
+    std::unique_ptr<LFO, Arena::Deleter> _lfoRight;
+    
+    /*! The maximum number of samples processed at once by processBlock() */
+    static const std::size_t _chunkSize = DelayLine::chunkSize;
     
     /*! The delay line to produce the effect. */
-    std::unique_ptr<Delay> _delay;
+    DelayLine _line;
+    
+    /*! The delay line of the right channel. */
+    DelayLine _lineRight;
 };
 
 #endif
@@ -14,20 +14,34 @@
 #define __Anthem__Reverb__
 
 #include "Units.hpp"
+#include "Delay.hpp"
+#include "DelayLine.hpp"
 
 #include <memory>
 
-class Delay;
-class AllPassDelay;
-
 /************************************************************************************************//*!
 *
 *  @brief       A reverb-effect class.
 *
-*  @details     The reverb algorithm currently implemented is the well-known and moderately
+*  @details     Two reverb algorithms are available. The first is the well-known and moderately
 *               popular Schroeder-Reverb, which is made up of four parallel comb filters/delay
 *               lines and two all-pass filters in series. It is a good first reverb effect but
-*               will definitely need re-implementation some time (soon).
+*               rather sparse and metallic.
+*
+*               The second is a feedback delay network (FDN) of eight delay lines, whose outputs
+*               are mixed by a Hadamard matrix and fed back into all lines. As the matrix is
+*               orthogonal, the network neither gains nor loses energy by itself, so the decay
+*               is entirely controlled by a gain per line, derived from the line's length and
+*               the reverb time/rate. These gains are only recomputed when the reverb time or
+*               rate actually changes. Blocks are processed in chunks shorter than the shortest
+*               line, so that each step of the network is a loop over the chunk with no
+*               dependencies between samples. The delay lines are only allocated when the FDN
+*               mode is first selected.
+*
+*               References:
+*
+*               + Jot, J.-M., Chaigne, A. (1991). Digital delay networks for designing
+*                 artificial reverberators. AES Convention 90.
 *
 *************************************************************************************************/
 
@@ -43,6 +57,13 @@ public:
         DRYWET
     };
     
+    /*! The available reverb algorithms */
+    enum Modes
+    {
+        SCHROEDER,
+        FDN
+    };
+    
     /*********************************************************************************************************//*!
     *
     *  @brief       Constructs a Reverb object.
@@ -53,17 +74,66 @@ public:
     *
     *  @param       dryWet How much of the reverberated signal should be mixed into the final signal.
     *
+    *  @param       mode The reverb algorithm, a member of the Modes enum. Defaults to SCHROEDER.
+    *
     ************************************************************************************************************/
     
-    Reverb(double reverbTime = 1, double reverbRate = 0.001, double dryWet = 0.1);
+    Reverb(double reverbTime = 1,
+           double reverbRate = 0.001,
+           double dryWet = 0.1,
+           unsigned short mode = SCHROEDER);
     
-    Reverb(const Reverb& other);
+    /*! @copydoc Delay::Delay(const Delay&, bool) */
+    Reverb(const Reverb& other, bool copySamples = true);
     
     Reverb& operator= (const Reverb& other);
     
+    /*! @copydoc EffectUnit::clone() */
+    Reverb* clone() const;
+    
     /*! @copydoc EffectUnit::process() */
     double process(double sample);
     
+    /*! @copydoc EffectUnit::processBlock() */
+    void processBlock(double* block, std::size_t size);
+    
+    /*************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place.
+    *
+    *  @details     The channels are mixed into one network, whose output is
+    *               tapped twice with uncorrelated signs for a wide, decorrelated
+    *               tail, at little more than the cost of the mono reverb.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    ****************************************************************************/
+    
+    void processStereo(double* left, double* right, std::size_t size);
+    
+    /*! Returns the length of the longest delay path of the current mode, in samples. */
+    std::size_t getTailLength() const;
+    
+    /************************************************************************************************//*!
+    *
+    *  @brief       Sets the reverb algorithm.
+    *
+    *  @details     Selecting FDN for the first time allocates its delay lines, so do not call
+    *               this on the audio thread.
+    *
+    *  @param       mode The new mode, a member of the Modes enum.
+    *
+    *************************************************************************************************/
+    
+    void setMode(unsigned short mode);
+    
+    /*! Returns the current reverb algorithm, compare with the Modes enum. */
+    unsigned short getMode() const;
+    
     /************************************************************************************************//*!
     *
     *  @brief       Sets the reverberation length/time.
@@ -124,6 +194,29 @@ public:
     
 private:
     
+    /*! The maximum number of samples processed at once by processBlock() */
+    static const std::size_t _chunkSize = 64;
+    
+    /*! The number of delay lines in the FDN */
+    static const unsigned short _fdnSize = 8;
+    
+    /*! Ticks the ModDocks and updates the parameters they control */
+    void _modulate();
+    
+    /*! Updates the decay of all delay lines after a change in reverb time or rate */
+    void _calcDecay();
+    
+    /*! Processes a chunk of at most _chunkSize samples through the comb
+        and all-pass filters, tapping the right channel if right is not null */
+    void _processSchroeder(const double* input, double* left, double* right, std::size_t size);
+    
+    /*! Processes a chunk of at most _chunkSize samples through the FDN,
+        tapping the right channel if right is not null */
+    void _processFdn(double* block, double* right, std::size_t size);
+    
+    /*! The current reverb algorithm */
+    unsigned short _mode;
+    
     /*! The input signal attenuation factor */
     double _attenuation;
     
@@ -134,10 +227,19 @@ private:
     double _reverbRate;
     
     /*! The array of delay lines */
-    std::unique_ptr<Delay[]> _delays;
+    Delay _delays [4];
+    
+    /*! The array of all-pass delays, the second pair for the right channel */
+    AllPassDelay _allPasses [4];
+    
+    /*! The FDN's delay lines, null until the FDN mode is selected */
+    std::unique_ptr<DelayLine[], Arena::Deleter> _lines;
+    
+    /*! The lengths of the FDN's delay lines, in samples */
+    DelayLine::size_t _lengths [_fdnSize];
     
-    /*! The array of all-pass delays */
-    std::unique_ptr<AllPassDelay[]> _allPasses;
+    /*! The gain per FDN delay line, applied at each pass through the line */
+    double _gains [_fdnSize];
 };
 
 #endif /* defined(__Anthem__Reverb__) */
@@ -0,0 +1,346 @@
+/*********************************************************************************************//*!
+*
+*  @file        Arena.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the Arena class, a region of memory for the units of an engine.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__Arena__
+#define __Anthem__Arena__
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*********************************************************************************************//*!
+*
+*  @brief       Hands out memory for units from a few large blocks.
+*
+*  @details     Without an Arena, every unit allocates its ModDocks, every ModDock its vectors
+*               and every delay its buffer separately, so the state the audio thread walks
+*               through each sample ends up scattered over hundreds of small heap allocations.
+*               An Arena instead cuts all of them out of one block (plus a dedicated block for
+*               anything larger than the block size), one after another in the order the units
+*               are constructed. Memory is never freed individually, only all at once when the
+*               Arena is destroyed.
+*
+*               The Arena is only used while an Arena::Scope for it is open on the constructing
+*               thread: containers using an Arena::Allocator and objects created with
+*               Arena::make() take their memory from the Arena during that time and from the
+*               heap at any other time (or when no Arena exists at all), so code allocating
+*               after setup, e.g. when switching effects, works as before. Such allocations
+*               are freed normally, memory from the Arena is simply left in place.
+*
+*               Units in an Arena must be destroyed before the Arena itself.
+*
+*************************************************************************************************/
+
+class Arena
+{
+    
+public:
+    
+    typedef std::size_t size_t;
+    
+    class Scope;
+    
+    template <typename T>
+    class Allocator;
+    
+    struct Deleter;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Constructs an Arena.
+    *
+    *  @param       blockSize The size of the first block, in bytes. Further blocks are only
+    *               allocated when it is exhausted.
+    *
+    *****************************************************************************************************/
+    
+    Arena(size_t blockSize = 1 << 20);
+    
+    /*! Frees all blocks. */
+    ~Arena();
+    
+    /*! Returns the Arena whose Scope is open on the current thread, if any. */
+    static Arena* current();
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Allocates memory from the Arena.
+    *
+    *  @param       size The number of bytes.
+    *
+    *  @param       alignment The alignment in bytes, a power of two.
+    *
+    *****************************************************************************************************/
+    
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    
+    /*! Whether or not p points into one of the Arena's blocks. */
+    bool owns(const void* p) const;
+    
+    /*! Returns the number of bytes handed out so far, including padding. */
+    size_t size() const;
+    
+    /*! Returns the number of bytes in all blocks. */
+    size_t capacity() const;
+    
+    /*! Returns the number of blocks. */
+    size_t blocks() const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Creates an object in the current Arena, or on the heap if there is none.
+    *
+    *  @details     The returned pointer destroys the object and frees its memory if it came
+    *               from the heap.
+    *
+    *  @param       args The arguments for T's constructor.
+    *
+    *****************************************************************************************************/
+    
+    template <typename T, typename... Args>
+    static std::unique_ptr<T, Deleter> make(Args&&... args);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Creates an array of default-constructed objects in the current Arena, or on
+    *               the heap if there is none.
+    *
+    *  @param       count The number of objects.
+    *
+    *****************************************************************************************************/
+    
+    template <typename T>
+    static std::unique_ptr<T[], Deleter> makeArray(size_t count);
+    
+    /*! Allocates from arena if its Scope is open, else from the heap. */
+    static void* acquire(Arena* arena, size_t size, size_t alignment);
+    
+    /*! Frees memory from acquire(), unless arena owns it. */
+    static void release(Arena* arena, void* p);
+    
+private:
+    
+    Arena(const Arena&);
+    
+    Arena& operator= (const Arena&);
+    
+    struct Block
+    {
+        char* data;
+        
+        size_t size;
+    };
+    
+    /*! Allocates a new block of at least size bytes. */
+    void _grow(size_t size);
+    
+    /*! All blocks, the last one is allocated from */
+    std::vector<Block> _blocks;
+    
+    /*! The bytes used in the last block */
+    size_t _used;
+    
+    /*! The bytes used in all blocks before the last */
+    size_t _full;
+    
+    /*! The minimum size of a block */
+    size_t _blockSize;
+    
+    /*! The Arena of the innermost open Scope on this thread */
+    static thread_local Arena* _current;
+};
+
+/*********************************************************************************************//*!
+*
+*  @brief       Makes an Arena the current one of this thread for as long as it is open.
+*
+*  @details     Scopes nest, closing one restores the Arena that was current before.
+*
+*************************************************************************************************/
+
+class Arena::Scope
+{
+    
+public:
+    
+    /*! Opens the Scope, making arena current. */
+    Scope(Arena& arena);
+    
+    /*! Closes the Scope if still open. */
+    ~Scope();
+    
+    /*! Closes the Scope before it is destroyed. */
+    void close();
+    
+private:
+    
+    Scope(const Scope&);
+    
+    Scope& operator= (const Scope&);
+    
+    /*! The Arena current before this Scope was opened */
+    Arena* _previous;
+    
+    /*! Whether or not the Scope is still open */
+    bool _open;
+};
+
+/*********************************************************************************************//*!
+*
+*  @brief       Standard allocator taking memory from an Arena.
+*
+*  @details     Uses the Arena current when the allocator (i.e. the container) is constructed,
+*               for as long as its Scope is open. Copies of a container use the Arena current
+*               when they are made, moved and swapped containers keep their allocator.
+*
+*************************************************************************************************/
+
+template <typename T>
+class Arena::Allocator
+{
+    
+public:
+    
+    typedef T value_type;
+    
+    typedef std::true_type propagate_on_container_move_assignment;
+    
+    typedef std::true_type propagate_on_container_swap;
+    
+    template <typename U>
+    struct rebind { typedef Allocator<U> other; };
+    
+    Allocator() noexcept
+    : _arena(Arena::current())
+    { }
+    
+    template <typename U>
+    Allocator(const Allocator<U>& other) noexcept
+    : _arena(other.arena())
+    { }
+    
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(Arena::acquire(_arena, n * sizeof(T), alignof(T)));
+    }
+    
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        Arena::release(_arena, p);
+    }
+    
+    Allocator select_on_container_copy_construction() const
+    {
+        return Allocator();
+    }
+    
+    /*! Returns the Arena, if any. */
+    Arena* arena() const noexcept
+    {
+        return _arena;
+    }
+    
+private:
+    
+    /*! The Arena current at construction */
+    Arena* _arena;
+};
+
+template <typename T, typename U>
+inline bool operator== (const Arena::Allocator<T>& left, const Arena::Allocator<U>& right)
+{
+    return left.arena() == right.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!= (const Arena::Allocator<T>& left, const Arena::Allocator<U>& right)
+{
+    return left.arena() != right.arena();
+}
+
+/*********************************************************************************************//*!
+*
+*  @brief       Deleter for std::unique_ptrs from Arena::make() and Arena::makeArray().
+*
+*************************************************************************************************/
+
+struct Arena::Deleter
+{
+    Deleter(Arena* a = nullptr, size_t n = 1) noexcept
+    : arena(a), count(n)
+    { }
+    
+    template <typename T>
+    void operator() (T* p) const
+    {
+        for (size_t i = count; i > 0; --i) p[i - 1].~T();
+        
+        Arena::release(arena, p);
+    }
+    
+    /*! The Arena the object was created in, if any. */
+    Arena* arena;
+    
+    /*! The number of objects. */
+    size_t count;
+};
+
+template <typename T, typename... Args>
+std::unique_ptr<T, Arena::Deleter> Arena::make(Args&&... args)
+{
+    Arena* arena = current();
+    
+    void* memory = acquire(arena, sizeof(T), alignof(T));
+    
+    try
+    {
+        T* object = new (memory) T(std::forward<Args>(args)...);
+        
+        return std::unique_ptr<T, Deleter>(object, Deleter(arena));
+    }
+    
+    catch (...)
+    {
+        release(arena, memory);
+        
+        throw;
+    }
+}
+
+template <typename T>
+std::unique_ptr<T[], Arena::Deleter> Arena::makeArray(size_t count)
+{
+    Arena* arena = current();
+    
+    T* objects = static_cast<T*>(acquire(arena, count * sizeof(T), alignof(T)));
+    
+    size_t n = 0;
+    
+    try
+    {
+        for ( ; n < count; ++n) new (objects + n) T;
+        
+        return std::unique_ptr<T[], Deleter>(objects, Deleter(arena, count));
+    }
+    
+    catch (...)
+    {
+        // Destroy what was already constructed
+        Deleter(arena, n)(objects);
+        
+        throw;
+    }
+}
+
+#endif /* defined(__Anthem__Arena__) */
@@ -0,0 +1,172 @@
+/*********************************************************************************************//*!
+*
+*  @file        AudioBuffer.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Planar stereo audio buffer.
+*
+*  @details     This file defines the AudioBuffer class, which holds a block of stereo samples
+*               with each channel stored contiguously (struct-of-arrays).
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__AudioBuffer__
+#define __Anthem__AudioBuffer__
+
+#include <cstddef>
+#include <memory>
+
+struct Sample;
+
+/*********************************************************************************************//*!
+*
+*  @brief       A block of planar (non-interleaved) stereo samples.
+*
+*  @details     Samples are processed in blocks rather than one at a time, so that the inner
+*               loops of units operate on plain contiguous arrays of doubles which the compiler
+*               can vectorize. Both channels live in one allocation and each channel is aligned
+*               to AudioBuffer::alignment bytes. Memory is only allocated when the buffer grows
+*               beyond its capacity, so a buffer sized once (e.g. when opening the audio device)
+*               can be resized freely on the audio thread. Interleaving into left/right pairs
+*               only happens once, at the device boundary, via interleave().
+*
+*************************************************************************************************/
+
+class AudioBuffer
+{
+
+public:
+
+    typedef std::size_t size_t;
+
+    /*! The two channels */
+    enum Channels { LEFT, RIGHT };
+
+    /*! Alignment of each channel, in bytes (enough for AVX). */
+    static const size_t alignment = 32;
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Constructs an AudioBuffer.
+    *
+    *  @param       size The number of frames (samples per channel), initialized to 0.
+    *
+    *************************************************************************************************/
+
+    AudioBuffer(size_t size = 0);
+
+    AudioBuffer(const AudioBuffer& other);
+
+    AudioBuffer& operator= (const AudioBuffer& other);
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Sets the number of frames in the buffer.
+    *
+    *  @details     Only allocates if size exceeds the current capacity, shrinking or growing
+    *               within the capacity is free. Newly exposed frames are not cleared.
+    *
+    *  @param       size The new number of frames.
+    *
+    *************************************************************************************************/
+
+    void resize(size_t size);
+
+    /*! Returns the number of frames. */
+    size_t size() const;
+
+    /*! Returns the number of frames that fit without re-allocating. */
+    size_t capacity() const;
+
+    /*! Returns a pointer to the samples of a channel. */
+    double* channel(unsigned short channel);
+
+    /*! Returns a const pointer to the samples of a channel. */
+    const double* channel(unsigned short channel) const;
+
+    /*! Returns a pointer to the left channel. */
+    double* left();
+
+    /*! Returns a const pointer to the left channel. */
+    const double* left() const;
+
+    /*! Returns a pointer to the right channel. */
+    double* right();
+
+    /*! Returns a const pointer to the right channel. */
+    const double* right() const;
+
+    /*! Returns a frame as Sample, for scalar code. */
+    Sample operator[] (size_t frame) const;
+
+    /*! Sets all samples to zero. */
+    void clear();
+
+    /*! Adds another buffer's samples to this buffer, frame by frame. */
+    void add(const AudioBuffer& other);
+
+    /*! Multiplies this buffer's samples by another buffer's samples, frame by frame. */
+    void multiply(const AudioBuffer& other);
+
+    /*! Multiplies both channels by an amplitude value. */
+    void gain(double amp);
+
+    /*! Multiplies the left and right channel by separate amplitude values. */
+    void pan(double left, double right);
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Multiplies both channels by linearly interpolated amplitude values.
+    *
+    *  @details     The amplitude for each channel ramps from its start value at the first frame
+    *               towards its end value, reaching it at the end of the block. This avoids the
+    *               zipper noise of stepping a gain value once per block.
+    *
+    *  @param       leftStart The left channel's amplitude at the beginning of the block.
+    *
+    *  @param       leftEnd The left channel's amplitude at the end of the block.
+    *
+    *  @param       rightStart The right channel's amplitude at the beginning of the block.
+    *
+    *  @param       rightEnd The right channel's amplitude at the end of the block.
+    *
+    *************************************************************************************************/
+
+    void panRamp(double leftStart, double leftEnd,
+                 double rightStart, double rightEnd);
+
+    /*! Copies the left channel to the right channel (mono to stereo). */
+    void upmix();
+
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Writes the buffer's frames as interleaved left/right pairs.
+    *
+    *  @param       output A pointer to at least 2 * size() doubles.
+    *
+    *************************************************************************************************/
+
+    void interleave(double* output) const;
+
+private:
+
+    /*! Allocates aligned memory for capacity frames per channel. */
+    void _allocate(size_t capacity);
+
+    /*! The number of frames */
+    size_t _size;
+
+    /*! The number of frames per channel in the allocation */
+    size_t _capacity;
+
+    /*! The aligned channel pointers into _memory */
+    double* _channels [2];
+
+    /*! The raw (unaligned) allocation */
+    std::unique_ptr<double[]> _memory;
+};
+
+#endif /* defined(__Anthem__AudioBuffer__) */
@@ -0,0 +1,55 @@
+/*********************************************************************************************//*!
+*
+*  @file        Denormals.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the DenormalGuard class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__Denormals__
+#define __Anthem__Denormals__
+
+/*********************************************************************************************//*!
+*
+*  @brief       Flushes denormal numbers to zero for as long as it lives.
+*
+*  @details     When a signal decays in a feedback path (delays, reverbs, filters or envelope
+*               tails after a note ends), its samples eventually become denormal, i.e. smaller
+*               than the smallest normal double. Most CPUs handle arithmetic on denormals in
+*               microcode, many times slower than on normal numbers, which shows up as CPU spikes
+*               exactly when notes are released.
+*
+*               A DenormalGuard sets the flush-to-zero and denormals-are-zero modes of the
+*               floating point unit of the current thread when constructed and restores the
+*               previous modes when destroyed. Construct one on the stack at the top of every
+*               function that renders audio. On platforms without such modes it does nothing, the
+*               feedback paths additionally flush their state explicitly.
+*
+*************************************************************************************************/
+
+class DenormalGuard
+{
+    
+public:
+    
+    /*! Enables flush-to-zero and denormals-are-zero modes for the current thread. */
+    DenormalGuard();
+    
+    /*! Restores the previous modes. */
+    ~DenormalGuard();
+    
+private:
+    
+    DenormalGuard(const DenormalGuard&);
+    
+    DenormalGuard& operator= (const DenormalGuard&);
+    
+    /*! The floating point control register before construction */
+    unsigned long _state;
+};
+
+#endif /* defined(__Anthem__Denormals__) */
@@ -0,0 +1,142 @@
+/*********************************************************************************************//*!
+*
+*  @file        EngineContext.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the EngineContext class, the sample-rate-dependent state of an engine.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__EngineContext__
+#define __Anthem__EngineContext__
+
+/*********************************************************************************************//*!
+*
+*  @brief       Holds everything that depends on the samplerate of one engine.
+*
+*  @details     Every Unit (and the few helpers that are not Units, such as Oscillators or
+*               OperatorBanks) takes the context current on the constructing thread when it
+*               is constructed and uses it for all samplerate-dependent calculations from then
+*               on, no matter which thread calls it later. An engine opens a Scope for its own
+*               context while constructing its units, so any number of engines with different
+*               samplerates can exist in one process and run on different threads.
+*
+*               Without an open Scope, the process-wide default context is current, which
+*               Global::init() sets up, so units constructed outside any engine work as before.
+*
+*               The tables (wavetables, pantables, the notetable) do not depend on the
+*               samplerate and are shared by all contexts. As the table increment depends on
+*               the wavetable length, contexts must be constructed after Global::init().
+*
+*************************************************************************************************/
+
+class EngineContext
+{
+    
+public:
+    
+    class Scope;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Constructs an EngineContext.
+    *
+    *  @param       samplerate The samplerate, in Hertz.
+    *
+    *  @param       tempo The tempo of the transport, in beats per minute.
+    *
+    *  @throws      std::invalid_argument if the samplerate or the tempo is zero.
+    *
+    *****************************************************************************************************/
+    
+    EngineContext(unsigned int samplerate = 48000, double tempo = 120);
+    
+    /*! Returns the context of the innermost Scope open on this thread, else the default. */
+    static EngineContext& current();
+    
+    /*! Returns the process-wide default context. */
+    static EngineContext& getDefault();
+    
+    /*! Returns the samplerate. */
+    unsigned int getSamplerate() const;
+    
+    /*! Returns the nyquist sampling limit, half the samplerate. */
+    unsigned int getNyquistLimit() const;
+    
+    /*! Returns the fundamental table increment, wavetableLength / samplerate. */
+    double getTableIncrement() const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Sets the tempo of the transport.
+    *
+    *  @details     Tempo-synced units pick up the change on their own.
+    *
+    *  @param       tempo The tempo, in beats per minute.
+    *
+    *  @throws      std::invalid_argument if the tempo is not positive.
+    *
+    *****************************************************************************************************/
+    
+    void setTempo(double tempo);
+    
+    /*! Returns the tempo of the transport, in beats per minute. */
+    double getTempo() const;
+    
+private:
+    
+    /*! The samplerate */
+    unsigned int _samplerate;
+    
+    /*! Half the samplerate */
+    unsigned int _nyquistLimit;
+    
+    /*! wavetableLength / samplerate */
+    double _tableIncrement;
+    
+    /*! The tempo in beats per minute */
+    double _tempo;
+    
+    /*! The context of the innermost open Scope on this thread */
+    static thread_local EngineContext* _current;
+};
+
+/*********************************************************************************************//*!
+*
+*  @brief       Makes an EngineContext the current one of this thread for as long as it is open.
+*
+*  @details     Scopes nest, closing one restores the context that was current before.
+*
+*************************************************************************************************/
+
+class EngineContext::Scope
+{
+    
+public:
+    
+    /*! Opens the Scope, making context current. */
+    Scope(EngineContext& context);
+    
+    /*! Closes the Scope if still open. */
+    ~Scope();
+    
+    /*! Closes the Scope before it is destroyed. */
+    void close();
+    
+private:
+    
+    Scope(const Scope&);
+    
+    Scope& operator= (const Scope&);
+    
+    /*! The context current before this Scope was opened */
+    EngineContext* _previous;
+    
+    /*! Whether or not the Scope is still open */
+    bool _open;
+};
+
+#endif /* defined(__Anthem__EngineContext__) */
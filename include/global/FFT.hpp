@@ -0,0 +1,92 @@
+/*********************************************************************************************//*!
+*
+*  @file        FFT.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the FFT class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__FFT__
+#define __Anthem__FFT__
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+/*********************************************************************************************//*!
+*
+*  @brief       Fast Fourier transform of a fixed, power-of-two size.
+*
+*  @details     An iterative radix-2 Cooley-Tukey FFT. The twiddle factors and the bit-reversal
+*               permutation are computed once at construction, so transforms never allocate
+*               and can run on the audio thread. Transforms are done in place.
+*
+*************************************************************************************************/
+
+class FFT
+{
+
+public:
+
+    typedef std::size_t size_t;
+
+    typedef std::complex<double> complex_t;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Constructs an FFT object.
+    *
+    *  @param       size The transform size, must be a power of two.
+    *
+    *  @throws      std::invalid_argument if size is not a power of two.
+    *
+    ****************************************************************************/
+
+    FFT(size_t size = 2);
+
+    /*! Returns the transform size. */
+    size_t size() const;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Transforms size() samples to the frequency domain.
+    *
+    *  @param       data The samples, replaced by their spectrum.
+    *
+    ****************************************************************************/
+
+    void forward(complex_t* data) const;
+
+    /*************************************************************************//*!
+    *
+    *  @brief       Transforms a spectrum of size() bins to the time domain.
+    *
+    *  @details     The result is scaled by 1/size(), so that inverse(forward(x))
+    *               returns x.
+    *
+    *  @param       data The spectrum, replaced by its samples.
+    *
+    ****************************************************************************/
+
+    void inverse(complex_t* data) const;
+
+private:
+
+    /*! Performs the butterflies, with conjugated twiddles for the inverse */
+    void _transform(complex_t* data, bool inverse) const;
+
+    /*! The transform size */
+    size_t _size;
+
+    /*! The bit-reversed index of every index */
+    std::vector<size_t> _reversed;
+
+    /*! The twiddle factors e^(-2*pi*i*k/size) for k < size/2 */
+    std::vector<complex_t> _twiddles;
+};
+
+#endif /* defined(__Anthem__FFT__) */
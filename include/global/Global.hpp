@@ -8,7 +8,8 @@
 *
 *  @brief       Global declarations namespace.
 *
-*  @details     This file holds global values in a namespace, such as pi or the samplerate.
+*  @details     This file holds global values in a namespace, such as pi or the wavetable
+*               length. Everything that depends on the samplerate lives in an EngineContext.
 *
 *************************************************************************************************/
 
@@ -17,6 +18,12 @@
 
 // http://goo.gl/748HMW
 
+/*! The directory the tables in rsc/ are loaded from, with a trailing slash. Relative to the
+    working directory unless absolute. Define it when compiling to load them from elsewhere. */
+#ifndef ANTHEM_RESOURCE_PATH
+#define ANTHEM_RESOURCE_PATH "../../../rsc/"
+#endif
+
 namespace Global
 {    
     /*! π */
@@ -28,23 +35,17 @@ namespace Global
     /*! Square root of two. */
     const double sqrt2 = 1.41421356237309;
     
-    /*! The samplerate used, usually 44100 Hz. */
-    extern unsigned int samplerate;
-    
-    /*! The nyquist sampling limit, half the sampling rate. */
-    extern unsigned int nyquistLimit;
-    
-    /*! The wavetable length. */
+    /*! The wavetable length, shared by all EngineContexts. */
     extern unsigned short wavetableLength;
     
-    /*! The fundamental table increment = wavetableLength/samplerate. */
-    extern double tableIncrement;
-    
     /*************************************************************************************************//*!
     *
     *  @brief       Initializes the namespace.
     *
-    *  @param       smplr The samplerate.
+    *  @details     Loads the tables shared by all engines and sets up the default EngineContext.
+    *               Call once per process, before constructing any units or EngineContexts.
+    *
+    *  @param       smplr The samplerate of the default EngineContext.
     *
     *  @param       wavetableLength The wavetable length.
     *
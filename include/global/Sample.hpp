@@ -15,11 +15,16 @@
 #ifndef __Anthem__Sample__
 #define __Anthem__Sample__
 
+#include <type_traits>
+
 /*************************************************************************************************//*!
 *
 *  @brief       Struct holding two double values for stereo audio.
 *
 *  @details     Multiplication, dvision, additon and subtraction between Samples all possible.
+*               Sample is trivially copyable, so that arrays of Samples can be copied with
+*               memcpy and kept in containers without per-element overhead. For processing
+*               blocks of audio, prefer the planar AudioBuffer.
 *
 *****************************************************************************************************/
 
@@ -33,26 +38,6 @@ struct Sample
     : left(lf), right(ri)
     { }
     
-    Sample(const Sample& other)
-    {
-        if (&other != this)
-        {
-            this->left = other.left;
-            this->right = other.right;
-        }
-    }
-    
-    Sample& operator= (const Sample& other)
-    {
-        if (this != &other)
-        {
-            left = other.left;
-            right = other.right;
-        }
-        
-        return *this;
-    }
-    
     Sample& operator*= (const Sample& other)
     {
         left *= other.left;
@@ -61,7 +46,7 @@ struct Sample
         return *this;
     }
     
-    Sample operator* (const Sample& other)
+    Sample operator* (const Sample& other) const
     {
         Sample ret(*this);
         
@@ -80,7 +65,7 @@ struct Sample
         return *this;
     }
     
-    Sample operator/ (const Sample& other)
+    Sample operator/ (const Sample& other) const
     {
         Sample ret(*this);
         
@@ -99,7 +84,7 @@ struct Sample
         return *this;
     }
     
-    Sample operator+ (const Sample& other)
+    Sample operator+ (const Sample& other) const
     {
         Sample ret(*this);
         
@@ -117,7 +102,7 @@ struct Sample
         return *this;
     }
     
-    Sample operator- (const Sample& other)
+    Sample operator- (const Sample& other) const
     {
         Sample ret(*this);
         
@@ -132,4 +117,7 @@ struct Sample
     double right;
 };
 
+static_assert(std::is_trivially_copyable<Sample>::value,
+              "Sample must be trivially copyable");
+
 #endif /* defined(__Anthem__Sample__) */
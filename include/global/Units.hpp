@@ -16,10 +16,14 @@
 #define __Anthem__Units__
 
 #include "Wavetable.hpp"
+#include "ModDock.hpp"
+#include "Arena.hpp"
+#include "EngineContext.hpp"
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
-class ModDock;
 class ModUnit;
 
 /*********************************************************************************************//*!
@@ -261,6 +265,9 @@ public:
     
     virtual bool isActive() const;
     
+    /*! Returns the EngineContext the Unit was constructed in. */
+    const EngineContext& getContext() const;
+    
 protected:
     
     /*! Whether or not the Unit is active. */
@@ -269,8 +276,11 @@ protected:
     /*! The number of docks used. */
     index_t _numDocks;
     
-    /*! The array of modulation docks. */
-    std::unique_ptr<ModDock[]> _mods;
+    /*! The modulation docks, in the current Arena if any. */
+    std::vector<ModDock, Arena::Allocator<ModDock>> _mods;
+    
+    /*! The EngineContext current at construction, copies keep their original's. */
+    EngineContext* _context;
 };
 
 /*********************************************************************************************//*!
@@ -291,6 +301,9 @@ class EffectUnit : public Unit
     
 public:
     
+    /*! The level below which output counts as silent, about -120 dB. */
+    static const double silenceThreshold;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Constructor for the EffectUnit class.
@@ -317,6 +330,90 @@ public:
     
     virtual double process(double sample) = 0;
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Processes a block of samples in place.
+    *
+    *  @details     The default implementation calls process() for every sample, effects
+    *               may override it to hoist per-sample work out of the loop.
+    *
+    *  @param       block A pointer to the samples to process.
+    *
+    *  @param       size The number of samples in the block.
+    *
+    *************************************************************************************************/
+    
+    virtual void processBlock(double* block, std::size_t size);
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place.
+    *
+    *  @details     The default implementation treats the unit as a mono insert: both channels
+    *               are mixed down, processed by processBlock() and written back to both, dry
+    *               signal included. Every effect in the tree overrides it to keep state per
+    *               channel, so only units without state of their own should rely on it.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    *************************************************************************************************/
+    
+    virtual void processStereo(double* left, double* right, std::size_t size);
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Processes a stereo block in place, unless its input and the unit's tail are
+    *               silent.
+    *
+    *  @details     While the input is silent, the unit counts the samples for which its output
+    *               stayed below silenceThreshold. Once that count exceeds getTailLength(), the
+    *               state of the unit has decayed too and processStereo() is no longer called
+    *               until the input is audible again.
+    *
+    *  @param       left A pointer to the samples of the left channel.
+    *
+    *  @param       right A pointer to the samples of the right channel.
+    *
+    *  @param       size The number of samples per channel.
+    *
+    *  @param       silent Whether the input block is silent.
+    *
+    *  @return      Whether the output block is silent.
+    *
+    *************************************************************************************************/
+    
+    bool render(double* left, double* right, std::size_t size, bool silent);
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Returns the length of the unit's tail, in samples.
+    *
+    *  @details     The number of samples the output must stay below silenceThreshold after the
+    *               input went silent before the unit's state is known to have decayed, usually
+    *               the length of its longest delay path. Defaults to 0, for units whose state
+    *               decays within a block.
+    *
+    *************************************************************************************************/
+    
+    virtual std::size_t getTailLength() const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Returns a new copy of the unit, without its signal history.
+    *
+    *  @details     The copy has the same parameters and ModDocks, but starts out silent, so delay
+    *               buffers are allocated but never copied and immutable data (wavetables, impulse
+    *               responses) is shared. Use this rather than the copy constructor to spin up
+    *               new instances from a template. The caller owns the copy.
+    *
+    *************************************************************************************************/
+    
+    virtual EffectUnit* clone() const = 0;
+    
     /*************************************************************************************************//*!
     *
     *  @brief       Sets the dry/wet parameter.
@@ -348,6 +445,9 @@ protected:
     
     /*! Dry/wet level */
     double _dw;
+    
+    /*! The number of samples the input was silent and the output below silenceThreshold */
+    std::size_t _quiet;
 };
 
 /*********************************************************************************************//*!
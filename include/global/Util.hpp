@@ -43,6 +43,12 @@ namespace Util
     
     /*! Utility function for file names. */
     extern std::string checkFileName(std::string fname, const std::string& fileEnding);
+    
+    /*! Returns 0 for values too small to be audible, which includes all denormals, else the value. */
+    inline double flushDenormal(double value)
+    {
+        return (value < 1e-15 && value > -1e-15) ? 0 : value;
+    }
 }
 
 
@@ -13,20 +13,31 @@
 #ifndef __Anthem__AudioOutput__
 #define __Anthem__AudioOutput__
 
+#include "AudioBuffer.hpp"
+
 #include <RtAudio.h>
 
+#include <atomic>
+#include <cstddef>
 #include <deque>
 #include <memory>
+#include <thread>
+#include <vector>
 
 class Anthem;
-class Sample;
+class EngineContext;
 
 /*********************************************************************************************//*!
 *
 *  @brief       Direct, real-time audio output class.
 *
 *  @details     The AudioOutput class uses the RtAudio library to direct samples computed by
-*               Anthem to the OS' audio output (DAC) to output sound in real-time.
+*               Anthem to the OS' audio output (DAC) to output sound in real-time. Samples are
+*               computed in planar blocks and only interleaved when written to the device.
+*
+*               By default, blocks are rendered synchronously in the device callback. With
+*               setRenderAhead(), a separate render thread keeps a ring buffer of blocks filled
+*               ahead of the device instead, and the callback only copies from it.
 *                                                                                                
 *************************************************************************************************/
 
@@ -40,9 +51,13 @@ public:
     /*! Struct storing information about a DAC. */
     typedef RtAudio::DeviceInfo Device;
     
-    /*! Constructs an AudioOutput object and attempts to open the default device. */
+    /*! Constructs an AudioOutput object and attempts to open the default device
+        at the samplerate of the EngineContext current at construction. */
     AudioOutput();
     
+    /*! Closes the stream and stops the render thread, if any. */
+    ~AudioOutput();
+    
     /*********************************************************************************************//*!
     *
     *  @brief       Initializes the AudioOutput object with a pointer to an Anthem object.
@@ -54,7 +69,7 @@ public:
     *
     *************************************************************************************************/
     
-    static void init(Anthem* anthem);
+    void init(Anthem* anthem);
     
     /****************************************************************************************************************************//*!
     *
@@ -117,6 +132,36 @@ public:
     /*! Returns the current API/interface used for audio output. */
      std::string getApi() const;
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Sets how many blocks are rendered ahead of the device.
+    *
+    *  @details     With render-ahead, a dedicated thread, running at real-time priority where
+    *               the OS permits it, renders blocks of the stream's frame count into a lock-free
+    *               ring buffer until it holds this many blocks, and the device callback only
+    *               copies from the ring. A block that takes too long to render thus only causes
+    *               an underrun once the ring has run dry, at the cost of up to this many blocks
+    *               of added latency. The stream is restarted if it is running.
+    *
+    *  @param       blocks The number of blocks to render ahead, 0 (the default) to render in
+    *               the device callback.
+    *
+    *************************************************************************************************/
+    
+    void setRenderAhead(unsigned int blocks);
+    
+    /*! Returns the number of blocks rendered ahead, 0 if rendering in the device callback. */
+    unsigned int getRenderAhead() const;
+    
+    /*! Returns the number of frames currently rendered ahead of the device. */
+    std::size_t getBufferedFrames() const;
+    
+    /*! Returns the number of callbacks that found fewer frames rendered ahead than needed. */
+    unsigned long getUnderruns() const;
+    
+    /*! Resets the underrun count to zero. */
+    void resetUnderruns();
+    
 private:
     
     /*! Callback function that fetches samples from Anthem. */
@@ -129,9 +174,30 @@ private:
 
     /*! Returns the name of an audio output API as string, given the enum member. */
     std::string getApiName(const RtAudio::Api& api);
+    
+    /*! Sizes the ring buffer for the render-ahead blocks. */
+    void _resizeRing();
+    
+    /*! Fills the ring buffer and launches the render thread. */
+    void _startRendering();
+    
+    /*! Stops and joins the render thread, if running. */
+    void _stopRendering();
+    
+    /*! The render thread's loop. */
+    void _render();
+    
+    /*! Renders one block into the ring buffer, returns false if it is full. */
+    bool _renderBlock();
+    
+    /*! Copies frames from the ring buffer to the device, padding with silence if short. */
+    void _copyAhead(double* output, std::size_t frames);
 
     /*! Pointer to the Anthem object to retrieve samples from. */
-    static Anthem* _anthem;
+    Anthem* _anthem;
+    
+    /*! The EngineContext whose samplerate devices are opened at. */
+    const EngineContext* _context;
 
     /*! The Device struct for the current device in use. */
     Device _device;
@@ -147,6 +213,33 @@ private:
 
     /*! The wrapped around audio api object from RtAudio. */
     RtAudio _audio;
+
+    /*! The block Anthem renders into, sized to the stream's frame count. */
+    AudioBuffer _buffer;
+    
+    /*! The stream's frame count, the size of the blocks rendered ahead. */
+    id_t _frames;
+    
+    /*! The number of blocks rendered ahead, 0 to render in the callback. */
+    unsigned int _renderAhead;
+    
+    /*! Interleaved frames rendered ahead, a whole number of blocks. */
+    std::vector<double> _ring;
+    
+    /*! The total number of frames written to the ring, by the render thread. */
+    std::atomic<std::size_t> _written;
+    
+    /*! The total number of frames read from the ring, by the callback. */
+    std::atomic<std::size_t> _read;
+    
+    /*! The number of callbacks that ran out of frames rendered ahead. */
+    std::atomic<unsigned long> _underruns;
+    
+    /*! Whether the render thread should keep rendering. */
+    std::atomic<bool> _rendering;
+    
+    /*! The render thread. */
+    std::thread _renderThread;
 };
 
 #endif /* defined(__Anthem__AudioOutput__) */
@@ -0,0 +1,253 @@
+/*********************************************************************************************//*!
+*
+*  @file        BatchRenderer.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the BatchRenderer class, for offline rendering of many jobs at once.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__BatchRenderer__
+#define __Anthem__BatchRenderer__
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Anthem;
+
+/*********************************************************************************************//*!
+*
+*  @brief       Renders a batch of (patch, note list or MIDI file) jobs to wavefiles on a pool
+*               of threads.
+*
+*  @details     Every job gets its own Anthem instance, constructed on the worker thread that
+*               renders it with its own EngineContext and without any devices, so jobs share
+*               nothing but the wavetables, which Global::init() loads once for the whole
+*               process before the batch starts. Jobs are taken from a shared queue by a fixed
+*               number of worker threads and rendered as fast as possible, block by block,
+*               streaming each block to the job's wavefile with a WavefileWriter.
+*
+*               A job's events come either from a note list or from a Standard MIDI File, which
+*               is streamed with a MidiFile while rendering rather than read up front. Of a MIDI
+*               file's events, notes on all channels are played, tempo changes set the job's
+*               tempo and some controllers are mapped to the patch: 7 (volume) to the master
+*               amplitude, 10 (pan) to the panning value and 16-19 (general purpose 1-4) to
+*               macros A-D. All other controllers are ignored.
+*
+*               A job that fails (e.g. because of an invalid patch parameter or an unwritable
+*               output file) is reported in its Stats and does not affect the others.
+*
+*************************************************************************************************/
+
+class BatchRenderer
+{
+    
+public:
+    
+    typedef std::size_t size_t;
+    
+    /*! Configures a freshly constructed Anthem, on the worker thread. */
+    typedef std::function<void(Anthem&)> patch_t;
+    
+    /*! A note-on or note-off at a time in seconds from the start of the job. */
+    struct Event
+    {
+        double time;
+        
+        unsigned char note;
+        
+        bool on;
+    };
+    
+    /*! A job, one wavefile. */
+    struct Job
+    {
+        Job();
+        
+        /*! The name shown in reports, the output path if empty. */
+        std::string name;
+        
+        /*! The path of the wavefile to write. */
+        std::string output;
+        
+        /*! The patch, may be empty to render the default patch. */
+        patch_t patch;
+        
+        /*! The notes, in any order. */
+        std::vector<Event> events;
+        
+        /*! A Standard MIDI File to play instead of the notes, if not empty. */
+        std::string midi;
+        
+        /*! The samplerate to render at, 48000 by default. */
+        unsigned int samplerate;
+        
+        /*! The seconds rendered after the last event, 1 by default. */
+        double tail;
+    };
+    
+    /*! The outcome and timing of a job. */
+    struct Stats
+    {
+        Stats();
+        
+        std::string name;
+        
+        /*! The number of frames rendered. */
+        size_t frames;
+        
+        /*! The length of the rendered audio, in seconds. */
+        double audioSeconds;
+        
+        /*! The time spent rendering, in seconds. */
+        double renderSeconds;
+        
+        /*! The error message if the job failed, else empty. */
+        std::string error;
+        
+        /*! Returns how many times faster than real time the job rendered. */
+        double speed() const;
+    };
+    
+    /*! The statistics of a whole batch. */
+    struct Report
+    {
+        Report();
+        
+        /*! The jobs' statistics, in the order of the jobs. */
+        std::vector<Stats> jobs;
+        
+        /*! The number of jobs that failed. */
+        size_t failed;
+        
+        /*! The length of all rendered audio, in seconds. */
+        double audioSeconds;
+        
+        /*! The wall-clock time of the whole batch, in seconds. */
+        double wallSeconds;
+        
+        /*! Returns the seconds of audio rendered per second of wall-clock time. */
+        double speed() const;
+    };
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Constructs a BatchRenderer.
+    *
+    *  @param       threads The number of worker threads, or 0 for one per hardware thread.
+    *
+    *  @param       blockSize The number of frames rendered at once.
+    *
+    *  @throws      std::invalid_argument if blockSize is zero.
+    *
+    *****************************************************************************************************/
+    
+    BatchRenderer(unsigned int threads = 0, size_t blockSize = 512);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Renders all jobs and returns once all are done.
+    *
+    *  @details     Global::init() must have been called before.
+    *
+    *****************************************************************************************************/
+    
+    Report render(const std::vector<Job>& jobs) const;
+    
+    /*! Renders a single job on the calling thread. */
+    Stats render(const Job& job) const;
+    
+    /*! Returns the number of worker threads. */
+    unsigned int threads() const;
+    
+    /*! Returns the number of frames rendered at once. */
+    size_t blockSize() const;
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Reads a manifest of jobs.
+    *
+    *  @details     One job per line, empty lines and lines starting with '#' are ignored:
+    *
+    *               output-wavefile patch-file notes-file [samplerate] [tail]
+    *
+    *               Use - as the patch file for the default patch. A notes file ending in .mid or
+    *               .midi is played as a Standard MIDI File. Relative paths are relative to the
+    *               manifest's directory. The patch and notes files are read right away, MIDI
+    *               files only when the job is rendered.
+    *
+    *  @throws      FileOpenError if a file cannot be opened.
+    *
+    *  @throws      ParseError if a line is malformed.
+    *
+    *  @see         loadPatch(), loadNotes()
+    *
+    *****************************************************************************************************/
+    
+    static std::vector<Job> loadManifest(const std::string& fname);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Reads a patch file.
+    *
+    *  @details     One parameter per line, applied in order, empty lines and lines starting with
+    *               '#' are ignored. Operators and units are given as A-D, values as numbers:
+    *
+    *               + algorithm n
+    *               + operator X active 0|1
+    *               + operator X wavetable id
+    *               + operator X level value (0-10 in FM mode, 0-1 in additive mode, so set
+    *                 the algorithm first)
+    *               + operator X ratio value
+    *               + operator X offset Hz
+    *               + operator X semitones value
+    *               + noise active 0|1
+    *               + noise color id
+    *               + noise amp value
+    *               + noise seed n
+    *               + master value
+    *               + pan value
+    *               + tempo bpm
+    *
+    *               Values are only range-checked when the patch is applied to an Anthem, which
+    *               throws if one is invalid.
+    *
+    *  @throws      FileOpenError if the file cannot be opened.
+    *
+    *  @throws      ParseError if a line is malformed.
+    *
+    *****************************************************************************************************/
+    
+    static patch_t loadPatch(const std::string& fname);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Reads a notes file.
+    *
+    *  @details     One event per line, empty lines and lines starting with '#' are ignored:
+    *
+    *               seconds note on|off
+    *
+    *  @throws      FileOpenError if the file cannot be opened.
+    *
+    *  @throws      ParseError if a line is malformed.
+    *
+    *****************************************************************************************************/
+    
+    static std::vector<Event> loadNotes(const std::string& fname);
+    
+private:
+    
+    /*! The number of worker threads */
+    unsigned int _threads;
+    
+    /*! The number of frames rendered at once */
+    size_t _blockSize;
+};
+
+#endif /* defined(__Anthem__BatchRenderer__) */
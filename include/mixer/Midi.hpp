@@ -125,7 +125,7 @@ private:
                           void* userData);
     
     /*! The pointer to an Anthem object to send note-on/off signals to. */
-    static Anthem* _anthem;
+    Anthem* _anthem;
     
     /*! The wrapped around midi api object from RtMidi. */
     RtMidiIn _midi;
@@ -0,0 +1,205 @@
+/*********************************************************************************************//*!
+*
+*  @file        MidiFile.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the MidiFile class, a streaming Standard MIDI File reader.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__MidiFile__
+#define __Anthem__MidiFile__
+
+#include <cstddef>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*********************************************************************************************//*!
+*
+*  @brief       Reads the events of a Standard MIDI File (format 0 or 1) one at a time.
+*
+*  @details     The events of all tracks are merged in time order and converted from ticks to
+*               seconds and sample frames, following the tempo map (the tempo meta events in
+*               any track) as it goes. Only note-on, note-off, control change and tempo events
+*               are returned, everything else (other channel messages, system exclusive and
+*               other meta events) is skipped.
+*
+*               Nothing but the chunk positions is read up front: every track keeps a small
+*               read buffer and its decoding state, and next() decodes one event after the
+*               other from whichever track is due, so memory use does not depend on the length
+*               of the file.
+*
+*************************************************************************************************/
+
+class MidiFile
+{
+    
+public:
+    
+    typedef uint64_t frame_t;
+    
+    typedef unsigned char byte_t;
+    
+    enum Type { NOTE_ON, NOTE_OFF, CONTROL_CHANGE, TEMPO };
+    
+    /*! An event, timestamped in seconds and frames from the start of the file. */
+    struct Event
+    {
+        Type type;
+        
+        /*! The sample frame, the time times the samplerate, rounded. */
+        frame_t frame;
+        
+        /*! The time in seconds. */
+        double time;
+        
+        /*! The MIDI channel, 0-15. */
+        byte_t channel;
+        
+        /*! The note or controller number. */
+        byte_t number;
+        
+        /*! The velocity or controller value, 0 for note-offs without velocity. */
+        byte_t value;
+        
+        /*! The tempo in beats per minute, for TEMPO events. */
+        double tempo;
+    };
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Opens a MIDI file and reads its header and chunk positions.
+    *
+    *  @param       fname The path to the file.
+    *
+    *  @param       samplerate The samplerate to convert times to frames with.
+    *
+    *  @throws      FileOpenError if the file cannot be opened.
+    *
+    *  @throws      ParseError if the file is not a format 0 or 1 MIDI file.
+    *
+    *  @throws      std::invalid_argument if the samplerate is zero.
+    *
+    *****************************************************************************************************/
+    
+    MidiFile(const std::string& fname, unsigned int samplerate);
+    
+    /*************************************************************************************************//*!
+    *
+    *  @brief       Reads the next event in time order.
+    *
+    *  @details     Note-ons with a velocity of zero are returned as note-offs. Events at the
+    *               same tick are returned in track order, so tempo changes in the first track
+    *               come before the notes they apply to.
+    *
+    *  @param       event Receives the event.
+    *
+    *  @return      False once all tracks are exhausted, else true.
+    *
+    *  @throws      ParseError if a track is malformed.
+    *
+    *****************************************************************************************************/
+    
+    bool next(Event& event);
+    
+    /*! Starts reading from the beginning again. */
+    void rewind();
+    
+    /*! Returns the file format, 0 or 1. */
+    unsigned short getFormat() const;
+    
+    /*! Returns the number of tracks. */
+    std::size_t getTrackCount() const;
+    
+    /*! Returns the division field of the header: ticks per quarter note or SMPTE timing. */
+    uint16_t getDivision() const;
+    
+    /*! Returns the samplerate frames are computed for. */
+    unsigned int getSamplerate() const;
+    
+private:
+    
+    MidiFile(const MidiFile&);
+    
+    MidiFile& operator= (const MidiFile&);
+    
+    /*! The bytes read from the file at once, per track */
+    static const std::size_t _bufferSize = 4096;
+    
+    /*! The position and decoding state of a track */
+    struct Track
+    {
+        /*! The next file position to buffer */
+        std::streamoff position;
+        
+        /*! The file position where the track ends */
+        std::streamoff end;
+        
+        /*! The buffered bytes */
+        std::vector<char> buffer;
+        
+        /*! The next byte in the buffer */
+        std::size_t index;
+        
+        /*! The absolute tick of the next event */
+        uint64_t tick;
+        
+        /*! The running status */
+        byte_t status;
+        
+        /*! Whether the end of the track was reached */
+        bool done;
+    };
+    
+    /*! Returns the next byte of a track, buffering if necessary */
+    byte_t _read(Track& track);
+    
+    /*! Reads a variable-length quantity */
+    uint32_t _readVariable(Track& track);
+    
+    /*! Skips bytes of a track */
+    void _skip(Track& track, uint32_t count);
+    
+    /*! Reads the delta time of the next event of a track, or marks it done */
+    void _advance(Track& track);
+    
+    /*! Converts a tick to seconds, the tick must not lie before the last one */
+    double _toSeconds(uint64_t tick);
+    
+    /*! The file */
+    std::ifstream _file;
+    
+    /*! The name of the file, for error messages */
+    std::string _fname;
+    
+    /*! The file positions of the tracks' data */
+    std::vector<std::pair<std::streamoff, std::streamoff>> _chunks;
+    
+    /*! The tracks */
+    std::vector<Track> _tracks;
+    
+    /*! The format, 0 or 1 */
+    unsigned short _format;
+    
+    /*! The division field of the header */
+    uint16_t _division;
+    
+    /*! The samplerate */
+    unsigned int _samplerate;
+    
+    /*! The tick of the last tempo change */
+    uint64_t _tempoTick;
+    
+    /*! The time of the last tempo change, in seconds */
+    double _tempoTime;
+    
+    /*! The current length of a tick, in seconds */
+    double _secondsPerTick;
+};
+
+#endif /* defined(__Anthem__MidiFile__) */
@@ -16,8 +16,8 @@
 #include "Units.hpp"
 #include "Wavefile.hpp"
 
+class AudioBuffer;
 class CrossfadeUnit;
-class Sample;
 
 /*********************************************************************************************//*!
 *
@@ -25,7 +25,9 @@ class Sample;
 *
 *  @details     The Mixer class is the last unit samples go to before audio output. Samples
 *               are attenuated with a master amplitude as well as panning values. Additionally
-*               the mixer can record samples for wavefile output.
+*               the mixer can record samples for wavefile output. The Mixer works on whole
+*               blocks: its ModDocks are ticked once per block and the resulting gains are
+*               ramped across the block from the previous block's values.
 *                                                                                                
 *************************************************************************************************/
 
@@ -57,15 +59,17 @@ public:
     
     /*********************************************************************************************//*!
     *
-    *  @brief       Processes a sample.
+    *  @brief       Processes a block.
     *
-    *  @param       sample The sample to process. You can pass a double (converted implicitly).
+    *  @param       buffer The stereo AudioBuffer to process in place, ready for audio output
+    *               afterwards.
     *
-    *  @return      A Sample object ready for audio output.
+    *  @param       silent Whether the buffer is silent (all zeros), in which case only the
+    *               panning and amplitude are updated and the buffer is recorded if necessary.
     *
     *************************************************************************************************/
     
-    Sample process(Sample sample);
+    void process(AudioBuffer& buffer, bool silent = false);
     
     /*********************************************************************************************//*!
     *
@@ -172,11 +176,17 @@ private:
     /*! The current master amplitude value */
     double _masterAmp;
     
+    /*! The left channel's gain at the end of the last block */
+    double _gainLeft;
+    
+    /*! The right channel's gain at the end of the last block */
+    double _gainRight;
+    
     /*! Whether or not the mixer is currently recording */
     bool _recording;
     
     /*! CrossfadeUnit for panning */
-    std::unique_ptr<CrossfadeUnit> _pan;
+    std::unique_ptr<CrossfadeUnit, Arena::Deleter> _pan;
     
     /*! Wavefile object to record */
     Wavefile _wavefile;
@@ -16,9 +16,11 @@
 #include <fstream>
 #include <string>
 #include <deque>
-#include <memory>
+#include <vector>
 
-class Sample;
+#include "Sample.hpp"
+
+class AudioBuffer;
 
 /*********************************************************************************************//*!
 *
@@ -35,7 +37,10 @@ public:
     *
     *  @brief       Constructs a Wavefile object.
     *
-    *  @param       fname The name of the wavefile.
+    *  @details     The file gets the samplerate of the EngineContext current at construction.
+    *
+    *  @param       fname The name of the wavefile. If empty, a file named after the current
+    *               date is created when the samples are first written.
     *
     *  @param       channels The number of channels for the wavefile, defaults to stereo (2).
     *
@@ -88,6 +93,16 @@ public:
     
     void process(const Sample& sample);
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Pushes all frames of a block into the wavefile's sample buffer.
+    *
+    *  @param       buffer The AudioBuffer holding the block.
+    *
+    *************************************************************************************************/
+    
+    void process(const AudioBuffer& buffer);
+    
     /*********************************************************************************************//*!
     *
     *  @brief       Writes a sample buffer to a wavefile.
@@ -110,6 +125,29 @@ public:
     
     void flush();
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Reads the samples of a wavefile from disk.
+    *
+    *  @details     Supports 8, 16, 24 and 32 bit integer PCM as well as 32 and 64 bit floating
+    *               point data. Multi-channel files are mixed down to mono. No resampling is done,
+    *               the file's samplerate is returned via the samplerate parameter instead.
+    *
+    *  @param       fname The path to the wavefile.
+    *
+    *  @param       samplerate If not null, receives the file's samplerate.
+    *
+    *  @return      The samples, between -1 and 1.
+    *
+    *  @throws      FileOpenError if the file cannot be opened.
+    *
+    *  @throws      ParseError if the file is not a supported wavefile.
+    *
+    *************************************************************************************************/
+    
+    static std::vector<double> load(const std::string& fname,
+                                    unsigned int* samplerate = nullptr);
+    
 private:
     
     /*! Wavefile header */
@@ -144,7 +182,7 @@ private:
     } _header;
     
     /*! The sample buffer */
-    std::deque<std::unique_ptr<Sample>> _buffer;
+    std::deque<Sample> _buffer;
     
     /*! The file name */
     std::string _fname;
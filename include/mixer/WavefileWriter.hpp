@@ -0,0 +1,111 @@
+/*********************************************************************************************//*!
+*
+*  @file        WavefileWriter.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Defines the WavefileWriter class.
+*
+*************************************************************************************************/
+
+#ifndef __Anthem__WavefileWriter__
+#define __Anthem__WavefileWriter__
+
+#include <cstddef>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class AudioBuffer;
+
+/*********************************************************************************************//*!
+*
+*  @brief       Streams blocks to a 16 bit stereo wavefile as they are rendered.
+*
+*  @details     Unlike Wavefile, which collects all samples of a recording in memory and
+*               writes them at the end, a WavefileWriter converts and writes every block right
+*               away, so memory use does not grow with the length of the file. The header is
+*               written with placeholder sizes first and completed by close(). The path is used
+*               as given, samples outside [-1, 1] are clipped.
+*
+*************************************************************************************************/
+
+class WavefileWriter
+{
+    
+public:
+    
+    typedef std::size_t size_t;
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Creates a wavefile and writes its header.
+    *
+    *  @param       path The path of the file, overwritten if it exists.
+    *
+    *  @param       samplerate The samplerate of the file.
+    *
+    *  @throws      std::runtime_error if the file cannot be created.
+    *
+    *************************************************************************************************/
+    
+    WavefileWriter(const std::string& path, unsigned int samplerate);
+    
+    /*! Closes the file if still open, ignoring errors. */
+    ~WavefileWriter();
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Appends the frames of a block to the file.
+    *
+    *  @throws      std::runtime_error if writing fails or the file exceeds 4 GB.
+    *
+    *************************************************************************************************/
+    
+    void write(const AudioBuffer& buffer);
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Completes the header with the final sizes and closes the file.
+    *
+    *  @throws      std::runtime_error if writing fails.
+    *
+    *************************************************************************************************/
+    
+    void close();
+    
+    /*! Returns the number of frames written so far. */
+    size_t frames() const;
+    
+    /*! Returns the path of the file. */
+    const std::string& path() const;
+    
+private:
+    
+    WavefileWriter(const WavefileWriter&);
+    
+    WavefileWriter& operator= (const WavefileWriter&);
+    
+    /*! Writes the header with the current sizes at the beginning of the file. */
+    void _writeHeader();
+    
+    /*! The path of the file */
+    std::string _path;
+    
+    /*! The samplerate */
+    unsigned int _samplerate;
+    
+    /*! The number of frames written */
+    size_t _frames;
+    
+    /*! Interleaved 16 bit samples of the current block */
+    std::vector<int16_t> _block;
+    
+    /*! The file */
+    std::ofstream _file;
+};
+
+#endif /* defined(__Anthem__WavefileWriter__) */
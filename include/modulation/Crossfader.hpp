@@ -201,6 +201,17 @@ public:
     /*! @copydoc ModUnit::modulate() */
     double modulate(double sample, double depth, double maximum);
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Ticks the VALUE ModDock, if in use, without ticking the two ModUnits.
+    *
+    *  @details     Updates left() and right() for users that evaluate the units themselves.
+    *               modulate() calls this once per call.
+    *
+    *************************************************************************************************/
+    
+    void modulateValue();
+    
     /*********************************************************************************************//*!
     *
     *  @brief       Sets the left ModUnit.
@@ -92,6 +92,52 @@ public:
                     double depth,
                     double maximum);
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Renders a block of envelope levels.
+    *
+    *  @details     Equivalent to calling update() after each sample of the envelope, but whole
+    *               runs within a segment are generated at once and segment changes, loop jumps
+    *               and the sustain are only checked at the segment boundaries. The levels are
+    *               those before the depth and amplitude are applied by modulate(). To release
+    *               the note in the middle of a block, render the block up to the note-off
+    *               offset, call noteOff() and render the rest.
+    *
+    *  @param       block A pointer to write the levels to.
+    *
+    *  @param       size The number of samples to render.
+    *
+    *************************************************************************************************/
+    
+    void renderBlock(double* block, EnvelopeSegment::length_t size);
+    
+    /*! The maximum number of levels render() renders at once. */
+    static const EnvelopeSegment::length_t blockSize = 64;
+    
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Renders the next levels ahead, for modulate() to return.
+    *
+    *  @details     Renders size levels with renderBlock() into the Envelope's own block, which
+    *               modulate() then reads and update() steps through, one level per sample,
+    *               instead of ticking the segments. Once the block is used up, or after
+    *               noteOff() or reset(), the Envelope is ticked per sample again. Since the
+    *               levels are rendered ahead, render no further than the next note-off.
+    *
+    *  @param       size The number of levels to render, at most blockSize.
+    *
+    *  @throws      std::invalid_argument if size is greater than blockSize.
+    *
+    *************************************************************************************************/
+    
+    void render(EnvelopeSegment::length_t size);
+    
+    /*! @copydoc EnvelopeSegmentSequence::update() */
+    void update();
+    
+    /*! @copydoc EnvelopeSegmentSequence::reset() */
+    void reset();
+    
     /*****************************************************************************************//*!
     *
     *  @brief       Sets the level of a segment.
@@ -271,6 +317,15 @@ private:
     
     /*! Whether or not to return the last tick forever after SEG_C finished */
     bool _sustainEnabled;
+    
+    /*! The levels rendered ahead by render() */
+    double _block [blockSize];
+    
+    /*! The next level in _block */
+    EnvelopeSegment::length_t _position;
+    
+    /*! The number of levels in _block */
+    EnvelopeSegment::length_t _blockLength;
 };
 
 #endif /* defined(__Anthem__Envelope__) */
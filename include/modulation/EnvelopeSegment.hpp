@@ -14,6 +14,8 @@
 #define __Anthem__EnvelopeSegment__
 
 #include "Units.hpp"
+#include <atomic>
+#include <cstddef>
 #include <vector>
 
 /******************************************************************************//*!
@@ -25,6 +27,14 @@
  *              decrement either exponentially, logarithmically or linearly in
  *              case of being a decay, an attack or a release segment.
  *
+ *              The shape of a segment is the power function x^rate over the segment.
+ *              Rather than calling std::pow() every sample, the curve is sampled into a
+ *              small table whenever the rate is set and linearly interpolated while
+ *              ticking, with the position into the table advancing by a constant
+ *              increment. Only the first few table steps, where radical curves are too
+ *              steep to interpolate, and rates modulated by a ModDock are still
+ *              computed with std::pow().
+ *
  *********************************************************************************/
 
 class EnvelopeSegment : public GenUnit
@@ -63,6 +73,10 @@ public:
            length_t len = 0,
            double rate = 1);
     
+    EnvelopeSegment(const EnvelopeSegment& other);
+    
+    EnvelopeSegment& operator= (const EnvelopeSegment& other);
+    
     /******************************************************************//*!
      *
      *  @brief      Ticks the current envelope value
@@ -86,6 +100,22 @@ public:
     
     void update();
     
+    /*************************************************************************//*!
+    *
+    *  @brief       Ticks and updates the segment for a whole block.
+    *
+    *  @details     Equivalent to calling tick() and update() once per sample,
+    *               but without any per-sample modulation checks when no
+    *               ModDock is in use.
+    *
+    *  @param       block A pointer to write the envelope values to.
+    *
+    *  @param       size The number of samples to generate.
+    *
+    ****************************************************************************/
+    
+    void generate(double* block, length_t size);
+    
     /**********************************************************************//*!
      *
      *  @brief      Sets the length of the segment
@@ -235,9 +265,34 @@ private:
     /*! Calculates the increment for _curr and assigns it to _incr */
     void _calculateIncr();
     
+    /*! Samples the curve for the current rate into _shape */
+    void _calculateShape();
+    
+    /*! Writes a sampled curve and the rate it was sampled for to _shape, see _shapeSequence */
+    void _publishShape(const double* values, double rate);
+    
+    /*! Returns _curr raised to the rate, from _shape if possible */
+    double _shapeValue() const;
+    
+    /*! The number of steps in the shape table */
+    static const std::size_t _shapeSize;
+    
+    /*! The positions below which the shape is computed exactly */
+    static const double _shapeExact;
+    
     /*! The rate determining the type (lin,log,exp) */
     double _rate;
     
+    /*! Odd while _shape and _shapeRate are being written. The audio thread reads them
+        between two loads of the same even value, else it computes the value exactly */
+    std::atomic<unsigned long> _shapeSequence;
+    
+    /*! The rate _shape was sampled for, -1 for none */
+    std::atomic<double> _shapeRate;
+    
+    /*! The curve sampled at _shapeSize + 1 points, allocated for the segment's lifetime */
+    std::vector<std::atomic<double>, Arena::Allocator<std::atomic<double>>> _shape;
+    
     /*! Starting amplitude */
     double _startLevel;
     
@@ -308,6 +363,20 @@ public:
     
     virtual void update();
     
+    /******************************************************************************//*!
+    *
+    *  @brief      Advances the sequence by a number of samples.
+    *
+    *  @details    Equivalent to calling tick() and update() once per sample without
+    *              computing the values, so that segments change and loops restart
+    *              at exactly the sample they would when ticked every sample.
+    *
+    *  @param      samples The number of samples to advance by.
+    *
+    *********************************************************************************/
+    
+    void advance(unsigned long samples);
+    
     /******************************************************************************//*!
     *
     *  @brief      Sets the rate of a segment.
@@ -510,7 +579,9 @@ public:
     
 protected:
     
-    typedef std::vector<EnvelopeSegment>::iterator segmentItr;
+    typedef std::vector<EnvelopeSegment, Arena::Allocator<EnvelopeSegment>> segmentVec;
+    
+    typedef segmentVec::iterator segmentItr;
     
     /*! Changes the current segment in the sequence */
     virtual void _changeSegment(segmentItr segment);
@@ -518,6 +589,9 @@ protected:
     /*! Executes various steps to reset a loop (go from end back to start) */
     virtual void _resetLoop();
     
+    /*! Moves on to the next segment (or back to the loop start) once the current one is over */
+    void _checkSegment();
+    
     /*! The number of samples passed since starting the current segment */
     unsigned long _currSample;
     
@@ -543,7 +617,7 @@ protected:
     bool _loopInf;
     
     /*! The segment sequence */
-    std::vector<EnvelopeSegment> _segments;
+    segmentVec _segments;
 };
 
 
@@ -779,7 +853,7 @@ public:
 protected:
     
     /*! Sets the ModDock base value for a segment. */
-    void setSegmentModDockBaseValue(segment_t segmentNum, index_t dockNum, double value);
+    virtual void setSegmentModDockBaseValue(segment_t segmentNum, index_t dockNum, double value);
     
     /*! Returns the ModDock base value for a segment. */
     double getSegmentModDockBaseValue(segment_t segmentNum, index_t dockNum) const;
@@ -131,6 +131,15 @@ public:
 *               that sets the rate or frequency of the entire Envelopeelope sequence. Internally, changing
 *               this "rate" is equivalent to appropriately adjusting the length of each EnvelopeSegment.
 *
+*               As long as nothing but the segments' own LFOs modulate the sequence and those complete
+*               a whole number of cycles per sequence cycle, the output repeats every cycle. It is then
+*               baked into a table of values per segment, which is replayed by linear
+*               interpolation instead of ticking the segments and their LFOs, so a long sequence costs
+*               about as much as a plain LFO. The table is baked again whenever a parameter changes,
+*               a few values per call to modulate() while the sequence keeps ticking live, so that no
+*               single call does all of the work. The table is resized when segments are added or
+*               removed, never while modulating.
+*
 ********************************************************************************************************/
 
 class LFOSequence : public ModEnvelopeSegmentSequence
@@ -332,7 +341,7 @@ public:
     *
     *****************************************************************************************************/
     
-    std::shared_ptr<Wavetable> getModWavetable(segment_t seg) const;
+    std::shared_ptr<const Wavetable> getModWavetable(segment_t seg) const;
     
     /****************************************************************************************************//*!
     *
@@ -414,6 +423,33 @@ public:
     
     double getScaledModFreqValue(double freq) const;
     
+    /*! @copydoc EnvelopeSegmentSequence::setSegmentStartLevel() */
+    void setSegmentStartLevel(segment_t seg, double lv);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setSegmentEndLevel() */
+    void setSegmentEndLevel(segment_t seg, double lv);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setLinkedLevel() */
+    void setLinkedLevel(segment_t seg, double lv);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setLoopStart() */
+    void setLoopStart(segment_t seg);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setLoopEnd() */
+    void setLoopEnd(segment_t seg);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setLoopMax() */
+    void setLoopMax(unsigned short n);
+    
+    /*! @copydoc EnvelopeSegmentSequence::setLoopInf() */
+    void setLoopInf(bool state = true);
+    
+    /*! @copydoc EnvelopeSegmentSequence::reset() */
+    void reset();
+    
+    /*! Whether the output is currently replayed from the baked table. */
+    bool isBaked() const;
+    
     /*! @copydoc EnvelopeSegmentSequence::update() */
     void update();
     
@@ -450,6 +486,11 @@ public:
     /*! @copydoc ModEnvelopeSegmentSequence::dockSize_Segment() */
     unsigned long dockSize_Segment(segment_t segNum, index_t dockNum) const;
     
+protected:
+    
+    /*! @copydoc ModEnvelopeSegmentSequence::setSegmentModDockBaseValue() */
+    void setSegmentModDockBaseValue(segment_t segNum, index_t dockNum, double value);
+    
 private:
     
     struct LFOSequence_LFO
@@ -465,8 +506,10 @@ private:
         double freq;
     };
     
+    typedef std::vector<LFOSequence_LFO, Arena::Allocator<LFOSequence_LFO>> lfoVec;
+    
     /*! Vector of above Mod structs */
-    std::vector<LFOSequence_LFO> _lfos;
+    lfoVec _lfos;
     
     /*! Calls getScaledModFreqValue() for seg */
     void _setScaledModFreq(segment_t seg);
@@ -475,11 +518,56 @@ private:
         to the sequence's rate parameter */
     void _resizeSegmentsFromRate(double rate);
     
+    /*! Whether the output repeats every cycle and can be baked */
+    bool _isBakeable() const;
+    
+    /*! Catches up with the segments' LFOs and marks _baked as out of date */
+    void _unbake();
+    
+    /*! Bakes the next _bakeChunk values of one cycle into _baked, if possible */
+    void _bake();
+    
+    /*! Sizes _baked for the current number of segments */
+    void _resizeBaked();
+    
+    /*! Returns the current value from _baked */
+    double _replay();
+    
+    /*! Computes a segment's value at a position (0-1), with its LFO a number of samples from now */
+    double _evaluate(segment_t seg, double position, double offset) const;
+    
+    /*! The number of values baked per segment */
+    static const unsigned short _bakePoints;
+    
+    /*! The positions below which radical segments are computed exactly */
+    static const double _bakeExact;
+    
+    /*! The maximum number of values baked per call to _bake() */
+    static const unsigned short _bakeChunk;
+    
     /*! The current rate of the sequence */
     double _rate;
     
     /*! Length of the segments */
     unsigned long _segLen;
+    
+    /*! One cycle of output, bakePoints + 1 values per segment */
+    std::vector<double, Arena::Allocator<double>> _baked;
+    
+    /*! Whether the output is replayed from _baked */
+    bool _isBaked;
+    
+    /*! Whether a parameter changed since baking started */
+    bool _bakeDirty;
+    
+    /*! Whether the sequence could be baked when baking started */
+    bool _bakeable;
+    
+    /*! The index in _baked of the next value to bake */
+    unsigned long _bakeNext;
+    
+    /*! The number of samples the segments' LFOs have not been updated for while baked */
+    unsigned long _bakedSamples;
 };
 
 class Crossfader;
@@ -493,6 +581,11 @@ class Crossfader;
 *               Sequenceuencer mode. In both cases, the user can then crossfade between the two respective
 *               units, e.g. between LFO A and LFO B.
 *
+*               The crossfaded output is evaluated at a control rate, once every few samples, and linearly
+*               interpolated into a block that every ModDock the LFOUnit is attached to reads from, so that
+*               the units are not ticked once per sample per ModDock. A unit the crossfader is turned fully
+*               away from is not evaluated at all. The rate of each unit can also be synced to the tempo.
+*
 ********************************************************************************************************/
 
 class LFOUnit : public ModUnit
@@ -603,16 +696,69 @@ public:
     
     Crossfader& fader();
     
+    /****************************************************************************************************//*!
+    *
+    *  @brief       Sets the control rate.
+    *
+    *  @details     Allocates memory, so do not call this on the audio thread.
+    *
+    *  @param       samples The number of samples between two evaluations of the units,
+    *               between 1 and maxControlRate.
+    *
+    *  @throws      std::invalid_argument if samples is out of range.
+    *
+    ********************************************************************************************************/
+    
+    void setControlRate(unsigned short samples);
+    
+    /*! Returns the number of samples between two evaluations of the units. */
+    unsigned short getControlRate() const;
+    
+    /****************************************************************************************************//*!
+    *
+    *  @brief       Syncs the rate of a unit to the tempo.
+    *
+    *  @details     Sets both the LFO's frequency and the LFOSequence's rate of the unit to one
+    *               cycle per the given number of beats at the tempo of the unit's EngineContext,
+    *               and follows changes of the tempo.
+    *
+    *  @param       unit The unit number, LFOUnit::A or ::B.
+    *
+    *  @param       beats The length of a cycle in beats, e.g. 0.25 for sixteenth notes,
+    *               or 0 to stop syncing.
+    *
+    *  @throws      std::invalid_argument if beats is negative.
+    *
+    ********************************************************************************************************/
+    
+    void setSyncBeats(bool unit, double beats);
+    
+    /*! Returns the length of a unit's cycle in beats, 0 if the unit is not synced. */
+    double getSyncBeats(bool unit) const;
+    
     /*! @copydoc GenUnit::update() */
     void update();
     
     /*! @copydoc ModUnit::modulate() */
     double modulate(double sample, double depth, double maximum);
     
+    /*! The maximum control rate, in samples */
+    static const unsigned short maxControlRate;
+    
 private:
     
+    /*! Advances the units by a control period and interpolates the block towards their new value */
+    void _render();
+    
+    /*! Returns the crossfaded value of the units */
+    double _evaluate();
+    
+    /*! Sets the synced units' rates from the tempo */
+    void _sync();
+    
+    
     /*! The Crossfader that fades between the A and B units */
-    std::unique_ptr<Crossfader> _fader;
+    std::unique_ptr<Crossfader, Arena::Deleter> _fader;
     
     /*! The step sequencer lfos, activated with setMode() and Modes::SEQ_MODE */
     LFOSequence _lfoSequences [2];
@@ -621,6 +767,27 @@ private:
     LFO _lfos [2];
     
     Mode _mode;
+    
+    /*! The interpolated output for the current control period */
+    std::vector<double, Arena::Allocator<double>> _block;
+    
+    /*! The position in _block */
+    unsigned short _position;
+    
+    /*! The crossfaded value at the end of the last control period */
+    double _last;
+    
+    /*! Whether _last holds a value yet */
+    bool _primed;
+    
+    /*! How much of the input sample LFOs pass through, which depends on the crossfade */
+    double _gain;
+    
+    /*! The length of each unit's cycle in beats, 0 if not synced */
+    double _syncBeats [2];
+    
+    /*! The tempo the synced units' rates were last set for */
+    double _syncTempo;
 };
 
 #endif /* defined(__Anthem__LFO__) */
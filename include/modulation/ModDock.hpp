@@ -13,6 +13,9 @@
 #ifndef __Anthem__ModDock__
 #define __Anthem__ModDock__
 
+#include "Arena.hpp"
+
+#include <cstddef>
 #include <vector>
 
 class ModUnit;
@@ -36,7 +39,9 @@ public:
     *
     *  @brief       Constructs a ModDock without any initial settings.
     *
-    *  @details     Values must be initialized through appropriate methods thereafter.
+    *  @details     Values must be initialized through appropriate methods thereafter. When
+    *               constructed inside an Arena::Scope, space for a few ModUnits is reserved in
+    *               the Arena.
     *
     *************************************************************************************************/
     
@@ -178,7 +183,7 @@ public:
     *
     *************************************************************************************************/
     
-    double getDepth(index_t index);
+    double getDepth(index_t index) const;
     
     /*********************************************************************************************//*!
     *
@@ -297,13 +302,15 @@ private:
     
     struct ModItem;
     
-    typedef std::vector<ModItem> modVec;
+    // All vectors take their memory from the Arena current
+    // at construction, if any (see ModDock())
+    typedef std::vector<ModItem, Arena::Allocator<ModItem>> modVec;
     
     // Not using iterators because they're invalidated when
     // pushing back/erasing from _modItems and not using
     // pointers to ModItems because then it's difficult
     // to interact with _modItems
-    typedef std::vector<modVec::size_type> indexVec;
+    typedef std::vector<modVec::size_type, Arena::Allocator<modVec::size_type>> indexVec;
     
     typedef indexVec::iterator indexVecItr;
     
@@ -350,6 +357,9 @@ private:
     
     /*! Higher boundary value to scale to when modulation trespasses it */
     double _higherBoundary;
+    
+    /*! The number of ModItems reserved in an Arena */
+    static const std::size_t _reserved;
 };
 
 #endif /* defined(__Anthem__ModDock__) */
@@ -8,6 +8,11 @@
 *
 *  @brief       The LookupTable template class declaration and definition.
 *
+*  @details     Also defines the interpolation policies for LookupTables. A policy is a struct
+*               with a static interpolate() function template, taking a pointer to the table's
+*               data, its size and a fractional index. Since the policy is a template parameter,
+*               every lookup is resolved at compile time and can be inlined into the caller.
+*
 *************************************************************************************************/
 
 #ifndef LOOKUP_TABLE_HPP
@@ -17,12 +22,143 @@
 #include <string>
 #include <vector>
 
-template <typename T>
+/*! Returns the value at the truncated index. */
+struct NoInterpolation
+{
+    template <typename T>
+    static inline T interpolate(const T* data, std::size_t, double index)
+    {
+        return data[static_cast<long>(index)];
+    }
+};
+
+/*! Interpolates linearly between the two nearest values, index must be less than size - 1. */
+struct LinearInterpolation
+{
+    template <typename T>
+    static inline T interpolate(const T* data, std::size_t, double index)
+    {
+        // The truncated integral part
+        long integral = static_cast<long>(index);
+        
+        // The remaining fractional part
+        double fractional = index - integral;
+        
+        // Grab the two items in-between which the actual value lies
+        T lower = data[integral];
+        T upper = data[integral+1];
+        
+        // Perform interpolation
+        return lower + ((upper - lower) * fractional);
+    }
+};
+
+/*! Edge policy for the four-point interpolations: the outer values are clamped at the ends. */
+struct ClampedEdges
+{
+    /*! Returns the indices of the values before integral and two after it. */
+    static inline void taps(std::size_t size, std::size_t integral, std::size_t& before, std::size_t& after)
+    {
+        before = integral ? integral - 1 : 0;
+        
+        after = (integral + 2 < size) ? integral + 2 : size - 1;
+    }
+};
+
+/*! Edge policy for periodic tables whose last value is a guard equal to the first, like every
+    Wavetable. The outer values wrap around, skipping the guard. */
+struct PeriodicEdges
+{
+    /*! Returns the indices of the values before integral and two after it. */
+    static inline void taps(std::size_t size, std::size_t integral, std::size_t& before, std::size_t& after)
+    {
+        before = integral ? integral - 1 : size - 2;
+        
+        after = (integral + 2 < size) ? integral + 2 : integral + 3 - size;
+    }
+};
+
+/*! Interpolates with a cubic Hermite (Catmull-Rom) spline through the four nearest
+    values, index must be less than size - 1. Edges is ClampedEdges or PeriodicEdges. */
+template <typename Edges = ClampedEdges>
+struct HermiteInterpolation
+{
+    template <typename T>
+    static inline T interpolate(const T* data, std::size_t size, double index)
+    {
+        const std::size_t integral = static_cast<std::size_t>(index);
+        
+        const double t = index - integral;
+        
+        std::size_t before, after;
+        
+        Edges::taps(size, integral, before, after);
+        
+        const T a = data[before];
+        const T b = data[integral];
+        const T c = data[integral + 1];
+        const T d = data[after];
+        
+        const T c1 = (c - a) * 0.5;
+        const T c2 = a - b * 2.5 + c * 2 - d * 0.5;
+        const T c3 = (d - a) * 0.5 + (b - c) * 1.5;
+        
+        return ((c3 * t + c2) * t + c1) * t + b;
+    }
+};
+
+/*! Interpolates with the 4-point Lagrange polynomial through the four nearest
+    values, index must be less than size - 1. Edges is ClampedEdges or PeriodicEdges. */
+template <typename Edges = ClampedEdges>
+struct LagrangeInterpolation
+{
+    template <typename T>
+    static inline T interpolate(const T* data, std::size_t size, double index)
+    {
+        const std::size_t integral = static_cast<std::size_t>(index);
+        
+        const double t = index - integral;
+        
+        std::size_t before, after;
+        
+        Edges::taps(size, integral, before, after);
+        
+        const T a = data[before];
+        const T b = data[integral];
+        const T c = data[integral + 1];
+        const T d = data[after];
+        
+        // The basis polynomials for the points at -1, 0, 1 and 2
+        const double ta = t + 1;
+        const double tc = t - 1;
+        const double td = t - 2;
+        
+        return a * (-t * tc * td / 6) +
+               b * (ta * tc * td / 2) +
+               c * (-ta * t * td / 2) +
+               d * (ta * t * tc / 6);
+    }
+};
+
+/*********************************************************************************************//*!
+*
+*  @brief       A table of values to look up and interpolate between.
+*
+*  @details     Nothing is virtual, so lookups inline into the caller. The interpolation policy
+*               given as the second template parameter is the default for interpolate(), but
+*               any other policy can be passed per call, e.g.
+*               interpolate<HermiteInterpolation<PeriodicEdges>>() for a Wavetable.
+*
+*************************************************************************************************/
+
+template <typename T, typename Interpolation = LinearInterpolation>
 class LookupTable
 {
     
 public:
     
+    typedef T value_t;
+    
     LookupTable(T* data,
                 std::size_t size,
                 const std::string& id) noexcept
@@ -39,7 +175,7 @@ public:
     : _id(std::move(other._id)),
       _data(std::move(other._data))
     { }
-
+    
     LookupTable& operator= (LookupTable other) noexcept
     {
         swap(other);
@@ -47,10 +183,7 @@ public:
         return *this;
     }
     
-    virtual ~LookupTable() = default;
-    
-    
-    virtual inline void swap(LookupTable& other)
+    void swap(LookupTable& other)
     {
         // Enable ADL
         using std::swap;
@@ -60,66 +193,86 @@ public:
         swap(_id, other._id);
     }
     
-    friend inline void swap(const LookupTable& left,
-                            const LookupTable& right)
+    friend inline void swap(LookupTable& left,
+                            LookupTable& right)
     {
         left.swap(right);
     }
-
+    
     
     /************************************************************************//*!
     *
     *  @brief       Interpolates values from a fractional index.
     *
-    *  @details     This function returns a proportionate value 
+    *  @details     This function returns a proportionate value
     *               from a fractional index. For example, passing
-    *               it an index of 1.5 will return [1] + (([2] - [1]) * 0.5).
+    *               it an index of 1.5 will return [1] + (([2] - [1]) * 0.5)
+    *               with linear interpolation.
+    *
+    *  @tparam      Policy The interpolation policy, defaults to the table's.
     *
     *  @param       index The fractional index.
     *
     ***************************************************************************/
     
-    virtual T interpolate(double index) const
+    template <typename Policy = Interpolation>
+    inline T interpolate(double index) const
     {
-        // The truncated integral part
-        long integral = static_cast<long>(index);
+        return Policy::interpolate(_data.data(), _data.size(), index);
+    }
+    
+    /************************************************************************//*!
+    *
+    *  @brief       Interpolates a block of values from fractional indices.
+    *
+    *  @tparam      Policy The interpolation policy, defaults to the table's.
+    *
+    *  @param       indices The fractional indices.
+    *
+    *  @param       output The array to write the values to.
+    *
+    *  @param       size The number of indices.
+    *
+    ***************************************************************************/
+    
+    template <typename Policy = Interpolation>
+    void interpolate(const double* indices, T* output, std::size_t size) const
+    {
+        const T* data = _data.data();
         
-        // The remaining fractional part
-        double fractional = index - integral;
+        const std::size_t length = _data.size();
         
-        // Grab the two items in-between which the actual value lies
-        T lower = _data[integral];
-        T upper = _data[integral+1];
-    
-        // Perform interpolation
-        return lower + ((upper - lower) * fractional);
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            output[n] = Policy::interpolate(data, length, indices[n]);
+        }
     }
     
-    virtual inline const T& operator[] (std::size_t index) const
+    inline const T& operator[] (std::size_t index) const
     {
         return _data[index];
     }
     
     /*! Returns a const LookupTable's data pointer. */
-    virtual inline const T* data() const
+    inline const T* data() const
     {
         return _data.data();
     }
     
     /*! Returns the LookupTable's data pointer. */
-    virtual inline T* data()
+    inline T* data()
     {
         return _data.data();
     }
     
     /*! Returns the LookupTable's size. */
-    virtual inline std::size_t size() const
+    inline std::size_t size() const
     {
         return _data.size();
     }
     
     /*! Returns the LookupTable's id. */
-    virtual inline std::string id() const
+    inline const std::string& id() const
     {
         return _id;
     }
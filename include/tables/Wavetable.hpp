@@ -19,10 +19,13 @@
 #include "Util.hpp"
 #include "Global.hpp"
 
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
-#include <memory>
 
 /*****************************************************************************//*!
 *
@@ -127,8 +130,9 @@ struct Partial
 *  @details     This is the main class in Anthem for storing and looking up values from waveforms
 *               (e.g. sine, saw, square wave). A wavetable can be constructed either by passing
 *               it a pointer to waveform values directly or through Additive Synthesis, in
-*               combination with the Partial struct. The Wavetable class implements reference
-*               counting.
+*               combination with the Partial struct. Wavetables are immutable once constructed;
+*               Oscillators refer to them by id through the WavetableDatabase, so copying an
+*               Oscillator never copies its table.
 *
 *************************************************************************************************/
 
@@ -232,9 +236,9 @@ public:
             // initial phase
             phase[p] = begin->phaseOffset;
             
-            // tableIncrement is two π / tablelength,
+            // The fundamental increment is two π / tablelength,
             // multiplying by number changes the frequency
-            increment[p] = Global::tableIncrement * begin->number;
+            increment[p] = (Global::twoPi / length) * begin->number;
             
             // reduce amplitude if necessary
             amplitude[p] = begin->amp * master;
@@ -347,6 +351,17 @@ private:
 *  @details     The WavetableDatabase class manages all of Anthem's wavetables
 *               and is responsible for providing Oscillators with Wavetables.
 *
+*               Wavetables can be replaced while the audio thread is running (e.g. when
+*               a table is edited live). The audio thread reads them through get(), an
+*               atomic pointer load that never touches a reference count, while holding
+*               a ReadGuard. replace() publishes the new table with an atomic pointer
+*               swap and retires the old one in the current epoch, then starts a new
+*               epoch. Every ReadGuard records the epoch it was created in, in a slot of
+*               its own, and collect() frees a retired table once no live ReadGuard was
+*               created in or before its epoch, i.e. always on a non-real-time thread.
+*               Overlapping readers thus never hold back tables retired before they
+*               were created.
+*
 *************************************************************************************************/
 
 class WavetableDatabase
@@ -354,6 +369,40 @@ class WavetableDatabase
     
 public:
     
+    /*********************************************************************************************//*!
+    *
+    *  @brief       Marks the current thread as reading wavetables for as long as it lives.
+    *
+    *  @details     Construct one on the stack at the top of every function that renders
+    *               audio, alongside the DenormalGuard. Pointers returned by get() must not be
+    *               kept beyond the guard's lifetime. Claims one of maxReaders slots with an
+    *               atomic compare-and-swap and never blocks.
+    *
+    *************************************************************************************************/
+    
+    class ReadGuard
+    {
+        
+    public:
+        
+        /*! @throws std::runtime_error if maxReaders ReadGuards are alive already. */
+        ReadGuard(WavetableDatabase& database);
+        
+        ~ReadGuard();
+        
+    private:
+        
+        ReadGuard(const ReadGuard&);
+        
+        ReadGuard& operator= (const ReadGuard&);
+        
+        /*! The database being read */
+        WavetableDatabase& _database;
+        
+        /*! The slot claimed in the database */
+        unsigned short _slot;
+    };
+    
     enum Wavetables
     {
         SINE,
@@ -398,6 +447,9 @@ public:
     
     typedef unsigned short index_t;
     
+    /*! The maximum number of ReadGuards alive at once, across all threads. */
+    static const index_t maxReaders = 256;
+    
     /*********************************************************************************************//*!
     *
     *  @brief       Initialzes the WavetableDatabase.
@@ -407,11 +459,62 @@ public:
     *
     *************************************************************************************************/
     
+    WavetableDatabase();
+    
     void init();
     
-    std::shared_ptr<Wavetable>& operator[] (index_t wavetable);
+    /*************************************************************************//*!
+    *
+    *   @brief Returns a wavetable, safe to call on the audio thread.
+    *
+    *   @details The pointer is only valid for the lifetime of the
+    *            current ReadGuard.
+    *
+    *   @param wavetable The wavetable id.
+    *
+    ****************************************************************************/
     
-    const std::shared_ptr<Wavetable>& operator[] (index_t wavetable) const;
+    const Wavetable* get(index_t wavetable) const
+    {
+        return _current[wavetable].load();
+    }
+    
+    /*! Returns a wavetable, sharing ownership. Never call this on the audio thread. */
+    std::shared_ptr<const Wavetable> operator[] (index_t wavetable) const;
+    
+    /*************************************************************************//*!
+    *
+    *   @brief Replaces a wavetable while the audio thread may be reading it.
+    *
+    *   @details Publishes the new table atomically and retires the old one,
+    *            then calls collect(). Allocates memory and may free retired
+    *            tables, so never call this on the audio thread.
+    *
+    *   @param wavetable The id of the wavetable to replace.
+    *
+    *   @param table The new wavetable.
+    *
+    *   @throws std::out_of_range if there is no wavetable with the id.
+    *
+    *   @throws std::invalid_argument if table is null.
+    *
+    ****************************************************************************/
+    
+    void replace(index_t wavetable, std::shared_ptr<const Wavetable> table);
+    
+    /*************************************************************************//*!
+    *
+    *   @brief Frees retired wavetables no reader can still be using.
+    *
+    *   @details Never call this on the audio thread. Tables retired while
+    *            a ReadGuard is alive are freed by the first call after that
+    *            guard was destroyed, whatever guards were created since, so
+    *            call this periodically (e.g. from a UI timer) after replacing
+    *            tables.
+    *
+    ****************************************************************************/
+    
+    void collect();
     
     /*************************************************************************//*!
     *
@@ -444,8 +547,25 @@ private:
     
     double* _readWavetable(const std::string& name) const;
     
-    /*! Vector of Wavetable objects */
-    std::vector<std::shared_ptr<Wavetable>> _tables;
+    typedef std::pair<unsigned long, std::shared_ptr<const Wavetable>> retired_t;
+    
+    /*! The published wavetables, read by the audio thread */
+    std::unique_ptr<std::atomic<const Wavetable*>[]> _current;
+    
+    /*! Vector of Wavetable objects, owning the published wavetables */
+    std::vector<std::shared_ptr<const Wavetable>> _tables;
+    
+    /*! Replaced wavetables, with the epoch they were retired in */
+    std::vector<retired_t> _retired;
+    
+    /*! Guards _tables and _retired, never locked by the audio thread */
+    mutable std::mutex _mutex;
+    
+    /*! The epoch each live ReadGuard was created in, 0 for free slots */
+    std::atomic<unsigned long> _readers [maxReaders];
+    
+    /*! The current epoch, advanced by every replace() */
+    std::atomic<unsigned long> _epoch;
 };
 
 extern WavetableDatabase wavetableDatabase;
@@ -30,11 +30,11 @@ int main(int argc, const char * argv[])
     anthem.setNote(69, true);
     
 
-    anthem.audio.start();
+    anthem.audio->start();
     
     anthem.mixer.startRecording();
     
-    const unsigned long len = Global::samplerate * 3;
+    const unsigned long len = anthem.getContext().getSamplerate() * 3;
     
     while (anthem.getSampleCount() < len);
     
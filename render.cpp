@@ -0,0 +1,69 @@
+#include "Global.hpp"
+#include "BatchRenderer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+int main(int argc, const char * argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::fprintf(stderr, "Usage: %s manifest [threads] [block size]\n", argv[0]);
+        
+        return 2;
+    }
+    
+    // The wavetables are loaded once and shared by all jobs
+    Global::init();
+    
+    try
+    {
+        const unsigned int threads = (argc > 2) ? std::atoi(argv[2]) : 0;
+        
+        const unsigned int blockSize = (argc > 3) ? std::atoi(argv[3]) : 512;
+        
+        BatchRenderer renderer(threads, blockSize);
+        
+        std::vector<BatchRenderer::Job> jobs = BatchRenderer::loadManifest(argv[1]);
+        
+        std::printf("Rendering %lu jobs on %u threads\n",
+                    static_cast<unsigned long>(jobs.size()),
+                    renderer.threads());
+        
+        BatchRenderer::Report report = renderer.render(jobs);
+        
+        for (std::vector<BatchRenderer::Stats>::const_iterator itr = report.jobs.begin(), end = report.jobs.end();
+             itr != end;
+             ++itr)
+        {
+            if (itr->error.empty())
+            {
+                std::printf("%-40s %10lu frames %8.2f s in %8.3f s %8.1fx real time\n",
+                            itr->name.c_str(),
+                            static_cast<unsigned long>(itr->frames),
+                            itr->audioSeconds,
+                            itr->renderSeconds,
+                            itr->speed());
+            }
+            
+            else std::printf("%-40s FAILED: %s\n", itr->name.c_str(), itr->error.c_str());
+        }
+        
+        std::printf("\n%lu jobs, %lu failed, %.2f s of audio in %.3f s, %.1fx real time\n",
+                    static_cast<unsigned long>(report.jobs.size()),
+                    static_cast<unsigned long>(report.failed),
+                    report.audioSeconds,
+                    report.wallSeconds,
+                    report.speed());
+        
+        return report.failed ? 1 : 0;
+    }
+    
+    catch(std::exception& error)
+    {
+        std::fprintf(stderr, "%s\n", error.what());
+        
+        return 2;
+    }
+}
@@ -10,17 +10,52 @@
 
 #include "Anthem.hpp"
 
-Anthem::Anthem()
-: fm(&operators[A],
+#include <algorithm>
+
+// The default patch takes about 250 KB
+const std::size_t Anthem::_arenaSize = 1 << 20;
+
+Anthem::Anthem(const EngineContext& context, bool devices)
+: _context(context),
+  _contextScope(_context),
+  _arena(_arenaSize),
+  _scope(_arena),
+  fm(&operators[A],
      &operators[B],
      &operators[C],
      &operators[D]),
-  active_(false),
-  count_(0)
+  _active(false),
+  _count(0)
 {
-    midi.init(this);
+    for (unsigned short i = A; i <= D; ++i)
+    {
+        operators[i].bind(bank, bank.slot(i, 0));
+    }
+    
+    // The default order of the inserts
+    for (unsigned short i = A; i <= B; ++i)
+    {
+        chain.addUnit(&filters[i]);
+        
+        chain.addUnit(&effects[i]);
+    }
+    
+    // Anything allocated from here on comes from the heap
+    _scope.close();
+    
+    if (devices)
+    {
+        midi.reset(new Midi);
+        
+        // Opens the device at this instance's samplerate
+        audio.reset(new AudioOutput);
+        
+        midi->init(this);
+        
+        audio->init(this);
+    }
     
-    audio.init(this);
+    _contextScope.close();
 }
 
 
@@ -33,7 +68,7 @@ void Anthem::setNote(note_t note, bool on)
             operators[i].setNote(note);
         }
         
-        active_ = true;
+        _active = true;
     }
     
     else
@@ -51,57 +86,131 @@ void Anthem::setNote(note_t note, bool on)
             }
         }
         
-        active_ = false;
+        _active = false;
     }
 }
 
 Anthem::count_t Anthem::getSampleCount() const
 {
-    return count_;
+    return _count;
 }
 
 double Anthem::getPassedTime() const
 {
-    return static_cast<double>(count_) / Global::samplerate;
+    return static_cast<double>(_count) / _context.getSamplerate();
 }
 
-Sample Anthem::tick_()
+const Arena& Anthem::getArena() const
 {
-    ++count_;
+    return _arena;
+}
+
+EngineContext& Anthem::getContext()
+{
+    return _context;
+}
+
+void Anthem::process(AudioBuffer& buffer)
+{
+    DenormalGuard guard;
     
-    double tick = fm.tick();
+    WavetableDatabase::ReadGuard tables(wavetableDatabase);
     
-    if (noise.isActive())
-    {
-        tick += noise.tick();
-    }
+    double* left = buffer.left();
     
-    for (unsigned short i = A; i <= B; ++i)
+    double* right = buffer.right();
+    
+    const bool idle = fm.isSilent();
+    
+    // Whether every sub-block came out silent
+    bool silent = true;
+    
+    // The effects tick their ModDocks per block, so run them on short
+    // sub-blocks, interleaved with the sources that modulate them
+    for (AudioBuffer::size_t offset = 0, end = buffer.size(); offset < end; offset += Envelope::blockSize)
     {
-        if (filters[i].isActive())
+        const AudioBuffer::size_t size = std::min<AudioBuffer::size_t>(Envelope::blockSize, end - offset);
+        
+        double* samples = left + offset;
+        
+        // The sources report whether their block is silent
+        bool quiet = true;
+        
+        if (noise.isActive())
         {
-            tick = filters[i].process(tick);
+            quiet = noise.generate(samples, size);
         }
         
-        if (effects[i].isActive())
+        else std::fill(samples, samples + size, 0.0);
+        
+        if (idle) _count += size;
+        
+        else
+        {
+            quiet = false;
+            
+            // Envelopes render their levels a block ahead. Notes only
+            // change between calls, so no block reaches past a note-off
+            if (_active)
+            {
+                for (unsigned short i = A; i <= D; ++i)
+                {
+                    if (envelopes[i].isActive()) envelopes[i].render(size);
+                }
+            }
+            
+            for (AudioBuffer::size_t n = 0; n < size; ++n)
+            {
+                samples[n] += _tick();
+                
+                _update();
+            }
+        }
+        
+        std::copy(samples, samples + size, right + offset);
+        
+        // Effects whose input and tail are silent are skipped
+        quiet = chain.process(samples, right + offset, size, quiet);
+        
+        if (quiet)
         {
-            tick = effects[i].process(tick);
+            std::fill(samples, samples + size, 0.0);
+            
+            std::fill(right + offset, right + offset + size, 0.0);
         }
+        
+        else silent = false;
     }
     
-    return mixer.process(tick);
+    mixer.process(buffer, silent);
 }
 
-void Anthem::update_()
+double Anthem::_tick()
 {
+    ++_count;
+    
+    // The bank is ticked directly, so apply level modulation
+    // like the Operators' own tick() would have
+    for (unsigned short i = A; i <= D; ++i)
+    {
+        if (operators[i].isActive()) operators[i].modulateLevel();
+    }
+    
+    double sample;
+    
+    fm.tick(bank, &sample);
+    
+    return sample;
+}
+
+void Anthem::_update()
+{
+    // Inactive operators have a gate of zero
+    bank.update();
+    
     for(unsigned short unit = A; unit <= D; ++unit)
     {
-        if (operators[unit].isActive())
-        {
-            operators[unit].update();
-        }
-        
-        if (active_)
+        if (_active)
         {
             if (lfos[unit].isActive())
             {
@@ -114,9 +223,4 @@ void Anthem::update_()
             }
         }
     }
-    
-    if (noise.isActive())
-    {
-        noise.update();
-    }
 }
\ No newline at end of file
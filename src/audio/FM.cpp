@@ -10,7 +10,9 @@
 
 #include "FM.hpp"
 #include "Operator.hpp"
+#include "OperatorBank.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 FM::FM(Operator* a,
@@ -91,6 +93,16 @@ unsigned short FM::getAlgorithm() const
     return _alg;
 }
 
+bool FM::isSilent() const
+{
+    for (index_t i = A; i <= D; ++i)
+    {
+        if (_operators[i]->isActive() && _operators[i]->hasNote()) return false;
+    }
+    
+    return true;
+}
+
 double FM::_tickIfActive(index_t index)
 {
     return (_operators[index]->isActive()) ? _operators[index]->tick() : 0;
@@ -168,3 +180,154 @@ double FM::tick()
             return _add(D, _add(C, _add(B, aTick)));
     }
 }
+
+void FM::tick(OperatorBank& bank, double* output) const
+{
+    // Sets are processed in chunks so that the
+    // temporaries stay on the stack and in cache
+    static const OperatorBank::size_t chunk = 64;
+    
+    const OperatorBank::size_t sets = bank.sets();
+    
+    double first [chunk];
+    double second [chunk];
+    
+    for (OperatorBank::size_t set = 0; set < sets; set += chunk)
+    {
+        const OperatorBank::size_t count = std::min(chunk, sets - set);
+        
+        // Slots of the Operators A-D in this chunk
+        const OperatorBank::size_t a = set;
+        const OperatorBank::size_t b = a + sets;
+        const OperatorBank::size_t c = b + sets;
+        const OperatorBank::size_t d = c + sets;
+        
+        double* out = output + set;
+        
+        bank.tick(a, count, out);
+        
+        switch (_alg)
+        {
+            case 0:
+                bank.modulate(b, count, out);
+                bank.modulate(c, count, out);
+                bank.modulate(d, count, out);
+                break;
+            
+            case 1:
+                bank.add(b, count, out);
+                bank.modulate(c, count, out);
+                bank.modulate(d, count, out);
+                break;
+            
+            case 2:
+                bank.modulate(b, count, out);
+                bank.add(c, count, out);
+                bank.modulate(d, count, out);
+                break;
+            
+            case 3:
+            {
+                std::copy(out, out + count, first);
+                
+                bank.modulate(b, count, out);
+                bank.modulate(c, count, first);
+                
+                for (OperatorBank::size_t n = 0; n < count; ++n) out[n] += first[n];
+                
+                bank.modulate(d, count, out);
+                
+                break;
+            }
+            
+            case 4:
+            {
+                bank.modulate(b, count, out);
+                
+                std::copy(out, out + count, first);
+                
+                bank.modulate(d, count, out);
+                bank.modulate(c, count, first);
+                
+                for (OperatorBank::size_t n = 0; n < count; ++n) out[n] += first[n];
+                
+                break;
+            }
+            
+            case 5:
+                bank.modulate(b, count, out);
+                bank.modulate(c, count, out);
+                bank.add(d, count, out);
+                break;
+            
+            case 6:
+            {
+                bank.tick(b, count, first);
+                
+                for (OperatorBank::size_t n = 0; n < count; ++n) out[n] += first[n];
+                
+                bank.add(c, count, out);
+                bank.modulate(d, count, out);
+                
+                break;
+            }
+            
+            case 7:
+            {
+                bank.tick(b, count, first);
+                
+                bank.modulate(c, count, out);
+                bank.modulate(d, count, first);
+                
+                for (OperatorBank::size_t n = 0; n < count; ++n) out[n] += first[n];
+                
+                break;
+            }
+            
+            case 8:
+            {
+                std::copy(out, out + count, first);
+                std::copy(out, out + count, second);
+                
+                bank.modulate(d, count, out);
+                bank.modulate(c, count, first);
+                bank.modulate(b, count, second);
+                
+                // Summed in the same order as in tick()
+                for (OperatorBank::size_t n = 0; n < count; ++n)
+                {
+                    out[n] = out[n] + first[n] + second[n];
+                }
+                
+                break;
+            }
+            
+            case 9:
+                bank.modulate(b, count, out);
+                bank.add(c, count, out);
+                bank.add(d, count, out);
+                break;
+            
+            case 10:
+            {
+                std::copy(out, out + count, first);
+                
+                bank.modulate(c, count, out);
+                bank.modulate(b, count, first);
+                
+                for (OperatorBank::size_t n = 0; n < count; ++n) out[n] += first[n];
+                
+                bank.add(d, count, out);
+                
+                break;
+            }
+            
+            case 11:
+            default:
+                bank.add(b, count, out);
+                bank.add(c, count, out);
+                bank.add(d, count, out);
+                break;
+        }
+    }
+}
@@ -9,18 +9,15 @@
 ************************************************************************************************/
 
 #include "Noise.hpp"
-#include "Filter.hpp"
 #include "ModDock.hpp"
 
-#include <ctime>
+#include <algorithm>
 #include <stdexcept>
 
-Noise::Noise(unsigned short color, double amp)
-: GenUnit(1,amp), _filter(new Filter(Filter::LOW_PASS,1,0.1)),
-  _dist(-1,1)
+Noise::Noise(unsigned short color, double amp, std::uint64_t seed)
+: GenUnit(1,amp), _rval(0), _lastAmp(amp)
 {
-    // Seed random number generator
-    _rgen.seed((unsigned)time(0));
+    setSeed(seed);
     
     setColor(color);
     
@@ -31,12 +28,15 @@ Noise::Noise(unsigned short color, double amp)
 
 Noise::Noise(const Noise& other)
 : GenUnit(other),
-  _dist(other._dist), _color(other._color),
-  _filter(new Filter(*other._filter)),
-  _rval(other._rval)
+  _color(other._color),
+  _rval(other._rval),
+  _seed(other._seed),
+  _counter(other._counter),
+  _red(other._red),
+  _last(other._last),
+  _lastAmp(other._lastAmp)
 {
-    // Seed random number generator
-    _rgen.seed((unsigned)time(0));
+    std::copy(other._pink, other._pink + 3, _pink);
 }
 
 Noise& Noise::operator= (const Noise& other)
@@ -45,15 +45,21 @@ Noise& Noise::operator= (const Noise& other)
     {
         GenUnit::operator=(other);
         
-        _dist = other._dist;
-        
         _color = other._color;
         
-        _rgen = other._rgen;
-        
         _rval = other._rval;
         
-        *_filter = *other._filter;
+        _seed = other._seed;
+        
+        _counter = other._counter;
+        
+        std::copy(other._pink, other._pink + 3, _pink);
+        
+        _red = other._red;
+        
+        _last = other._last;
+        
+        _lastAmp = other._lastAmp;
     }
     
     return *this;
@@ -78,81 +84,173 @@ double Noise::getAmp() const
     else return _amp;
 }
 
+void Noise::setSeed(std::uint64_t seed)
+{
+    _seed = seed;
+    
+    _counter = 0;
+}
+
+std::uint64_t Noise::getSeed() const
+{
+    return _seed;
+}
+
 void Noise::setColor(unsigned short color)
 {
     // Check if color argument is out of range
     if (color > VIOLET)
     { throw std::invalid_argument("Invalid noise color!"); }
     
-    // Adjust filter settings according to noise color
-    // Values determined empirically
-    switch (color)
+    // Reset filter state, the old color's
+    // state is meaningless for the new one
+    _pink[0] = _pink[1] = _pink[2] = 0;
+    
+    _red = _last = 0;
+    
+    _color = color;
+}
+
+unsigned short Noise::getColor() const
+{
+    return _color;
+}
+
+void Noise::_white(double* block, std::size_t size)
+{
+    // Each value is a hash (the SplitMix64 finalizer) of the seed and
+    // the value's position in the stream, so no value depends on the
+    // previous one and the loop can be vectorized
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        std::uint64_t z = _seed + (_counter + n + 1) * 0x9E3779B97F4A7C15ULL;
+        
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        
+        // Top 53 bits to a double in [0,1), then to [-1,1)
+        block[n] = static_cast<double>(z >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    }
+    
+    _counter += size;
+}
+
+void Noise::_colorize(double* block, std::size_t size)
+{
+    // Output gains determined empirically, to keep
+    // peaks of all colors at around unity
+    switch (_color)
     {
         case PINK:
+        case BLUE:
         {
-            // Pink noise has a decrease of 3dB/Octave
+            // Pink noise has a decrease of 3dB/Octave,
+            // approximated by summing three one-pole
+            // low passes (Paul Kellet's economy filter)
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                _pink[0] = 0.99765 * _pink[0] + block[n] * 0.0990460;
+                _pink[1] = 0.96300 * _pink[1] + block[n] * 0.2965164;
+                _pink[2] = 0.57000 * _pink[2] + block[n] * 1.0526913;
+                
+                block[n] = (_pink[0] + _pink[1] + _pink[2] + block[n] * 0.1848) * 0.12;
+            }
             
-            _filter->setMode(Filter::LOW_PASS);
-            _filter->setCutoff(10000);
-            _filter->setGain(6);
+            if (_color == PINK) break;
             
-            break;
-        }
-            
-        case RED:
-        {
-            // Red noise has a decrease of 6dB/Octave
-            
-            _filter->setMode(Filter::LOW_PASS);
-            _filter->setCutoff(1500);
-            _filter->setGain(14);
+            // Blue noise has an increase of 3dB/Octave,
+            // which is pink noise differentiated (+6dB)
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                double pink = block[n];
+                
+                block[n] = (pink - _last) * 3;
+                
+                _last = pink;
+            }
             
             break;
         }
             
-        case BLUE:
+        case RED:
         {
-            // Blue noise has an increase of 3dB/Octave
-            
-            _filter->setMode(Filter::HIGH_PASS);
-            _filter->setCutoff(1000);
-            _filter->setQ(0.2);
-            _filter->setGain(-3);
+            // Red noise has a decrease of 6dB/Octave,
+            // i.e. integrated (leakily) white noise
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                _red = (_red + 0.02 * block[n]) / 1.02;
+                
+                block[n] = _red * 3.2;
+            }
             
             break;
         }
             
         case VIOLET:
         {
-            // Violet noise has an increase of 6dB/Octave
+            // Violet noise has an increase of 6dB/Octave,
+            // i.e. differentiated white noise
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                double white = block[n];
+                
+                block[n] = (white - _last) * 0.5;
+                
+                _last = white;
+            }
             
-            _filter->setMode(Filter::HIGH_PASS);
-            _filter->setCutoff(6000);
-            _filter->setQ(0.2);
-            _filter->setGain(3);
+            break;
         }
             
         default:
             break;
     }
-    
-    _color = color;
 }
 
-unsigned short Noise::getColor() const
+bool Noise::generate(double* block, std::size_t size)
 {
-    return _color;
+    if (! size) return true;
+    
+    // Check modulation dock for the amplitude parameter
+    if (_mods[AMP].inUse())
+    {
+        _amp = _mods[AMP].tick();
+    }
+    
+    _white(block, size);
+    
+    // All noise colors except white noise are filtered
+    if (_color != WHITE)
+    {
+        _colorize(block, size);
+    }
+    
+    // Ramp from the last block's amplitude to avoid zipper noise
+    const double incr = (_amp - _lastAmp) / size;
+    
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        block[n] *= _lastAmp + incr * (n + 1);
+    }
+    
+    // The ramp is zero throughout only if both ends are
+    const bool silent = ! _lastAmp && ! _amp;
+    
+    _lastAmp = _amp;
+    
+    return silent;
 }
 
 void Noise::update()
 {
     // Get random value
-    _rval = _dist(_rgen);
+    _white(&_rval, 1);
     
     // All noise colors except white noise are filtered
     if (_color != WHITE)
     {
-        _rval  = _filter->process(_rval);
+        _colorize(&_rval, 1);
     }
 }
 
@@ -164,5 +262,7 @@ double Noise::tick()
         _amp = _mods[AMP].tick();
     }
     
+    _lastAmp = _amp;
+    
     return _rval * _amp;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 ************************************************************************************************/
 
 #include "Operator.hpp"
+#include "OperatorBank.hpp"
 #include "Wavetable.hpp"
 #include "ModDock.hpp"
 #include "Global.hpp"
@@ -22,17 +23,23 @@ Operator::Operator(unsigned short wt,
                    short phaseOffset,
                    double ratio)
 
-: Oscillator(wt, 0, phaseOffset),
+: GenUnit(1),
+  _ownBank(Arena::make<OperatorBank>()),
+  _bank(_ownBank.get()),
+  _slot(0),
+  _boundary(1),
   _ratio(ratio),
-  GenUnit(1),
-  _noteFreq(0),
-  _note(0),
-  _modOffset(0),
-  _semitoneOffset(0),
   _freqOffset(0),
-  _realFreq(0),
-  _level(0)
+  _semitoneOffset(0),
+  _freq(0),
+  _phaseOffset(0),
+  _noteFreq(0),
+  _note(0)
 {
+    setWavetable(wt);
+    
+    setPhaseOffset(phaseOffset);
+    
     setFrequencyOffset(freqOffset);
     
     // setMode only works if the modes are different
@@ -46,35 +53,131 @@ Operator::Operator(unsigned short wt,
     setLevel(level);
 }
 
+Operator::Operator(const Operator& other)
+: GenUnit(other),
+  _ownBank(Arena::make<OperatorBank>()),
+  _bank(_ownBank.get()),
+  _slot(0),
+  _mode(other._mode),
+  _boundary(other._boundary),
+  _ratio(other._ratio),
+  _freqOffset(other._freqOffset),
+  _semitoneOffset(other._semitoneOffset),
+  _freq(other._freq),
+  _phaseOffset(other._phaseOffset),
+  _noteFreq(other._noteFreq),
+  _note(other._note)
+{
+    _copyState(*other._bank, other._slot);
+}
+
+Operator& Operator::operator= (const Operator& other)
+{
+    if (this != &other)
+    {
+        GenUnit::operator=(other);
+        
+        _mode = other._mode;
+        
+        _boundary = other._boundary;
+        
+        _ratio = other._ratio;
+        
+        _noteFreq = other._noteFreq;
+        
+        _note = other._note;
+        
+        _semitoneOffset = other._semitoneOffset;
+        
+        _freqOffset = other._freqOffset;
+        
+        _freq = other._freq;
+        
+        _phaseOffset = other._phaseOffset;
+        
+        _copyState(*other._bank, other._slot);
+        
+        // Unit's assignment activates
+        _bank->_gate[_slot] = _active ? 1 : 0;
+    }
+    
+    return *this;
+}
+
+void Operator::bind(OperatorBank& bank, OperatorBank::size_t slot)
+{
+    if (slot >= bank.size())
+    { throw std::out_of_range("Slot out of range!"); }
+    
+    if (&bank == _bank && slot == _slot) return;
+    
+    OperatorBank* previous = _bank;
+    
+    const OperatorBank::size_t previousSlot = _slot;
+    
+    _bank = &bank;
+    
+    _slot = slot;
+    
+    _copyState(*previous, previousSlot);
+    
+    _ownBank.reset();
+}
+
+const OperatorBank& Operator::getBank() const
+{
+    return *_bank;
+}
+
+OperatorBank::size_t Operator::getSlot() const
+{
+    return _slot;
+}
+
+void Operator::_copyState(const OperatorBank& bank, OperatorBank::size_t slot)
+{
+    _bank->_index[_slot] = bank._index[slot];
+    _bank->_incr[_slot] = bank._incr[slot];
+    _bank->_indexOffset[_slot] = bank._indexOffset[slot];
+    _bank->_modOffset[_slot] = bank._modOffset[slot];
+    _bank->_amp[_slot] = bank._amp[slot];
+    _bank->_level[_slot] = bank._level[slot];
+    _bank->_realFreq[_slot] = bank._realFreq[slot];
+    _bank->_gate[_slot] = bank._gate[slot];
+    _bank->_wavetable[_slot] = bank._wavetable[slot];
+}
+
 void Operator::setMode(Mode mode)
 {
     if (_mode == mode) return;
     
     _mode = mode;
     
+    double& level = _bank->_level[_slot];
+    
     switch(mode)
     {
         case Mode::FM:
         {
-            setLevel(_level * 10);
+            setLevel(level * 10);
             
             // Index of modulation, between 0 and 10
             _boundary = 10;
             
             break;
         }
-    
+        
         case Mode::ADDITIVE:
         {
             // More efficient to set level here
             // Factor 10 because of the different
             // ranges depending on the mode (0-1
             // for additive, 0-10 for FM)
-            _level /= 10;
+            level /= 10;
             
-            _amp = _level;
+            _bank->_amp[_slot] = level;
             
-            _mods[LEVEL].setBaseValue(_level);
+            _mods[LEVEL].setBaseValue(level);
             
             // Like amplitude, between 0 and 1
             _boundary = 1;
@@ -94,23 +197,30 @@ Operator::Mode Operator::getMode() const
 void Operator::setSilent()
 {
     // 0 frequency means no increment and thus silence
-    _noteFreq = _freq = _incr = _index = _note = _modOffset = 0;
+    _noteFreq = _freq = _note = 0;
+    
+    _bank->_incr[_slot] = _bank->_index[_slot] = _bank->_modOffset[_slot] = 0;
     
-    _realFreq = _freqOffset;
+    _bank->_realFreq[_slot] = _freqOffset;
+}
+
+bool Operator::hasNote() const
+{
+    return _noteFreq != 0;
 }
 
 void Operator::setLevel(double level)
 {
     if (level > _boundary || level < -_boundary)
     { throw std::invalid_argument("Level out of range!"); }
-
-    _level = level;
+    
+    _bank->_level[_slot] = level;
     
     // For FM Mode, the level is the index of modulation beta,
     // and the amplitude is the beta times the current real
     // frequency, as beta = amplitude/frequency. For Additive
     // Mode, the amplitude is simply the usual range from 0 to 1
-    _amp = (_mode == Mode::FM) ? level * _realFreq : level;
+    _bank->_amp[_slot] = (_mode == Mode::FM) ? level * _bank->_realFreq[_slot] : level;
     
     _mods[LEVEL].setBaseValue(level);
 }
@@ -122,12 +232,12 @@ double Operator::getLevel() const
         return _mods[LEVEL].getBaseValue();
     }
     
-    else return _level;
+    else return _bank->_level[_slot];
 }
 
 void Operator::modulateFrequency(double value)
 {
-    _modOffset = Global::tableIncrement * value;
+    _bank->_modOffset[_slot] = _context->getTableIncrement() * value;
 }
 
 void Operator::setNote(note_t note)
@@ -140,13 +250,11 @@ void Operator::setNote(note_t note)
     
     _freq = _noteFreq * _ratio;
     
-    _realFreq = _freq + _freqOffset;
+    _updateFrequency();
     
-    if (_mode == Mode::FM) _amp = _level * _realFreq;
+    _bank->_incr[_slot] = _context->getTableIncrement() * _freq;
     
-    _incr = Global::tableIncrement * _freq;
-    
-    _semitoneOffset = Util::freqToSemitones(_freq, _realFreq);
+    _semitoneOffset = Util::freqToSemitones(_freq, _bank->_realFreq[_slot]);
     
     _note = note;
 }
@@ -160,13 +268,11 @@ void Operator::setFrequencyOffset(double Hz)
 {
     _freqOffset = Hz;
     
-    _realFreq = _freq + _freqOffset;
-    
-    if (_mode == Mode::FM) _amp = _level * _realFreq;
+    _updateFrequency();
     
-    _indexOffset = Global::tableIncrement * _freqOffset;
+    _bank->_indexOffset[_slot] = _context->getTableIncrement() * _freqOffset;
     
-    _semitoneOffset = Util::freqToSemitones(_freq, _realFreq);
+    _semitoneOffset = Util::freqToSemitones(_freq, _bank->_realFreq[_slot]);
 }
 
 double Operator::getFrequencyOffset() const
@@ -176,7 +282,7 @@ double Operator::getFrequencyOffset() const
 
 double Operator::getFrequency() const
 {
-    return _realFreq;
+    return _bank->_realFreq[_slot];
 }
 
 void Operator::setSemitoneOffset(double semitones)
@@ -186,11 +292,9 @@ void Operator::setSemitoneOffset(double semitones)
     // More efficient to do things here
     // than to call setFrequencyOffset
     
-    _realFreq = _freq + _freqOffset;
+    _updateFrequency();
     
-    if (_mode == Mode::FM) _amp = _level * _realFreq;
-    
-    _indexOffset = Global::tableIncrement * _freqOffset;
+    _bank->_indexOffset[_slot] = _context->getTableIncrement() * _freqOffset;
     
     _semitoneOffset = semitones;
 }
@@ -209,13 +313,11 @@ void Operator::setRatio(double ratio)
     
     _freq = _noteFreq * ratio;
     
-    _realFreq = _freq + _freqOffset;
-    
-    if (_mode == Mode::FM) _amp = _level * _realFreq;
+    _updateFrequency();
     
-    _incr = Global::tableIncrement * _freq;
+    _bank->_incr[_slot] = _context->getTableIncrement() * _freq;
     
-    _semitoneOffset = Util::freqToSemitones(_freq, _realFreq);
+    _semitoneOffset = Util::freqToSemitones(_freq, _bank->_realFreq[_slot]);
 }
 
 double Operator::getRatio() const
@@ -223,24 +325,106 @@ double Operator::getRatio() const
     return _ratio;
 }
 
+void Operator::_updateFrequency()
+{
+    const double realFreq = _freq + _freqOffset;
+    
+    _bank->_realFreq[_slot] = realFreq;
+    
+    if (_mode == Mode::FM) _bank->_amp[_slot] = _bank->_level[_slot] * realFreq;
+}
+
+void Operator::setWavetable(unsigned short id)
+{
+    _bank->_wavetable[_slot] = id;
+}
+
+std::shared_ptr<const Wavetable> Operator::getWavetable() const
+{
+    return wavetableDatabase[_bank->_wavetable[_slot]];
+}
+
+void Operator::setPhaseOffset(short degrees)
+{
+    // convert degrees higher or lower than 360 or
+    // less than 0 to its 0 - 360 degree equivalent
+    
+    while (degrees < 0)
+    { degrees += 360; }
+    
+    while (degrees > 360)
+    { degrees -= 360; }
+    
+    double& index = _bank->_index[_slot];
+    
+    // Return to original index (without offset), so
+    // that setting a new offset doesn't add to the
+    // old one but really set a new one
+    index -= _phaseOffset;
+    
+    _phaseOffset = ((Global::wavetableLength + 1) * degrees) / 360.0;
+    
+    index += _phaseOffset;
+}
+
+double Operator::getPhaseOffset() const
+{
+    return (_phaseOffset * 360) / (Global::wavetableLength + 1);
+}
+
+void Operator::reset()
+{
+    _bank->_index[_slot] = _phaseOffset;
+}
+
+void Operator::setActive(bool state)
+{
+    GenUnit::setActive(state);
+    
+    _bank->_gate[_slot] = state ? 1 : 0;
+}
+
+void Operator::setAmp(double amp)
+{
+    GenUnit::setAmp(amp);
+    
+    _bank->_amp[_slot] = amp;
+}
+
+double Operator::getAmp() const
+{
+    return _bank->_amp[_slot];
+}
+
 void Operator::update()
 {
     // Normal frequency index increment     +
     // Index increment for frequency offset +
     // Index increment for frequency modulation value
-    _increment(_incr + _indexOffset + _modOffset);
+    _bank->update(_slot, 1);
 }
 
-double Operator::tick()
+void Operator::modulateLevel()
 {
     if (_mods[LEVEL].inUse())
     {
-        _level = _mods[LEVEL].tick();
+        const double level = _mods[LEVEL].tick();
+        
+        _bank->_level[_slot] = level;
+        
+        double& amp = _bank->_amp[_slot];
         
-        _amp = _level;
+        amp = level;
         
-        if (_mode == Mode::FM) _amp *= _realFreq;
+        if (_mode == Mode::FM) amp *= _bank->_realFreq[_slot];
     }
+}
+
+double Operator::tick()
+{
+    modulateLevel();
+    
+    const Wavetable* table = wavetableDatabase.get(_bank->_wavetable[_slot]);
     
-    return Oscillator::tick() * _amp;
-}
\ No newline at end of file
+    return table->interpolate(_bank->_index[_slot]) * _bank->_amp[_slot];
+}
@@ -0,0 +1,124 @@
+/********************************************************************************************//*!
+*
+*  @file        OperatorBank.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "OperatorBank.hpp"
+#include "EngineContext.hpp"
+#include "Global.hpp"
+#include "Wavetable.hpp"
+
+#include <stdexcept>
+
+const OperatorBank::index_t OperatorBank::setSize;
+
+OperatorBank::OperatorBank(size_t sets)
+: _context(&EngineContext::current()),
+  _sets(sets)
+{
+    if (! sets)
+    { throw std::invalid_argument("OperatorBank needs at least one set!"); }
+    
+    const size_t n = size();
+    
+    // Eight rows: index, increment, offset, modulation,
+    // amplitude, level, real frequency and gate
+    _memory.assign(8 * n, 0);
+    
+    _wavetable.assign(n, WavetableDatabase::SINE);
+    
+    _index = &_memory[0];
+    _incr = _index + n;
+    _indexOffset = _incr + n;
+    _modOffset = _indexOffset + n;
+    _amp = _modOffset + n;
+    _level = _amp + n;
+    _realFreq = _level + n;
+    _gate = _realFreq + n;
+}
+
+OperatorBank::size_t OperatorBank::sets() const
+{
+    return _sets;
+}
+
+OperatorBank::size_t OperatorBank::size() const
+{
+    return _sets * setSize;
+}
+
+OperatorBank::size_t OperatorBank::slot(index_t position, size_t set) const
+{
+    if (position >= setSize || set >= _sets)
+    { throw std::out_of_range("Operator position or set out of range!"); }
+    
+    return position * _sets + set;
+}
+
+void OperatorBank::tick(size_t first, size_t count, double* output) const
+{
+    for (size_t n = 0, s = first; n < count; ++n, ++s)
+    {
+        const double value = wavetableDatabase.get(_wavetable[s])->interpolate(_index[s]);
+        
+        output[n] = value * _amp[s] * _gate[s];
+    }
+}
+
+void OperatorBank::modulate(size_t first, size_t count, double* values)
+{
+    double* modOffset = _modOffset + first;
+    
+    const double tableIncrement = _context->getTableIncrement();
+    
+    for (size_t n = 0; n < count; ++n)
+    {
+        modOffset[n] = tableIncrement * values[n];
+    }
+    
+    tick(first, count, values);
+}
+
+void OperatorBank::add(size_t first, size_t count, double* values) const
+{
+    for (size_t n = 0, s = first; n < count; ++n, ++s)
+    {
+        const double value = wavetableDatabase.get(_wavetable[s])->interpolate(_index[s]);
+        
+        values[n] = (values[n] + value * _amp[s]) * _gate[s];
+    }
+}
+
+void OperatorBank::update(size_t first, size_t count)
+{
+    const double length = Global::wavetableLength;
+    
+    double* index = _index + first;
+    
+    const double* incr = _incr + first;
+    const double* indexOffset = _indexOffset + first;
+    const double* modOffset = _modOffset + first;
+    const double* gate = _gate + first;
+    
+    // Selects instead of branches, so that this vectorizes
+    for (size_t n = 0; n < count; ++n)
+    {
+        double value = index[n] + (incr[n] + indexOffset[n] + modOffset[n]) * gate[n];
+        
+        value -= (value >= length) ? length : 0;
+        
+        value += (value < 0) ? length : 0;
+        
+        index[n] = value;
+    }
+}
+
+void OperatorBank::update()
+{
+    update(0, size());
+}
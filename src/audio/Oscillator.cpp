@@ -9,10 +9,12 @@
 ************************************************************************************************/
 
 #include "Oscillator.hpp"
+#include "EngineContext.hpp"
 #include "Global.hpp"
 #include "Util.hpp"
 #include "Wavetable.hpp"
 
+#include <cmath>
 #include <stdexcept>
 
 Oscillator::Oscillator(unsigned short wt,
@@ -20,7 +22,8 @@ Oscillator::Oscillator(unsigned short wt,
                        short phaseOffset)
 : _index(0),
   _phaseOffset(phaseOffset),
-  _wavetable(wavetableDatabase[wt])
+  _wavetable(wt),
+  _context(&EngineContext::current())
 {
     setPhaseOffset(phaseOffset);
     
@@ -32,7 +35,8 @@ Oscillator::Oscillator(const Oscillator& other)
   _phaseOffset(other._phaseOffset),
   _freq(other._freq),
   _incr(other._incr),
-   _wavetable(other._wavetable)
+   _wavetable(other._wavetable),
+  _context(other._context)
 { }
 
 Oscillator& Oscillator::operator=(const Oscillator &other)
@@ -47,7 +51,9 @@ Oscillator& Oscillator::operator=(const Oscillator &other)
         
         _freq = other._freq;
         
-        _wavetable.reset(new Wavetable(*other._wavetable));
+        _wavetable = other._wavetable;
+        
+        _context = other._context;
     }
     
     return *this;
@@ -57,22 +63,22 @@ Oscillator::~Oscillator() = default;
 
 void Oscillator::setWavetable(unsigned short id)
 {
-    _wavetable = wavetableDatabase[id];
+    _wavetable = id;
 }
 
-std::shared_ptr<Wavetable> Oscillator::getWavetable() const
+std::shared_ptr<const Wavetable> Oscillator::getWavetable() const
 {
-    return _wavetable;
+    return wavetableDatabase[_wavetable];
 }
 
 void Oscillator::setFrequency(double Hz)
 {
-    //if (Hz < 0 || Hz > Global::nyquistLimit)
+    //if (Hz < 0 || Hz > _context->getNyquistLimit())
     //{ throw std::invalid_argument("Frequency must be greater 0 and less than the nyquist limit!"); }
     
     _freq = Hz;
     
-    _incr = Global::tableIncrement * Hz;
+    _incr = _context->getTableIncrement() * Hz;
 }
 
 double Oscillator::getFrequency() const
@@ -133,8 +139,27 @@ void Oscillator::update()
     _increment(_incr);
 }
 
+void Oscillator::advance(unsigned long samples)
+{
+    // May wrap around the wavetable more than once
+    _index = std::fmod(_index + _incr * samples, Global::wavetableLength);
+    
+    if (_index < 0)
+    { _index += Global::wavetableLength; }
+}
+
+double Oscillator::peek(double samples) const
+{
+    double index = std::fmod(_index + _incr * samples, Global::wavetableLength);
+    
+    if (index < 0)
+    { index += Global::wavetableLength; }
+    
+    return wavetableDatabase.get(_wavetable)->interpolate(index);
+}
+
 double Oscillator::tick()
 {
     // Grab a value through interpolation from the wavetable
-    return _wavetable->interpolate(_index);
+    return wavetableDatabase.get(_wavetable)->interpolate(_index);
 }
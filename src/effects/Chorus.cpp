@@ -0,0 +1,330 @@
+/********************************************************************************************//*!
+*
+*  @file        Chorus.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "Chorus.hpp"
+#include "LFO.hpp"
+#include "Global.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+const double Chorus::maxDelay = 0.05;
+
+const std::size_t Chorus::_chunkSize;
+
+Chorus::Chorus(double center,
+               double depth,
+               double rate,
+               double dryWet)
+: EffectUnit(0, dryWet),
+  _center(center),
+  _interpolation(DelayLine::LINEAR),
+  _lfos(Arena::makeArray<LFO>(voices)),
+  // Headroom for the older samples of cubic interpolation
+  _line(static_cast<DelayLine::size_t>(maxDelay * _context->getSamplerate()) + 4),
+  _lineRight(_line.capacity())
+{
+    if (center + depth > maxDelay)
+    { throw std::invalid_argument("Chorus center plus depth cannot exceed the maximum delay!"); }
+    
+    for (unsigned short v = 0; v < voices; ++v)
+    {
+        _lfos[v].setFrequency(rate);
+        
+        _lfos[v].setAmp(depth);
+        
+        // Spread the voices evenly in phase
+        _lfos[v].setPhaseOffset(360.0 * v / voices);
+        
+        _lfos[v].setActive(true);
+        
+        _lengths[v] = _lengthsRight[v] = center * _context->getSamplerate();
+    }
+}
+
+Chorus::Chorus(const Chorus& other, bool copySamples)
+: EffectUnit(other),
+  _center(other._center),
+  _interpolation(other._interpolation),
+  _lfos(Arena::makeArray<LFO>(voices)),
+  _line(copySamples ? other._line : DelayLine(other._line.capacity())),
+  _lineRight(copySamples ? other._lineRight : DelayLine(other._lineRight.capacity()))
+{
+    for (unsigned short v = 0; v < voices; ++v)
+    {
+        _lfos[v] = other._lfos[v];
+        
+        _lengths[v] = other._lengths[v];
+        
+        _lengthsRight[v] = other._lengthsRight[v];
+    }
+}
+
+Chorus::~Chorus()
+{ }
+
+Chorus* Chorus::clone() const
+{
+    return new Chorus(*this, false);
+}
+
+Chorus& Chorus::operator= (const Chorus& other)
+{
+    if (this != &other)
+    {
+        EffectUnit::operator=(other);
+        
+        _center = other._center;
+        
+        _interpolation = other._interpolation;
+        
+        for (unsigned short v = 0; v < voices; ++v)
+        {
+            _lfos[v] = other._lfos[v];
+            
+            _lengths[v] = other._lengths[v];
+            
+            _lengthsRight[v] = other._lengthsRight[v];
+        }
+        
+        _line = other._line;
+        
+        _lineRight = other._lineRight;
+    }
+    
+    return *this;
+}
+
+void Chorus::setCenter(double center)
+{
+    if (center + getDepth() > maxDelay)
+    { throw std::invalid_argument("Chorus center plus depth cannot exceed the maximum delay!"); }
+    
+    _center = center;
+}
+
+double Chorus::getCenter() const
+{
+    return _center;
+}
+
+void Chorus::setDepth(double depth)
+{
+    if (_center + depth > maxDelay)
+    { throw std::invalid_argument("Chorus center plus depth cannot exceed the maximum delay!"); }
+    
+    for (unsigned short v = 0; v < voices; ++v)
+    {
+        _lfos[v].setAmp(depth);
+    }
+}
+
+double Chorus::getDepth() const
+{
+    return _lfos[0].getAmp();
+}
+
+void Chorus::setRate(double rate)
+{
+    for (unsigned short v = 0; v < voices; ++v)
+    {
+        _lfos[v].setFrequency(rate);
+    }
+}
+
+double Chorus::getRate() const
+{
+    return _lfos[0].getFrequency();
+}
+
+void Chorus::setInterpolation(unsigned short interpolation)
+{
+    if (interpolation > DelayLine::CUBIC)
+    { throw std::invalid_argument("Invalid interpolation method!"); }
+    
+    _interpolation = interpolation;
+}
+
+unsigned short Chorus::getInterpolation() const
+{
+    return _interpolation;
+}
+
+double Chorus::process(double sample)
+{
+    processBlock(&sample, 1);
+    
+    return sample;
+}
+
+std::size_t Chorus::getTailLength() const
+{
+    return static_cast<std::size_t>((_center + getDepth()) * _context->getSamplerate()) + 3;
+}
+
+std::size_t Chorus::_chunkLimit(double& minimum) const
+{
+    // Cubic interpolation also reads the sample one newer
+    const std::size_t guard = (_interpolation == DelayLine::CUBIC) ? 1 : 0;
+    
+    const double shortest = (_center - getDepth()) * _context->getSamplerate();
+    
+    // Chunks must not be longer than the shortest delay
+    // or the voices would read samples not yet written
+    std::size_t chunkSize = _chunkSize;
+    
+    if (shortest < _chunkSize + guard)
+    {
+        chunkSize = (shortest < 1 + guard) ? 1 : static_cast<std::size_t>(shortest) - guard;
+    }
+    
+    minimum = chunkSize + guard;
+    
+    return chunkSize;
+}
+
+void Chorus::processBlock(double* block, std::size_t size)
+{
+    double minimum;
+    
+    const std::size_t chunkSize = _chunkLimit(minimum);
+    
+    double lengths [_chunkSize];
+    double delayed [_chunkSize];
+    double wet [_chunkSize];
+    
+    while (size)
+    {
+        const std::size_t chunk = std::min<std::size_t>(size, chunkSize);
+        
+        std::fill(wet, wet + chunk, 0);
+        
+        for (unsigned short v = 0; v < voices; ++v)
+        {
+            // The last delay time may be shorter if the
+            // center or depth changed since the last chunk
+            const double start = std::max(_lengths[v], minimum);
+            
+            // Evaluate the LFO at the end of the chunk and
+            // ramp the delay time linearly towards it
+            _lfos[v].advance(chunk);
+            
+            _lengths[v] = std::max(_lfos[v].modulate(_center, 1, 1) * _context->getSamplerate(), minimum);
+            
+            const double step = (_lengths[v] - start) / chunk;
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                lengths[n] = start + step * (n + 1);
+            }
+            
+            _line.read(delayed, lengths, chunk, _interpolation);
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                wet[n] += delayed[n];
+            }
+        }
+        
+        _line.write(block, chunk);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            block[n] = _dryWet(block[n], wet[n] / voices);
+        }
+        
+        block += chunk;
+        
+        size -= chunk;
+    }
+}
+
+void Chorus::processStereo(double* left, double* right, std::size_t size)
+{
+    double minimum;
+    
+    const std::size_t chunkSize = _chunkLimit(minimum);
+    
+    const double center = _center * _context->getSamplerate();
+    
+    double lengths [_chunkSize];
+    double delayed [_chunkSize];
+    double wetLeft [_chunkSize];
+    double wetRight [_chunkSize];
+    
+    while (size)
+    {
+        const std::size_t chunk = std::min<std::size_t>(size, chunkSize);
+        
+        std::fill(wetLeft, wetLeft + chunk, 0);
+        
+        std::fill(wetRight, wetRight + chunk, 0);
+        
+        for (unsigned short v = 0; v < voices; ++v)
+        {
+            const double startLeft = std::max(_lengths[v], minimum);
+            
+            const double startRight = std::max(_lengthsRight[v], minimum);
+            
+            _lfos[v].advance(chunk);
+            
+            const double length = _lfos[v].modulate(_center, 1, 1) * _context->getSamplerate();
+            
+            // Mirrored around the center for the right channel
+            _lengths[v] = std::max(length, minimum);
+            
+            _lengthsRight[v] = std::max(2 * center - length, minimum);
+            
+            double step = (_lengths[v] - startLeft) / chunk;
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                lengths[n] = startLeft + step * (n + 1);
+            }
+            
+            _line.read(delayed, lengths, chunk, _interpolation);
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                wetLeft[n] += delayed[n];
+            }
+            
+            step = (_lengthsRight[v] - startRight) / chunk;
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                lengths[n] = startRight + step * (n + 1);
+            }
+            
+            _lineRight.read(delayed, lengths, chunk, _interpolation);
+            
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                wetRight[n] += delayed[n];
+            }
+        }
+        
+        _line.write(left, chunk);
+        
+        _lineRight.write(right, chunk);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            left[n] = _dryWet(left[n], wetLeft[n] / voices);
+            
+            right[n] = _dryWet(right[n], wetRight[n] / voices);
+        }
+        
+        left += chunk;
+        right += chunk;
+        
+        size -= chunk;
+    }
+}
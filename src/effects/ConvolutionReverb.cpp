@@ -0,0 +1,418 @@
+/********************************************************************************************//*!
+*
+*  @file        ConvolutionReverb.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "ConvolutionReverb.hpp"
+#include "Wavefile.hpp"
+#include "Global.hpp"
+#include "ModDock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+ConvolutionReverb::ConvolutionReverb(size_t partitionSize, double dryWet)
+: EffectUnit(1),
+  _partitionSize(partitionSize),
+  _bins(partitionSize + 1),
+  _partitions(0),
+  _length(0),
+  _fft(2 * partitionSize),
+  _live(nullptr),
+  _hazard(nullptr),
+  _work(2 * partitionSize),
+  _accumulator(partitionSize + 1)
+{
+    setDryWet(dryWet);
+
+    _mods[DRYWET].setHigherBoundary(1);
+    _mods[DRYWET].setLowerBoundary(0);
+    _mods[DRYWET].setBaseValue(dryWet);
+}
+
+ConvolutionReverb::ConvolutionReverb(const ConvolutionReverb& other, bool copySamples)
+: EffectUnit(other),
+  _partitionSize(other._partitionSize),
+  _bins(other._bins),
+  _partitions(other._partitions.load()),
+  _length(other._length.load()),
+  _fft(other._fft),
+  _live(nullptr),
+  _hazard(nullptr),
+  _work(other._work.size()),
+  _accumulator(other._accumulator.size())
+{
+    const State* state = other._live.load();
+
+    if (! state) return;
+
+    State* copy;
+
+    if (copySamples) copy = new State(*state);
+
+    else
+    {
+        copy = new State(_partitionSize, _bins, state->partitions, state->length);
+
+        copy->spectra = state->spectra;
+    }
+
+    _live.store(copy);
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    delete _live.load();
+}
+
+ConvolutionReverb* ConvolutionReverb::clone() const
+{
+    return new ConvolutionReverb(*this, false);
+}
+
+void ConvolutionReverb::setDryWet(double dw)
+{
+    // For error checking
+    EffectUnit::setDryWet(dw);
+
+    _mods[DRYWET].setBaseValue(dw);
+}
+
+double ConvolutionReverb::getDryWet() const
+{
+    if (_mods[DRYWET].inUse())
+    {
+        return _mods[DRYWET].getBaseValue();
+    }
+
+    else return _dw;
+}
+
+void ConvolutionReverb::loadImpulseResponse(const std::string& fname)
+{
+    unsigned int samplerate;
+
+    std::vector<double> ir = Wavefile::load(fname, &samplerate);
+
+    // Linearly resample to the samplerate of the context
+    if (samplerate != _context->getSamplerate() && ! ir.empty())
+    {
+        const double ratio = static_cast<double>(samplerate) / _context->getSamplerate();
+
+        std::vector<double> resampled(static_cast<size_t>(ir.size() / ratio));
+
+        for (size_t n = 0; n < resampled.size(); ++n)
+        {
+            const double position = n * ratio;
+
+            const size_t integral = static_cast<size_t>(position);
+
+            const double next = (integral + 1 < ir.size()) ? ir[integral + 1] : 0;
+
+            resampled[n] = ir[integral] + (next - ir[integral]) * (position - integral);
+        }
+
+        ir.swap(resampled);
+    }
+
+    setImpulseResponse(ir);
+}
+
+void ConvolutionReverb::setImpulseResponse(const std::vector<double>& ir)
+{
+    double energy = 0;
+
+    for (std::vector<double>::const_iterator itr = ir.begin(), end = ir.end();
+         itr != end;
+         ++itr)
+    {
+        energy += (*itr) * (*itr);
+    }
+
+    if (! energy)
+    {
+        clearImpulseResponse();
+
+        return;
+    }
+
+    const double norm = 1 / std::sqrt(energy);
+
+    const size_t partitions = (ir.size() + _partitionSize - 1) / _partitionSize;
+
+    // Built entirely here, the audio thread only ever sees the finished state
+    State* state = new State(_partitionSize, _bins, partitions, ir.size());
+
+    // Copies may still be using the old spectra, so never modify them in place
+    std::shared_ptr<std::vector<complex_t>> spectra(new std::vector<complex_t>(partitions * _bins));
+
+    // The audio thread may be using _fft and _work meanwhile
+    FFT fft(2 * _partitionSize);
+
+    std::vector<complex_t> work(fft.size());
+
+    for (size_t p = 0; p < partitions; ++p)
+    {
+        // Zero-padded to twice the partition size
+        std::fill(work.begin(), work.end(), 0);
+
+        const size_t begin = p * _partitionSize;
+
+        const size_t end = std::min(begin + _partitionSize, ir.size());
+
+        for (size_t n = begin; n < end; ++n)
+        {
+            work[n - begin] = ir[n] * norm;
+        }
+
+        fft.forward(&work[0]);
+
+        std::copy(work.begin(), work.begin() + _bins, spectra->begin() + p * _bins);
+    }
+
+    state->spectra = spectra;
+
+    _publish(state);
+}
+
+void ConvolutionReverb::clearImpulseResponse()
+{
+    _publish(nullptr);
+}
+
+void ConvolutionReverb::_publish(State* state)
+{
+    _partitions.store(state ? state->partitions : 0);
+
+    _length.store(state ? state->length : 0);
+
+    State* old = _live.exchange(state);
+
+    // Wait for the audio thread to finish the block it
+    // may be processing with the old state, at most one
+    while (old && _hazard.load() == old)
+    {
+        std::this_thread::yield();
+    }
+
+    delete old;
+}
+
+bool ConvolutionReverb::hasImpulseResponse() const
+{
+    return _partitions.load();
+}
+
+double ConvolutionReverb::getLength() const
+{
+    return static_cast<double>(_length.load()) / _context->getSamplerate();
+}
+
+ConvolutionReverb::size_t ConvolutionReverb::getLatency() const
+{
+    return _partitionSize;
+}
+
+ConvolutionReverb::size_t ConvolutionReverb::getTailLength() const
+{
+    return (_partitions.load() + 1) * _partitionSize;
+}
+
+void ConvolutionReverb::_convolve(State& state, unsigned short channels)
+{
+    // The spectra are stored as the newest ones in the delay lines
+    state.newest = (state.newest + state.partitions - 1) % state.partitions;
+
+    for (unsigned short c = 0; c < channels; ++c)
+    {
+        Channel& channel = state.channels[c];
+
+        // Transform the last two blocks of input
+        std::copy(channel.input.begin(), channel.input.end(), _work.begin());
+
+        _fft.forward(&_work[0]);
+
+        std::copy(_work.begin(), _work.begin() + _bins, channel.history.begin() + state.newest * _bins);
+
+        std::fill(_accumulator.begin(), _accumulator.end(), 0);
+
+        // Multiply each past input spectrum with the
+        // spectrum of the IR partition as old as it
+        for (size_t p = 0, h = state.newest; p < state.partitions; ++p)
+        {
+            const complex_t* x = &channel.history[h * _bins];
+            const complex_t* y = &(*state.spectra)[p * _bins];
+
+            for (size_t k = 0; k < _bins; ++k)
+            {
+                _accumulator[k] += x[k] * y[k];
+            }
+
+            if (++h == state.partitions) h = 0;
+        }
+
+        // The spectrum of a real signal is conjugate symmetric,
+        // so only half of it needs to be computed
+        const size_t size = _fft.size();
+
+        _work[0] = _accumulator[0];
+
+        for (size_t k = 1; k < _bins; ++k)
+        {
+            _work[k] = _accumulator[k];
+
+            _work[size - k] = std::conj(_accumulator[k]);
+        }
+
+        _fft.inverse(&_work[0]);
+
+        // Overlap-save: the first half is corrupted by the
+        // circular wrap-around, the second half is the output
+        for (size_t n = 0; n < _partitionSize; ++n)
+        {
+            channel.output[n] = _work[_partitionSize + n].real();
+        }
+
+        // Slide the input window by one block
+        std::copy(channel.input.begin() + _partitionSize, channel.input.end(), channel.input.begin());
+    }
+}
+
+double ConvolutionReverb::process(double sample)
+{
+    processBlock(&sample, 1);
+
+    return sample;
+}
+
+ConvolutionReverb::State* ConvolutionReverb::_acquire()
+{
+    State* state = _live.load();
+
+    // Announce the state before using it. If it was replaced in
+    // the meantime, the control thread may not have seen the
+    // announcement, so announce the new one instead
+    for (;;)
+    {
+        _hazard.store(state);
+
+        State* current = _live.load();
+
+        if (current == state) break;
+
+        state = current;
+    }
+
+    return state;
+}
+
+void ConvolutionReverb::processBlock(double* block, std::size_t size)
+{
+    State* state = _acquire();
+
+    if (! state)
+    {
+        _hazard.store(nullptr);
+
+        return;
+    }
+
+    // Modulate the dry/wet
+    if (_mods[DRYWET].inUse())
+    {
+        _dw = _mods[DRYWET].tick();
+    }
+
+    Channel& channel = state->channels[0];
+
+    while (size)
+    {
+        // Process up to the end of the current partition
+        const size_t chunk = std::min(size, _partitionSize - state->position);
+
+        double* input = &channel.input[_partitionSize + state->position];
+
+        const double* output = &channel.output[state->position];
+
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            input[n] = block[n];
+
+            block[n] = _dryWet(block[n], output[n]);
+        }
+
+        state->position += chunk;
+
+        if (state->position == _partitionSize)
+        {
+            _convolve(*state, 1);
+
+            state->position = 0;
+        }
+
+        block += chunk;
+
+        size -= chunk;
+    }
+
+    _hazard.store(nullptr);
+}
+
+void ConvolutionReverb::processStereo(double* left, double* right, std::size_t size)
+{
+    State* state = _acquire();
+
+    if (! state)
+    {
+        _hazard.store(nullptr);
+
+        return;
+    }
+
+    if (_mods[DRYWET].inUse())
+    {
+        _dw = _mods[DRYWET].tick();
+    }
+
+    Channel& first = state->channels[0];
+    Channel& second = state->channels[1];
+
+    while (size)
+    {
+        const size_t chunk = std::min(size, _partitionSize - state->position);
+
+        const size_t offset = _partitionSize + state->position;
+
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            first.input[offset + n] = left[n];
+            second.input[offset + n] = right[n];
+
+            left[n] = _dryWet(left[n], first.output[state->position + n]);
+            right[n] = _dryWet(right[n], second.output[state->position + n]);
+        }
+
+        state->position += chunk;
+
+        if (state->position == _partitionSize)
+        {
+            _convolve(*state, 2);
+
+            state->position = 0;
+        }
+
+        left += chunk;
+        right += chunk;
+
+        size -= chunk;
+    }
+
+    _hazard.store(nullptr);
+}
@@ -11,15 +11,13 @@
 #include "Delay.hpp"
 #include "Global.hpp"
 #include "ModDock.hpp"
+#include "FastMath.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
-
-#include <iostream>
-
-
-
+const Delay::size_t Delay::_chunkSize;
 
 Delay::Delay(double delayLength,
              double decayTime,
@@ -27,17 +25,18 @@ Delay::Delay(double delayLength,
              double feedbackLevel,
              double capacity)
 : EffectUnit(4,1),
-  _buffer(capacity * Global::samplerate,0)
+  _capacity(_samplesFor(capacity > delayLength ? capacity : delayLength)),
+  _pingPong(false),
+  _line(_capacity),
+  _lineRight(_capacity)
 {
-    _write = _buffer.begin();
-    
     setFeedback(feedbackLevel);
     setDecayRate(decayRate);
     setDelayTime(delayLength);
     setDecayTime(decayTime);
     
     // Initialize mod docks
-    _mods[DECAY_TIME].setHigherBoundary(_buffer.size());
+    _mods[DECAY_TIME].setHigherBoundary(_capacity);
     _mods[DECAY_TIME].setLowerBoundary(0);
     _mods[DECAY_TIME].setBaseValue(_decayTime);
     
@@ -54,22 +53,22 @@ Delay::Delay(double delayLength,
     _mods[DRYWET].setBaseValue(1);
 }
 
-Delay::Delay(const Delay& other)
+Delay::Delay(const Delay& other, bool copySamples)
 : EffectUnit(other),
-  _buffer(other._buffer),
+  _delayTime(other._delayTime),
+  _decayValue(other._decayValue),
   _decayRate(other._decayRate),
   _decayTime(other._decayTime),
-  _decayValue(other._decayValue),
-  _readIntegral(other._readIntegral),
-  _readFractional(other._readFractional),
-  _feedback(other._feedback)
+  _feedback(other._feedback),
+  _capacity(other._capacity),
+  _pingPong(other._pingPong),
+  _line(copySamples ? other._line : DelayLine(other._line.capacity())),
+  _lineRight(copySamples ? other._lineRight : DelayLine(other._lineRight.capacity()))
+{ }
+
+Delay* Delay::clone() const
 {
-    _buffer.reserve(other._buffer.capacity());
-    
-    // Convert iterator to const_iterator because other is const
-    const_iterator itr = other._write;
-    
-    _write = _buffer.begin() + std::distance(other._buffer.begin(), itr);
+    return new Delay(*this, false);
 }
 
 Delay& Delay::operator=(const Delay &other)
@@ -78,26 +77,23 @@ Delay& Delay::operator=(const Delay &other)
     {
         EffectUnit::operator=(other);
         
-        _buffer = other._buffer;
+        _delayTime = other._delayTime;
         
-        _buffer.reserve(other._buffer.capacity());
+        _decayValue = other._decayValue;
         
         _decayRate = other._decayRate;
         
         _decayTime = other._decayTime;
         
-        _decayValue = other._decayValue;
-        
-        _readIntegral = other._readIntegral;
+        _feedback = other._feedback;
         
-        _readFractional = other._readFractional;
+        _capacity = other._capacity;
         
-        _feedback = other._feedback;
+        _pingPong = other._pingPong;
         
-        // Convert iterator to const_iterator because other is const
-        const_iterator itr = other._write;
+        _line = other._line;
         
-        _write = _buffer.begin() + std::distance(other._buffer.begin(), itr);
+        _lineRight = other._lineRight;
     }
     
     return *this;
@@ -143,27 +139,41 @@ double Delay::getDecayRate() const
 
 void Delay::setDelayTime(double delayTime)
 {
-    delayTime *= Global::samplerate;
+    delayTime *= _context->getSamplerate();
     
-    if (delayTime < 0 || delayTime >= _buffer.size())
+    if (delayTime < 0 || delayTime >= _capacity)
     {
         throw std::invalid_argument("Delay line length cannot be less than 0 or greater the delay line capacity!");
     }
     
-    // Cast to int
-    _readIntegral = delayTime;
-    
-    // delayLength is double so get the fractional part
-    // by subtracting the integer part
-    _readFractional = delayTime - _readIntegral;
+    _delayTime = delayTime;
     
     _calcDecay();
 }
 
+std::size_t Delay::getTailLength() const
+{
+    return static_cast<std::size_t>(_delayTime) + 2;
+}
+
 double Delay::getDelayTime() const
 {
     // seconds not samples
-    return _buffer.size() / (static_cast<double>(Global::samplerate));
+    return _delayTime / _context->getSamplerate();
+}
+
+double Delay::getCapacity() const
+{
+    // The capacity includes two samples of headroom
+    return (_capacity - 2) / static_cast<double>(_context->getSamplerate());
+}
+
+Delay::size_t Delay::_samplesFor(double seconds) const
+{
+    // One extra sample for the fractional read, which reads one
+    // sample further back, and one so that the capacity itself
+    // is a valid delay time (it must be less than the size)
+    return static_cast<size_t>(seconds * _context->getSamplerate()) + 2;
 }
 
 void Delay::setFeedback(double feedbackLevel)
@@ -190,7 +200,7 @@ double Delay::getFeedback() const
 
 void Delay::setDecayTime(double decayTime)
 {
-    decayTime *= Global::samplerate;
+    decayTime *= _context->getSamplerate();
     
     if (decayTime < 0)
     { throw std::invalid_argument("Decay time must be greater or equal 0!"); }
@@ -206,11 +216,11 @@ double Delay::getDecayTime() const
 {
     if (_mods[DECAY_TIME].inUse())
     {
-        return _mods[DECAY_TIME].getBaseValue() / Global::samplerate;
+        return _mods[DECAY_TIME].getBaseValue() / _context->getSamplerate();
     }
     
     // return seconds, not samples
-    else return _decayTime / Global::samplerate;
+    else return _decayTime / _context->getSamplerate();
 }
 
 void Delay::_calcDecay()
@@ -222,35 +232,18 @@ void Delay::_calcDecay()
     
     else
     {
-        double decayExponent = static_cast<double>(_readIntegral) / _decayTime;
+        double decayExponent = static_cast<size_t>(_delayTime) / _decayTime;
     
-        _decayValue = pow(_decayRate, decayExponent);
+        _decayValue = FastMath::pow(_decayRate, decayExponent);
     }
 }
 
 double Delay::offset(unsigned int offset)
 {
-    iterator ret = _write - offset;
-    
-    if (ret < _buffer.begin())
-    {
-        ret += _buffer.size();
-    }
-    
-    return *ret;
+    return _line.read(static_cast<DelayLine::size_t>(offset));
 }
 
-void Delay::_writeAndIncrement(double sample)
-{
-    *_write = sample;
-    
-    if (++_write >= _buffer.end())
-    {
-        _write -= _buffer.size();
-    }
-}
-
-double Delay::process(double sample)
+void Delay::_modulate()
 {
     if (_mods[DECAY_TIME].inUse() ||
         _mods[DECAY_RATE].inUse())
@@ -281,88 +274,249 @@ double Delay::process(double sample)
     {
         _dw = _mods[DRYWET].tick();
     }
+}
+
+double Delay::_tick(double sample)
+{
+    return _tick(_line, sample);
+}
+
+double Delay::_tick(DelayLine& line, double sample)
+{
+    // If the delay is shorter than a sample we
+    // need to first write the new sample
+    if (_delayTime < 1)
+    {
+        line.write(sample);
+        
+        return line.read(_delayTime + 1) * _decayValue;
+    }
+    
+    double output = line.read(_delayTime) * _decayValue;
+    
+    line.write(sample + (output * _feedback));
+    
+    return output;
+}
+
+double Delay::process(double sample)
+{
+    _modulate();
+    
+    return _dryWet(sample, _tick(sample));
+}
+
+void Delay::processBlock(double* block, std::size_t size)
+{
+    _modulate();
     
-    const_iterator read = _write - _readIntegral;
+    // Chunks must not be longer than the delay, else
+    // they would read samples they haven't written yet
+    const size_t chunkSize = std::min<size_t>(_chunkSize, static_cast<size_t>(_delayTime));
     
-    // Check if we need to wrap around
-    if (read < _buffer.begin())
+    if (! chunkSize)
     {
-        read += _buffer.size();
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            block[n] = _dryWet(block[n], _tick(block[n]));
+        }
+        
+        return;
     }
     
-    // If the read index is equal to the write index
-    // we need to first write the new sample and increment
-    if (! _readIntegral)
+    double delayed [_chunkSize];
+    
+    while (size)
     {
-        _writeAndIncrement(sample);
+        const size_t chunk = std::min<size_t>(size, chunkSize);
+        
+        _line.read(delayed, chunk, _delayTime);
+        
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            const double output = delayed[n] * _decayValue;
+            
+            // Re-use the delayed buffer for the samples to write
+            delayed[n] = block[n] + (output * _feedback);
+            
+            block[n] = _dryWet(block[n], output);
+        }
+        
+        _line.write(delayed, chunk);
+        
+        block += chunk;
+        
+        size -= chunk;
     }
+}
+
+void Delay::processStereo(double* left, double* right, std::size_t size)
+{
+    _modulate();
     
-    // First add integer part
-    double output = *read;
+    const size_t chunkSize = std::min<size_t>(_chunkSize, static_cast<size_t>(_delayTime));
     
-    // Check if the current read position is the beginning
-    // of the buffer (in which case incrementing means going
-    // to the last index), else the iterator is decremented
-    if (--read < _buffer.begin())
+    // Echoes shorter than a sample cannot alternate,
+    // so ping-pong makes no difference here
+    if (! chunkSize)
     {
-        read += _buffer.size();
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            left[n] = _dryWet(left[n], _tick(_line, left[n]));
+            
+            right[n] = _dryWet(right[n], _tick(_lineRight, right[n]));
+        }
+        
+        return;
     }
     
-    // And finally add the fractional part of the
-    // previous sample
-    output += (*read - output) * _readFractional;
+    double delayedLeft [_chunkSize];
+    double delayedRight [_chunkSize];
     
-    // Apply decay
-    output *= _decayValue;
-
-    // If the sample hasn't been written yet, write it now
-    if (_readIntegral)
+    while (size)
     {
-        _writeAndIncrement(sample + (output * _feedback));
+        const size_t chunk = std::min<size_t>(size, chunkSize);
+        
+        _line.read(delayedLeft, chunk, _delayTime);
+        
+        _lineRight.read(delayedRight, chunk, _delayTime);
+        
+        // Re-use the delayed buffers for the samples to write
+        if (_pingPong)
+        {
+            // The input enters the left line only, each line's
+            // output then feeds the other line, so that echoes
+            // alternate between the channels
+            for (size_t n = 0; n < chunk; ++n)
+            {
+                const double outputLeft = delayedLeft[n] * _decayValue;
+                const double outputRight = delayedRight[n] * _decayValue;
+                
+                delayedLeft[n] = (left[n] + right[n]) * 0.5 + (outputRight * _feedback);
+                delayedRight[n] = outputLeft;
+                
+                left[n] = _dryWet(left[n], outputLeft);
+                right[n] = _dryWet(right[n], outputRight);
+            }
+        }
+        
+        else
+        {
+            for (size_t n = 0; n < chunk; ++n)
+            {
+                const double outputLeft = delayedLeft[n] * _decayValue;
+                const double outputRight = delayedRight[n] * _decayValue;
+                
+                delayedLeft[n] = left[n] + (outputLeft * _feedback);
+                delayedRight[n] = right[n] + (outputRight * _feedback);
+                
+                left[n] = _dryWet(left[n], outputLeft);
+                right[n] = _dryWet(right[n], outputRight);
+            }
+        }
+        
+        _line.write(delayedLeft, chunk);
+        
+        _lineRight.write(delayedRight, chunk);
+        
+        left += chunk;
+        right += chunk;
+        
+        size -= chunk;
     }
+}
+
+void Delay::setPingPong(bool state)
+{
+    _pingPong = state;
+}
+
+bool Delay::isPingPong() const
+{
+    return _pingPong;
+}
+
+void AllPassDelay::processStereo(double* left, double* right, std::size_t size)
+{
+    _process(_line, left, size);
     
-    return _dryWet(sample, output);
+    _process(_lineRight, right, size);
+}
+
+AllPassDelay* AllPassDelay::clone() const
+{
+    return new AllPassDelay(*this, false);
 }
 
 double AllPassDelay::process(double sample)
 {
-    const_iterator read = _write - _readIntegral;
-    
-    // Check if we need to wrap around
-    if (read < _buffer.begin())
+    return _tick(_line, sample);
+}
+
+void AllPassDelay::processBlock(double* block, std::size_t size)
+{
+    _process(_line, block, size);
+}
+
+double AllPassDelay::_tick(DelayLine& line, double sample)
+{
+    // If the delay is shorter than a sample we
+    // need to first write the new sample
+    if (_delayTime < 1)
     {
-        read += _buffer.size();
+        line.write(sample);
+        
+        double outputA = line.read(_delayTime + 1);
+        
+        return outputA + ((sample - (outputA * _decayValue)) * _decayValue);
     }
     
-    // If the read index is equal to the write index
-    // we need to first write the new sample
-    if (! _readIntegral)
-    {
-        _writeAndIncrement(sample);
-    }
+    double outputA = line.read(_delayTime);
+    
+    double outputB = sample - (outputA * _decayValue);
+    
+    line.write(outputB);
     
-    // First add integer part
-    double outputA = *read;
+    return outputA + (outputB * _decayValue);
+}
+
+void AllPassDelay::_process(DelayLine& line, double* block, std::size_t size)
+{
+    const size_t chunkSize = std::min<size_t>(_chunkSize, static_cast<size_t>(_delayTime));
     
-    // Check if the current read position is the beginning
-    // of the buffer (in which case incrementing means going
-    // to the last index), else the iterator is decremented
-    if (read-- == _buffer.begin())
+    if (! chunkSize)
     {
-        read = _buffer.end() - 1;
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            block[n] = _tick(line, block[n]);
+        }
+        
+        return;
     }
     
-    // And finally add the fractional part of the
-    // previous sample
-    outputA += (*read - outputA) * _readFractional;
-    
-    double outputB = sample - (outputA * _decayValue);
+    double delayed [_chunkSize];
     
-    // If the sample hasn't been written yet, write it now
-    if (_readIntegral)
+    while (size)
     {
-        _writeAndIncrement(outputB);
+        const size_t chunk = std::min<size_t>(size, chunkSize);
+        
+        line.read(delayed, chunk, _delayTime);
+        
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            const double outputA = delayed[n];
+            
+            const double outputB = block[n] - (outputA * _decayValue);
+            
+            delayed[n] = outputB;
+            
+            block[n] = outputA + (outputB * _decayValue);
+        }
+        
+        line.write(delayed, chunk);
+        
+        block += chunk;
+        
+        size -= chunk;
     }
-    
-    return outputA + (outputB * _decayValue);
 }
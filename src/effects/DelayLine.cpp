@@ -0,0 +1,185 @@
+/********************************************************************************************//*!
+*
+*  @file        DelayLine.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "DelayLine.hpp"
+#include "Util.hpp"
+
+#include <algorithm>
+
+const DelayLine::size_t DelayLine::chunkSize;
+
+DelayLine::DelayLine(size_t capacity)
+{
+    resize(capacity);
+}
+
+void DelayLine::resize(size_t capacity)
+{
+    // Round up to the next power of two
+    size_t size = 1;
+
+    while (size < capacity) size <<= 1;
+
+    _buffer.assign(size, 0);
+
+    _mask = size - 1;
+
+    _write = 0;
+}
+
+DelayLine::size_t DelayLine::capacity() const
+{
+    return _buffer.size();
+}
+
+void DelayLine::clear()
+{
+    std::fill(_buffer.begin(), _buffer.end(), 0);
+}
+
+void DelayLine::write(double sample)
+{
+    _buffer[_write] = Util::flushDenormal(sample);
+
+    _write = (_write + 1) & _mask;
+}
+
+void DelayLine::write(const double* block, size_t size)
+{
+    // Copy up to the end of the buffer, then
+    // the rest (if any) to the beginning
+    const size_t first = std::min(size, _buffer.size() - _write);
+
+    std::transform(block, block + first, _buffer.begin() + _write, Util::flushDenormal);
+
+    std::transform(block + first, block + size, _buffer.begin(), Util::flushDenormal);
+
+    _write = (_write + size) & _mask;
+}
+
+double DelayLine::read(size_t delay) const
+{
+    return _buffer[(_write - delay) & _mask];
+}
+
+double DelayLine::read(double delay) const
+{
+    const size_t integral = static_cast<size_t>(delay);
+
+    const size_t index = (_write - integral) & _mask;
+
+    const double newer = _buffer[index];
+
+    // Interpolate towards the next older sample
+    return newer + (_buffer[(index - 1) & _mask] - newer) * (delay - integral);
+}
+
+void DelayLine::read(double* block, size_t size, double delay) const
+{
+    const size_t integral = static_cast<size_t>(delay);
+
+    const double fractional = delay - integral;
+
+    size_t index = (_write - integral) & _mask;
+
+    while (size)
+    {
+        // At the start of the buffer the older
+        // sample is at the end of the buffer
+        if (! index)
+        {
+            *block++ = _buffer[0] + (_buffer[_mask] - _buffer[0]) * fractional;
+
+            index = 1;
+
+            --size;
+
+            continue;
+        }
+
+        // Contiguous run up to the end of the buffer
+        const size_t run = std::min(size, _buffer.size() - index);
+
+        const double* newer = &_buffer[index];
+        const double* older = newer - 1;
+
+        for (size_t n = 0; n < run; ++n)
+        {
+            block[n] = newer[n] + (older[n] - newer[n]) * fractional;
+        }
+
+        block += run;
+
+        size -= run;
+
+        index = (index + run) & _mask;
+    }
+}
+
+void DelayLine::read(double* block,
+                     const double* delays,
+                     size_t size,
+                     unsigned short interpolation) const
+{
+    size_t indices [chunkSize];
+    double fractions [chunkSize];
+
+    for (size_t offset = 0; offset < size; offset += chunkSize)
+    {
+        const size_t chunk = std::min<size_t>(size - offset, chunkSize);
+
+        const double* chunkDelays = delays + offset;
+
+        double* output = block + offset;
+
+        // Positions and weights first, so that this loop
+        // has no memory accesses into the delay line
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            const size_t integral = static_cast<size_t>(chunkDelays[n]);
+
+            indices[n] = _write + offset + n - integral;
+
+            fractions[n] = chunkDelays[n] - integral;
+        }
+
+        if (interpolation == CUBIC)
+        {
+            for (size_t n = 0; n < chunk; ++n)
+            {
+                // The sample one newer, the sample at the position
+                // and the two older samples to interpolate towards
+                const double a = _buffer[(indices[n] + 1) & _mask];
+                const double b = _buffer[indices[n] & _mask];
+                const double c = _buffer[(indices[n] - 1) & _mask];
+                const double d = _buffer[(indices[n] - 2) & _mask];
+
+                const double t = fractions[n];
+
+                // Catmull-Rom (Hermite) polynomial
+                const double c1 = 0.5 * (c - a);
+                const double c2 = a - 2.5 * b + 2 * c - 0.5 * d;
+                const double c3 = 0.5 * (d - a) + 1.5 * (b - c);
+
+                output[n] = ((c3 * t + c2) * t + c1) * t + b;
+            }
+        }
+
+        else
+        {
+            for (size_t n = 0; n < chunk; ++n)
+            {
+                const double newer = _buffer[indices[n] & _mask];
+
+                output[n] = newer + (_buffer[(indices[n] - 1) & _mask] - newer) * fractions[n];
+            }
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #include "Echo.hpp"
 
+#include <algorithm>
+
 Echo::Echo(double delayLength,
            double decayTime,
            double decayRate,
@@ -8,14 +10,75 @@ Echo::Echo(double delayLength,
 : Delay(delayLength,decayTime,decayRate,feedbackLevel,capacity)
 { }
 
+Echo::Echo(const Echo& other, bool copySamples)
+: Delay(other, copySamples)
+{ }
+
 Echo::~Echo()
 {
     
 }
 
+Echo* Echo::clone() const
+{
+    return new Echo(*this, false);
+}
+
 double Echo::process(double sample)
 {
     double output = sample + Delay::process(sample);
     
     return _dryWet(sample, output);
 }
+
+void Echo::processStereo(double* left, double* right, std::size_t size)
+{
+    double inputLeft [_chunkSize];
+    double inputRight [_chunkSize];
+    
+    while (size)
+    {
+        const size_t chunk = std::min<size_t>(size, _chunkSize);
+        
+        // Keep the input to sum it with the delay's output
+        std::copy(left, left + chunk, inputLeft);
+        std::copy(right, right + chunk, inputRight);
+        
+        Delay::processStereo(left, right, chunk);
+        
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            left[n] = _dryWet(inputLeft[n], inputLeft[n] + left[n]);
+            right[n] = _dryWet(inputRight[n], inputRight[n] + right[n]);
+        }
+        
+        left += chunk;
+        right += chunk;
+        
+        size -= chunk;
+    }
+}
+
+void Echo::processBlock(double* block, std::size_t size)
+{
+    double input [_chunkSize];
+    
+    while (size)
+    {
+        const size_t chunk = std::min<size_t>(size, _chunkSize);
+        
+        // Keep the input to sum it with the delay's output
+        std::copy(block, block + chunk, input);
+        
+        Delay::processBlock(block, chunk);
+        
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            block[n] = _dryWet(input[n], input[n] + block[n]);
+        }
+        
+        block += chunk;
+        
+        size -= chunk;
+    }
+}
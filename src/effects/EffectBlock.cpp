@@ -1,23 +1,19 @@
 #include "EffectBlock.hpp"
-#include "Units.hpp"
 #include "Reverb.hpp"
 #include "Flanger.hpp"
 #include "Delay.hpp"
 #include "Echo.hpp"
+#include "ConvolutionReverb.hpp"
+#include "Chorus.hpp"
 
 #include <stdexcept>
 
+const unsigned short EffectBlock::maxDelayTime;
+
 EffectBlock::EffectBlock(unsigned short effect)
-: _reverb(new Reverb),
-  _delay(new Delay),
-  _echo(new Echo),
-  _flanger(new Flanger),
-  _active(false)
+: _curr(nullptr)
 {
-    _delay->setActive(true);
-    _echo->setActive(true);
-    _reverb->setActive(true);
-    _flanger->setActive(true);
+    setEffectType(effect);
 }
 
 EffectBlock::~EffectBlock()
@@ -25,42 +21,126 @@ EffectBlock::~EffectBlock()
 
 double EffectBlock::process(double sample)
 {
-    if (! _active) return sample;
-    
     if (! _curr)
     { throw std::invalid_argument("Effect is currently NONE!"); }
     
     return _curr->process(sample);
 }
 
-Delay& EffectBlock::delay() const
+void EffectBlock::processBlock(double* block, std::size_t size)
+{
+    if (! _curr)
+    { throw std::invalid_argument("Effect is currently NONE!"); }
+    
+    _curr->processBlock(block, size);
+}
+
+void EffectBlock::processStereo(double* left, double* right, std::size_t size)
+{
+    if (! _curr)
+    { throw std::invalid_argument("Effect is currently NONE!"); }
+    
+    _curr->processStereo(left, right, size);
+}
+
+std::size_t EffectBlock::getTailLength() const
+{
+    return _curr ? _curr->getTailLength() : 0;
+}
+
+EffectBlock* EffectBlock::clone() const
 {
+    EffectBlock* block = new EffectBlock;
+    
+    block->EffectUnit::operator=(*this);
+    
+    if (_delay) block->_delay.reset(_delay->clone());
+    
+    if (_echo) block->_echo.reset(_echo->clone());
+    
+    if (_reverb) block->_reverb.reset(_reverb->clone());
+    
+    if (_flanger) block->_flanger.reset(_flanger->clone());
+    
+    if (_convolution) block->_convolution.reset(_convolution->clone());
+    
+    if (_chorus) block->_chorus.reset(_chorus->clone());
+    
+    block->setEffectType(_effectType);
+    
+    return block;
+}
+
+Delay& EffectBlock::delay()
+{
+    if (! _delay)
+    {
+        _delay = Arena::make<Delay>(1, 4, 0.001, 0, maxDelayTime);
+        
+        _delay->setActive(true);
+    }
+    
     return *_delay;
 }
 
-Echo& EffectBlock::echo() const
+Echo& EffectBlock::echo()
 {
+    if (! _echo)
+    {
+        _echo = Arena::make<Echo>(1, 4, 0.01, 1, maxDelayTime);
+        
+        _echo->setActive(true);
+    }
+    
     return *_echo;
 }
 
-Reverb& EffectBlock::reverb() const
+Reverb& EffectBlock::reverb()
 {
+    if (! _reverb)
+    {
+        _reverb = Arena::make<Reverb>();
+        
+        _reverb->setActive(true);
+    }
+    
     return *_reverb;
 }
 
-Flanger& EffectBlock::flanger() const
+Flanger& EffectBlock::flanger()
 {
+    if (! _flanger)
+    {
+        _flanger = Arena::make<Flanger>();
+        
+        _flanger->setActive(true);
+    }
+    
     return *_flanger;
 }
 
-void EffectBlock::setActive(bool state)
+ConvolutionReverb& EffectBlock::convolution()
 {
-    _active = state;
+    if (! _convolution)
+    {
+        _convolution = Arena::make<ConvolutionReverb>();
+        
+        _convolution->setActive(true);
+    }
+    
+    return *_convolution;
 }
 
-bool EffectBlock::isActive() const
+Chorus& EffectBlock::chorus()
 {
-    return _active;
+    if (! _chorus)
+    {
+        _chorus = Arena::make<Chorus>();
+        
+        _chorus->setActive(true);
+    }
+    
+    return *_chorus;
 }
 
 void EffectBlock::setEffectType(unsigned short effectType)
@@ -72,19 +152,27 @@ void EffectBlock::setEffectType(unsigned short effectType)
             break;
             
         case DELAY:
-            _curr = &(*_delay);
+            _curr = &delay();
             break;
             
         case ECHO:
-            _curr = &(*_echo);
+            _curr = &echo();
             break;
             
         case REVERB:
-            _curr = &(*_reverb);
+            _curr = &reverb();
             break;
             
         case FLANGER:
-            _curr = &(*_flanger);
+            _curr = &flanger();
+            break;
+            
+        case CONVOLUTION:
+            _curr = &convolution();
+            break;
+            
+        case CHORUS:
+            _curr = &chorus();
             break;
     }
     
@@ -0,0 +1,191 @@
+/********************************************************************************************//*!
+*
+*  @file        EffectChain.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "EffectChain.hpp"
+#include "Units.hpp"
+
+#include <stdexcept>
+#include <thread>
+
+EffectChain::EffectChain()
+: _live(new chain_t),
+  _hazard(nullptr)
+{ }
+
+EffectChain::~EffectChain()
+{
+    delete _live.load();
+}
+
+bool EffectChain::process(double* left, double* right, std::size_t size, bool silent)
+{
+    chain_t* chain = _live.load();
+    
+    // Announce the chain before using it. If it was replaced in
+    // the meantime, the editing thread may not have seen the
+    // announcement, so announce the new one instead
+    for (;;)
+    {
+        _hazard.store(chain);
+        
+        chain_t* current = _live.load();
+        
+        if (current == chain) break;
+        
+        chain = current;
+    }
+    
+    for (chain_t::iterator itr = chain->begin(), end = chain->end();
+         itr != end;
+         ++itr)
+    {
+        if ((*itr)->isActive())
+        {
+            silent = (*itr)->render(left, right, size, silent);
+        }
+    }
+    
+    _hazard.store(nullptr);
+    
+    return silent;
+}
+
+void EffectChain::addUnit(EffectUnit* unit)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    if (! unit)
+    { throw std::invalid_argument("Cannot add a null unit to an EffectChain!"); }
+    
+    _slots.push_back(Slot(unit));
+    
+    _rebuild();
+}
+
+void EffectChain::insertUnit(size_t index, EffectUnit* unit)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    if (! unit)
+    { throw std::invalid_argument("Cannot add a null unit to an EffectChain!"); }
+    
+    if (index > _slots.size())
+    { throw std::out_of_range("Invalid EffectChain slot!"); }
+    
+    _slots.insert(_slots.begin() + index, Slot(unit));
+    
+    _rebuild();
+}
+
+void EffectChain::removeUnit(size_t index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _check(index);
+    
+    _slots.erase(_slots.begin() + index);
+    
+    _rebuild();
+}
+
+void EffectChain::moveUnit(size_t from, size_t to)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _check(from);
+    
+    _check(to);
+    
+    const Slot slot = _slots[from];
+    
+    _slots.erase(_slots.begin() + from);
+    
+    _slots.insert(_slots.begin() + to, slot);
+    
+    _rebuild();
+}
+
+EffectUnit* EffectChain::getUnit(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _check(index);
+    
+    return _slots[index].unit;
+}
+
+void EffectChain::setBypassed(size_t index, bool state)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _check(index);
+    
+    if (_slots[index].bypassed == state) return;
+    
+    _slots[index].bypassed = state;
+    
+    _rebuild();
+}
+
+bool EffectChain::isBypassed(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _check(index);
+    
+    return _slots[index].bypassed;
+}
+
+EffectChain::size_t EffectChain::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    return _slots.size();
+}
+
+void EffectChain::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    _slots.clear();
+    
+    _rebuild();
+}
+
+void EffectChain::_check(size_t index) const
+{
+    if (index >= _slots.size())
+    { throw std::out_of_range("Invalid EffectChain slot!"); }
+}
+
+void EffectChain::_rebuild()
+{
+    chain_t* chain = new chain_t;
+    
+    chain->reserve(_slots.size());
+    
+    for (std::vector<Slot>::const_iterator itr = _slots.begin(), end = _slots.end();
+         itr != end;
+         ++itr)
+    {
+        if (! itr->bypassed) chain->push_back(itr->unit);
+    }
+    
+    chain_t* old = _live.exchange(chain);
+    
+    // Wait for the audio thread to finish the block it
+    // may be processing with the old chain, at most one
+    while (_hazard.load() == old)
+    {
+        std::this_thread::yield();
+    }
+    
+    delete old;
+}
@@ -11,24 +11,32 @@
 #include "Filter.hpp"
 #include "Global.hpp"
 #include "Util.hpp"
+#include "FastMath.hpp"
 #include "ModDock.hpp"
 
 #include <stdexcept>
 #include <cmath>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANTHEM_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
 Filter::Filter(unsigned short mode,
                double cutoff,
                double q,
                double gain)
-: EffectUnit(4,1),_delayA(0), _delayB(0),
-  _cutoff(cutoff), _q(q), _mode(mode)
+: EffectUnit(4,1), _mode(mode),
+  _cutoff(cutoff), _q(q),
+  _delayA(0), _delayB(0),
+  _delayRightA(0), _delayRightB(0)
 {
     setGain(gain);
     
     // Initial coefficients
     _calcCoefs();
     
-    _mods[CUTOFF].setHigherBoundary(Global::nyquistLimit);
+    _mods[CUTOFF].setHigherBoundary(_context->getNyquistLimit());
     _mods[CUTOFF].setLowerBoundary(0);
     _mods[CUTOFF].setBaseValue(cutoff);
     
@@ -45,6 +53,17 @@ Filter::Filter(unsigned short mode,
     _mods[DRYWET].setBaseValue(1);
 }
 
+Filter* Filter::clone() const
+{
+    Filter* filter = new Filter(*this);
+    
+    filter->_delayA = filter->_delayB = 0;
+    
+    filter->_delayRightA = filter->_delayRightB = 0;
+    
+    return filter;
+}
+
 void Filter::setDryWet(double dw)
 {
     // For error checking
@@ -63,7 +82,7 @@ double Filter::getDryWet() const
     else return _dw;
 }
 
-double Filter::process(double sample)
+void Filter::_modulate()
 {
     if (_mods[CUTOFF].inUse() ||
         _mods[Q].inUse()      ||
@@ -96,6 +115,11 @@ double Filter::process(double sample)
     {
         _dw = _mods[DRYWET].tick();
     }
+}
+
+double Filter::process(double sample)
+{
+    _modulate();
     
     double temp = sample
                 - (coefA1_ * _delayA)
@@ -108,20 +132,105 @@ double Filter::process(double sample)
     
     // Store values into delay line
     _delayB = _delayA;
-    _delayA = temp;
+    _delayA = Util::flushDenormal(temp);
     
     output *= _amp;
     
     return _dryWet(sample, output);
 }
 
+void Filter::processStereo(double* left, double* right, std::size_t size)
+{
+#if defined(ANTHEM_FILTER_SSE2)
+    
+    // The left channel in the low lane, the right one in the high lane
+    __m128d delayA = _mm_set_pd(_delayRightA, _delayA);
+    __m128d delayB = _mm_set_pd(_delayRightB, _delayB);
+    
+    const __m128d sign = _mm_set1_pd(-0.0);
+    
+    const __m128d threshold = _mm_set1_pd(1e-15);
+    
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        _modulate();
+        
+        const __m128d input = _mm_set_pd(right[n], left[n]);
+        
+        // Both channels share the coefficients, each has its own state
+        const __m128d temp = _mm_sub_pd(_mm_sub_pd(input, _mm_mul_pd(_mm_set1_pd(coefA1_), delayA)),
+                                        _mm_mul_pd(_mm_set1_pd(coefA2_), delayB));
+        
+        const __m128d output = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(coefB0_), temp),
+                                                     _mm_mul_pd(_mm_set1_pd(coefB1_), delayA)),
+                                          _mm_mul_pd(_mm_set1_pd(coefB2_), delayB));
+        
+        delayB = delayA;
+        
+        // Util::flushDenormal() for both lanes
+        const __m128d tiny = _mm_cmplt_pd(_mm_andnot_pd(sign, temp), threshold);
+        
+        delayA = _mm_andnot_pd(tiny, temp);
+        
+        // Same operations as _dryWet(), in the same order
+        const __m128d mixed = _mm_add_pd(_mm_mul_pd(input, _mm_set1_pd(1 - _dw)),
+                                         _mm_mul_pd(_mm_mul_pd(output, _mm_set1_pd(_amp)), _mm_set1_pd(_dw)));
+        
+        _mm_storel_pd(left + n, mixed);
+        
+        _mm_storeh_pd(right + n, mixed);
+    }
+    
+    _mm_storel_pd(&_delayA, delayA);
+    _mm_storeh_pd(&_delayRightA, delayA);
+    
+    _mm_storel_pd(&_delayB, delayB);
+    _mm_storeh_pd(&_delayRightB, delayB);
+    
+#else
+    
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        _modulate();
+        
+        // Both channels share the coefficients, each has its own state
+        const double tempLeft = left[n]
+                              - (coefA1_ * _delayA)
+                              - (coefA2_ * _delayB);
+        
+        const double tempRight = right[n]
+                               - (coefA1_ * _delayRightA)
+                               - (coefA2_ * _delayRightB);
+        
+        const double outputLeft = (coefB0_ * tempLeft)
+                                + (coefB1_ * _delayA)
+                                + (coefB2_ * _delayB);
+        
+        const double outputRight = (coefB0_ * tempRight)
+                                 + (coefB1_ * _delayRightA)
+                                 + (coefB2_ * _delayRightB);
+        
+        _delayB = _delayA;
+        _delayA = Util::flushDenormal(tempLeft);
+        
+        _delayRightB = _delayRightA;
+        _delayRightA = Util::flushDenormal(tempRight);
+        
+        left[n] = _dryWet(left[n], outputLeft * _amp);
+        
+        right[n] = _dryWet(right[n], outputRight * _amp);
+    }
+    
+#endif
+}
+
 void Filter::_calcCoefs()
 {
-    double omega = (Global::twoPi / Global::samplerate) * _cutoff;
+    double omega = (Global::twoPi / _context->getSamplerate()) * _cutoff;
     
-    double cosine = cos(omega);
+    double cosine = FastMath::cos(omega);
     
-    double sine = sin(omega);
+    double sine = FastMath::sin(omega);
     
     double alpha = sine / (2.0 * _q);
     
@@ -181,7 +290,7 @@ void Filter::_calcCoefs()
             
         case PEAK:
         {
-            double A = pow(10, (_gain/40));
+            double A = FastMath::dbToAmp(_gain / 2);
         
             b0 = 1 + (alpha * A);
             b2 = 1 - (alpha * A);
@@ -194,7 +303,7 @@ void Filter::_calcCoefs()
 
         case LOW_SHELF:
         {
-            double A = pow(10, (_gain/40));
+            double A = FastMath::dbToAmp(_gain / 2);
             
             double temp = 2 * sqrt(A) * alpha;
             
@@ -211,7 +320,7 @@ void Filter::_calcCoefs()
             
         case HIGH_SHELF:
         {
-            double A = pow(10, (_gain/40));
+            double A = FastMath::dbToAmp(_gain / 2);
             
             double temp = 2 * sqrt(A) * alpha;
             
@@ -252,7 +361,7 @@ unsigned short Filter::getMode() const
 
 void Filter::setCutoff(double cutoff)
 {
-    if (cutoff < 0 || cutoff > Global::nyquistLimit)
+    if (cutoff < 0 || cutoff > _context->getNyquistLimit())
     { throw std::invalid_argument("Cutoff out of range, must be between 0 and nyquist limit (20 Khz)"); }
     
     if (_mods[CUTOFF].inUse())
@@ -1,10 +1,14 @@
 #include "Flanger.hpp"
 #include "LFO.hpp"
-#include "Delay.hpp"
 #include "Global.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
+const double Flanger::maxDelay = 0.05;
+
+const std::size_t Flanger::_chunkSize;
+
 Flanger::Flanger(double center,
                  double depth,
                  double rate,
@@ -12,18 +16,33 @@ Flanger::Flanger(double center,
 : EffectUnit(),
   _center(center),
   _feedback(feedback),
-  _lfo(new LFO(WavetableDatabase::SINE,rate,depth)),
-  _delay(new Delay(center,0,0,0,1))
+  _length(center * _context->getSamplerate()),
+  _lengthRight(_length),
+  _lfo(Arena::make<LFO>(WavetableDatabase::SINE,rate,depth)),
+  // In quadrature, so the channels sweep against each other
+  _lfoRight(Arena::make<LFO>(WavetableDatabase::SINE,rate,depth,90)),
+  // Two samples of headroom for interpolation
+  _line(static_cast<DelayLine::size_t>(maxDelay * _context->getSamplerate()) + 2),
+  _lineRight(_line.capacity())
 {
+    if (center + depth > maxDelay)
+    { throw std::invalid_argument("Flanger center plus depth cannot exceed the maximum delay!"); }
+    
     _lfo->setActive(true);
+    
+    _lfoRight->setActive(true);
 }
 
-Flanger::Flanger(const Flanger& other)
+Flanger::Flanger(const Flanger& other, bool copySamples)
 : EffectUnit(other),
   _center(other._center),
   _feedback(other._feedback),
-  _lfo(new LFO(*other._lfo)),
-  _delay(new Delay(*other._delay))
+  _length(other._length),
+  _lengthRight(other._lengthRight),
+  _lfo(Arena::make<LFO>(*other._lfo)),
+  _lfoRight(Arena::make<LFO>(*other._lfoRight)),
+  _line(copySamples ? other._line : DelayLine(other._line.capacity())),
+  _lineRight(copySamples ? other._lineRight : DelayLine(other._lineRight.capacity()))
 { }
 
 Flanger::~Flanger()
@@ -31,6 +50,11 @@ Flanger::~Flanger()
     
 }
 
+Flanger* Flanger::clone() const
+{
+    return new Flanger(*this, false);
+}
+
 Flanger& Flanger::operator= (const Flanger& other)
 {
     if (this != &other)
@@ -41,9 +65,17 @@ Flanger& Flanger::operator= (const Flanger& other)
         
         _feedback = other._feedback;
         
+        _length = other._length;
+        
+        _lengthRight = other._lengthRight;
+        
         *_lfo = *other._lfo;
         
-        *_delay = *other._delay;
+        *_lfoRight = *other._lfoRight;
+        
+        _line = other._line;
+        
+        _lineRight = other._lineRight;
     }
     
     return *this;
@@ -52,6 +84,8 @@ Flanger& Flanger::operator= (const Flanger& other)
 void Flanger::setRate(double rate)
 {
     _lfo->setFrequency(rate);
+    
+    _lfoRight->setFrequency(rate);
 }
 
 double Flanger::getRate() const
@@ -61,9 +95,10 @@ double Flanger::getRate() const
 
 void Flanger::setCenter(double center)
 {
-    _center = center;
+    if (center + getDepth() > maxDelay)
+    { throw std::invalid_argument("Flanger center plus depth cannot exceed the maximum delay!"); }
     
-    _delay->setDelayTime(_center);
+    _center = center;
 }
 
 double Flanger::getCenter() const
@@ -73,7 +108,12 @@ double Flanger::getCenter() const
 
 void Flanger::setDepth(double depth)
 {
+    if (_center + depth > maxDelay)
+    { throw std::invalid_argument("Flanger center plus depth cannot exceed the maximum delay!"); }
+    
     _lfo->setAmp(depth);
+    
+    _lfoRight->setAmp(depth);
 }
 
 double Flanger::getDepth() const
@@ -90,29 +130,156 @@ void Flanger::setFeedback(double feedback)
 }
 
 double Flanger::process(double sample)
+{
+    return _tick(sample, *_lfo, _line, _length);
+}
+
+double Flanger::_tick(double sample, LFO& lfo, DelayLine& line, double& length)
 {
     double output = sample;
     
     // Check for feedback
     if (_feedback)
     {
-        output -= _delay->offset(_center) * _feedback;
+        output -= line.read(_center * _context->getSamplerate()) * _feedback;
     }
     
     // Calculate new length by modulation. Modulation
     // depth and maximum are 1 because the LFO's amplitude
-    // is the delay depth value
-    double length = _lfo->modulate(_center, 1, 1);
+    // is the delay depth value. Kept in length so that
+    // processBlock() can ramp from here
+    length = lfo.modulate(_center, 1, 1) * _context->getSamplerate();
     
     // Increment LFO
-    _lfo->update();
+    lfo.update();
     
-    // Set the new length
-    _delay->setDelayTime(length);
+    // If the delay is shorter than a sample we
+    // need to first write the new sample
+    if (length < 1)
+    {
+        line.write(output);
+        
+        output += line.read(length + 1);
+    }
     
-    // Retrieve new sample
-    output += _delay->process(output);
+    else
+    {
+        double delayed = line.read(length);
+        
+        line.write(output);
+        
+        output += delayed;
+    }
     
     // Apply dry/wet
     return _dryWet(sample, output);
 }
+
+std::size_t Flanger::getTailLength() const
+{
+    return static_cast<std::size_t>((_center + getDepth()) * _context->getSamplerate()) + 2;
+}
+
+void Flanger::processBlock(double* block, std::size_t size)
+{
+    // The shortest delay the LFO can produce, chunks must
+    // not be longer or they would read unwritten samples
+    const double shortest = (_center - getDepth()) * _context->getSamplerate();
+    
+    if (shortest < 1)
+    {
+        EffectUnit::processBlock(block, size);
+        
+        return;
+    }
+    
+    const std::size_t chunkSize = std::min<std::size_t>(_chunkSize, static_cast<std::size_t>(shortest));
+    
+    _processChannel(block, size, chunkSize, *_lfo, _line, _length);
+}
+
+void Flanger::processStereo(double* left, double* right, std::size_t size)
+{
+    const double shortest = (_center - getDepth()) * _context->getSamplerate();
+    
+    if (shortest < 1)
+    {
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            left[n] = _tick(left[n], *_lfo, _line, _length);
+            
+            right[n] = _tick(right[n], *_lfoRight, _lineRight, _lengthRight);
+        }
+        
+        return;
+    }
+    
+    const std::size_t chunkSize = std::min<std::size_t>(_chunkSize, static_cast<std::size_t>(shortest));
+    
+    _processChannel(left, size, chunkSize, *_lfo, _line, _length);
+    
+    _processChannel(right, size, chunkSize, *_lfoRight, _lineRight, _lengthRight);
+}
+
+void Flanger::_processChannel(double* block,
+                              std::size_t size,
+                              std::size_t chunkSize,
+                              LFO& lfo,
+                              DelayLine& line,
+                              double& length)
+{
+    const double center = _center * _context->getSamplerate();
+    
+    double lengths [_chunkSize];
+    double delayed [_chunkSize];
+    double feedback [_chunkSize];
+    
+    // The last delay time may be shorter if the
+    // center or depth changed since the last block
+    length = std::max<double>(length, chunkSize);
+    
+    while (size)
+    {
+        const std::size_t chunk = std::min<std::size_t>(size, chunkSize);
+        
+        // The LFO is only evaluated at the end of each chunk,
+        // the delay time ramps linearly towards that value
+        lfo.advance(chunk);
+        
+        double target = lfo.modulate(_center, 1, 1) * _context->getSamplerate();
+        
+        target = std::max<double>(target, chunkSize);
+        
+        const double step = (target - length) / chunk;
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            lengths[n] = length + step * (n + 1);
+        }
+        
+        length = target;
+        
+        line.read(delayed, lengths, chunk);
+        
+        if (_feedback)
+        {
+            line.read(feedback, chunk, center);
+        }
+        
+        else std::fill(feedback, feedback + chunk, 0);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            // Re-use the feedback buffer for the samples to write
+            feedback[n] = block[n] - feedback[n] * _feedback;
+            
+            block[n] = _dryWet(block[n], feedback[n] + delayed[n]);
+        }
+        
+        line.write(feedback, chunk);
+        
+        block += chunk;
+        
+        size -= chunk;
+    }
+}
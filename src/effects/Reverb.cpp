@@ -13,36 +13,58 @@
 #include "LFO.hpp"
 #include "Global.hpp"
 #include "ModDock.hpp"
+#include "FastMath.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 
-Reverb::Reverb(double reverbTime, double reverbRate, double dryWet)
+const std::size_t Reverb::_chunkSize;
+
+const unsigned short Reverb::_fdnSize;
+
+Reverb::Reverb(double reverbTime,
+               double reverbRate,
+               double dryWet,
+               unsigned short mode)
 : EffectUnit(3),
-  _delays(new Delay[4]),
-  _allPasses(new AllPassDelay [2])
+  _mode(SCHROEDER),
+  _reverbTime(reverbTime),
+  _reverbRate(reverbRate),
+  // The delay lines never change length, so only allocate
+  // memory for their actual delay time rather than the default
+  _delays {
+      Delay(0.0437), Delay(0.0411), Delay(0.0371), Delay(0.0297)
+  },
+  // The second pair, slightly detuned, decorrelates the right channel
+  _allPasses {
+      AllPassDelay(0.09638, 0.0050), AllPassDelay(0.03292, 0.0017),
+      AllPassDelay(0.09109, 0.0050), AllPassDelay(0.03497, 0.0017)
+  }
 {
     for (unsigned short i = 0; i < 4; ++i)
     {
-        if (i < 2) _allPasses[i].setActive(true);
+        _allPasses[i].setActive(true);
         
         _delays[i].setActive(true);
     }
     
-    _delays[0].setDelayTime(0.0437);
-    _delays[1].setDelayTime(0.0411);
-    _delays[2].setDelayTime(0.0371);
-    _delays[3].setDelayTime(0.0297);
-    
-    _allPasses[0].setDecayTime(0.0050);
-    _allPasses[0].setDelayTime(0.09638);
+    // FDN delay line lengths, in milliseconds. Mutually prime
+    // (in samples at 44.1 and 48 kHz) so that echoes don't pile up
+    static const double lengths [_fdnSize] =
+    {
+        29.7, 37.1, 41.1, 43.7, 53.3, 59.9, 67.1, 73.1
+    };
     
-    _allPasses[1].setDecayTime(0.0017);
-    _allPasses[1].setDelayTime(0.03292);
+    for (unsigned short i = 0; i < _fdnSize; ++i)
+    {
+        _lengths[i] = static_cast<DelayLine::size_t>(lengths[i] * _context->getSamplerate() / 1000.0);
+    }
     
     setReverbTime(reverbTime);
     setReverbRate(reverbRate);
     setDryWet(dryWet);
+    setMode(mode);
     
     // Initialize ModDocks
     _mods[REVERB_RATE].setHigherBoundary(1);
@@ -58,23 +80,41 @@ Reverb::Reverb(double reverbTime, double reverbRate, double dryWet)
     _mods[DRYWET].setBaseValue(dryWet);
 }
 
-Reverb::Reverb(const Reverb& other)
+Reverb::Reverb(const Reverb& other, bool copySamples)
 : EffectUnit(other),
-  _delays(new Delay [4]),
-  _allPasses(new AllPassDelay [2]),
+  _delays {
+      Delay(other._delays[0], copySamples), Delay(other._delays[1], copySamples),
+      Delay(other._delays[2], copySamples), Delay(other._delays[3], copySamples)
+  },
+  _allPasses {
+      AllPassDelay(other._allPasses[0], copySamples), AllPassDelay(other._allPasses[1], copySamples),
+      AllPassDelay(other._allPasses[2], copySamples), AllPassDelay(other._allPasses[3], copySamples)
+  },
+  _mode(other._mode),
   _reverbRate(other._reverbRate),
   _reverbTime(other._reverbTime),
   _attenuation(other._attenuation)
 {
-    for (unsigned short i = 0; i < 4; ++i)
+    if (other._lines)
     {
-        if (i < 2)
+        _lines = Arena::makeArray<DelayLine>(_fdnSize);
+        
+        for (unsigned short i = 0; i < _fdnSize; ++i)
         {
-            _allPasses[i] = other._allPasses[i];
+            if (copySamples) _lines[i] = other._lines[i];
+            
+            else _lines[i].resize(other._lines[i].capacity());
         }
-        
-        _delays[i] = other._delays[i];
     }
+    
+    std::copy(other._lengths, other._lengths + _fdnSize, _lengths);
+    
+    std::copy(other._gains, other._gains + _fdnSize, _gains);
+}
+
+Reverb* Reverb::clone() const
+{
+    return new Reverb(*this, false);
 }
 
 Reverb& Reverb::operator= (const Reverb& other)
@@ -89,12 +129,22 @@ Reverb& Reverb::operator= (const Reverb& other)
         
         _attenuation = other._attenuation;
         
+        _mode = other._mode;
+        
+        if (other._lines)
+        {
+            if (! _lines) _lines = Arena::makeArray<DelayLine>(_fdnSize);
+            
+            std::copy(other._lines.get(), other._lines.get() + _fdnSize, _lines.get());
+        }
+        
+        std::copy(other._lengths, other._lengths + _fdnSize, _lengths);
+        
+        std::copy(other._gains, other._gains + _fdnSize, _gains);
+        
         for (unsigned short i = 0; i < 4; ++i)
         {
-            if (i < 2)
-            {
-                _allPasses[i] = other._allPasses[i];
-            }
+            _allPasses[i] = other._allPasses[i];
             
             _delays[i] = other._delays[i];
         }
@@ -128,16 +178,20 @@ double Reverb::getDryWet() const
     else return _dw;
 }
 
-double Reverb::process(double sample)
+void Reverb::_modulate()
 {
+    bool changed = false;
+    
     // Modulate time
     if (_mods[REVERB_TIME].inUse())
     {
         double newReverbTime = _mods[REVERB_TIME].tick();
         
-        for (unsigned short i = 0; i < 4; ++i)
+        if (newReverbTime != _reverbTime)
         {
-            _delays[i].setDecayTime(newReverbTime);
+            _reverbTime = newReverbTime;
+            
+            changed = true;
         }
     }
     
@@ -146,17 +200,85 @@ double Reverb::process(double sample)
     {
         double newReverbRate = _mods[REVERB_RATE].tick();
         
-        for (unsigned short i = 0; i < 4; ++i)
+        if (newReverbRate != _reverbRate)
         {
-            _delays[i].setDecayRate(newReverbRate);
+            _reverbRate = newReverbRate;
+            
+            changed = true;
         }
     }
     
+    // Only recompute the decay if something changed
+    if (changed) _calcDecay();
+    
     // Modulate the dry/wet
     if (_mods[DRYWET].inUse())
     {
         _dw = _mods[DRYWET].tick();
     }
+}
+
+void Reverb::_calcDecay()
+{
+    for (unsigned short i = 0; i < 4; ++i)
+    {
+        _delays[i].setDecayTime(_reverbTime);
+        _delays[i].setDecayRate(_reverbRate);
+    }
+    
+    // Each pass through an FDN line attenuates by the decay rate
+    // raised to the fraction of the reverb time the line is long.
+    // The 1/sqrt(N) normalization of the Hadamard matrix is
+    // folded into the gains
+    const double norm = 1 / std::sqrt(static_cast<double>(_fdnSize));
+    
+    const double samples = _reverbTime * _context->getSamplerate();
+    
+    for (unsigned short i = 0; i < _fdnSize; ++i)
+    {
+        if (samples > 0)
+        {
+            _gains[i] = FastMath::pow(_reverbRate, _lengths[i] / samples) * norm;
+        }
+        
+        else _gains[i] = 0;
+    }
+}
+
+void Reverb::setMode(unsigned short mode)
+{
+    if (mode > FDN)
+    { throw std::invalid_argument("Invalid reverb mode!"); }
+    
+    if (mode == FDN && ! _lines)
+    {
+        _lines = Arena::makeArray<DelayLine>(_fdnSize);
+        
+        for (unsigned short i = 0; i < _fdnSize; ++i)
+        {
+            // The line is read before it is written
+            _lines[i].resize(_lengths[i] + 1);
+        }
+    }
+    
+    _mode = mode;
+}
+
+unsigned short Reverb::getMode() const
+{
+    return _mode;
+}
+
+double Reverb::process(double sample)
+{
+    if (_mode == FDN)
+    {
+        processBlock(&sample, 1);
+        
+        return sample;
+    }
+    
+    _modulate();
     
     sample *= _attenuation;
     
@@ -172,6 +294,239 @@ double Reverb::process(double sample)
     return _dryWet(sample, output);
 }
 
+std::size_t Reverb::getTailLength() const
+{
+    std::size_t length = 0;
+    
+    if (_mode == FDN)
+    {
+        for (unsigned short i = 0; i < _fdnSize; ++i)
+        {
+            length = std::max<std::size_t>(length, _lengths[i]);
+        }
+        
+        return length + 1;
+    }
+    
+    // The longest comb filter, then both all-pass filters
+    for (unsigned short i = 0; i < 4; ++i)
+    {
+        length = std::max(length, _delays[i].getTailLength());
+    }
+    
+    return length + _allPasses[0].getTailLength() + _allPasses[1].getTailLength();
+}
+
+void Reverb::processBlock(double* block, std::size_t size)
+{
+    _modulate();
+    
+    double input [_chunkSize];
+    double output [_chunkSize];
+    
+    while (size)
+    {
+        const std::size_t chunk = std::min<std::size_t>(size, _chunkSize);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            input[n] = block[n] * _attenuation;
+        }
+        
+        if (_mode == FDN)
+        {
+            std::copy(input, input + chunk, output);
+            
+            _processFdn(output, nullptr, chunk);
+        }
+        
+        else _processSchroeder(input, output, nullptr, chunk);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            block[n] = _dryWet(input[n], output[n]);
+        }
+        
+        block += chunk;
+        
+        size -= chunk;
+    }
+}
+
+void Reverb::processStereo(double* left, double* right, std::size_t size)
+{
+    _modulate();
+    
+    double input [_chunkSize];
+    double outputLeft [_chunkSize];
+    double outputRight [_chunkSize];
+    
+    while (size)
+    {
+        const std::size_t chunk = std::min<std::size_t>(size, _chunkSize);
+        
+        // The network is fed in mono, the channels
+        // differ only in how its output is tapped
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            input[n] = (left[n] + right[n]) * 0.5 * _attenuation;
+        }
+        
+        if (_mode == FDN)
+        {
+            std::copy(input, input + chunk, outputLeft);
+            
+            _processFdn(outputLeft, outputRight, chunk);
+        }
+        
+        else _processSchroeder(input, outputLeft, outputRight, chunk);
+        
+        for (std::size_t n = 0; n < chunk; ++n)
+        {
+            left[n] = _dryWet(left[n] * _attenuation, outputLeft[n]);
+            right[n] = _dryWet(right[n] * _attenuation, outputRight[n]);
+        }
+        
+        left += chunk;
+        right += chunk;
+        
+        size -= chunk;
+    }
+}
+
+void Reverb::_processSchroeder(const double* input,
+                               double* left,
+                               double* right,
+                               std::size_t size)
+{
+    double comb [_chunkSize];
+    
+    std::fill(left, left + size, 0);
+    
+    if (right) std::fill(right, right + size, 0);
+    
+    // Parallel comb filters, summed with alternating
+    // signs for the right channel to decorrelate it
+    for (unsigned short i = 0; i < 4; ++i)
+    {
+        std::copy(input, input + size, comb);
+        
+        _delays[i].processBlock(comb, size);
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            left[n] += comb[n];
+        }
+        
+        if (right)
+        {
+            const double sign = (i % 2) ? -1 : 1;
+            
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                right[n] += comb[n] * sign;
+            }
+        }
+    }
+    
+    // All-passes in series
+    _allPasses[0].processBlock(left, size);
+    _allPasses[1].processBlock(left, size);
+    
+    if (right)
+    {
+        _allPasses[2].processBlock(right, size);
+        _allPasses[3].processBlock(right, size);
+    }
+}
+
+void Reverb::_processFdn(double* block, double* right, std::size_t size)
+{
+    // Input and output signs, alternating so that the input
+    // is spread over all lines by the first pass through
+    // the matrix rather than only reaching the first line
+    static const double signs [_fdnSize] = { 1, -1, 1, -1, 1, 1, -1, -1 };
+    
+    // Output signs of the right channel, orthogonal to
+    // the left ones so that the channels are uncorrelated
+    static const double rightSigns [_fdnSize] = { 1, 1, -1, -1, 1, -1, 1, -1 };
+    
+    // One lane per delay line, each a run of the chunk. Since
+    // the chunk is shorter than every line, all reads happen
+    // before any write and every loop below vectorizes
+    double lanes [_fdnSize][_chunkSize];
+    
+    for (unsigned short i = 0; i < _fdnSize; ++i)
+    {
+        _lines[i].read(lanes[i], size, static_cast<double>(_lengths[i]));
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            lanes[i][n] *= _gains[i];
+        }
+    }
+    
+    // Tap the output before mixing, the input is consumed below
+    double output [_chunkSize];
+    
+    std::fill(output, output + size, 0);
+    
+    for (unsigned short i = 0; i < _fdnSize; ++i)
+    {
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            output[n] += lanes[i][n] * signs[i];
+        }
+    }
+    
+    if (right)
+    {
+        std::fill(right, right + size, 0);
+        
+        for (unsigned short i = 0; i < _fdnSize; ++i)
+        {
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                right[n] += lanes[i][n] * rightSigns[i];
+            }
+        }
+    }
+    
+    // Fast Walsh-Hadamard transform across the lanes
+    for (unsigned short span = 1; span < _fdnSize; span *= 2)
+    {
+        for (unsigned short i = 0; i < _fdnSize; i += 2 * span)
+        {
+            for (unsigned short j = i; j < i + span; ++j)
+            {
+                double* a = lanes[j];
+                double* b = lanes[j + span];
+                
+                for (std::size_t n = 0; n < size; ++n)
+                {
+                    const double sum = a[n] + b[n];
+                    
+                    b[n] = a[n] - b[n];
+                    a[n] = sum;
+                }
+            }
+        }
+    }
+    
+    // Feed the mixed signal plus the input back into the lines
+    for (unsigned short i = 0; i < _fdnSize; ++i)
+    {
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            lanes[i][n] += block[n] * signs[i];
+        }
+        
+        _lines[i].write(lanes[i], size);
+    }
+    
+    std::copy(output, output + size, block);
+}
+
 void Reverb::setReverbRate(double reverbRate)
 {
     if (reverbRate < 0 || reverbRate > 1)
@@ -181,10 +536,7 @@ void Reverb::setReverbRate(double reverbRate)
     
     _reverbRate = reverbRate;
     
-    for (unsigned short i = 0; i < 4; ++i)
-    {
-        _delays[i].setDecayRate(reverbRate);
-    }
+    _calcDecay();
 }
 
 double Reverb::getReverbRate() const
@@ -206,10 +558,7 @@ void Reverb::setReverbTime(double reverbTime)
     
     _reverbTime = reverbTime;
     
-    for (unsigned short i = 0; i < 4; ++i)
-    {
-        _delays[i].setDecayTime(reverbTime);
-    }
+    _calcDecay();
 }
 
 double Reverb::getReverbTime() const
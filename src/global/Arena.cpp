@@ -0,0 +1,166 @@
+/********************************************************************************************//*!
+*
+*  @file        Arena.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "Arena.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+thread_local Arena* Arena::_current = nullptr;
+
+Arena::Arena(size_t blockSize)
+: _used(0), _full(0), _blockSize(blockSize)
+{
+    if (! blockSize)
+    { throw std::invalid_argument("Arena block size must be greater than zero!"); }
+    
+    _grow(blockSize);
+}
+
+Arena::~Arena()
+{
+    for (std::vector<Block>::iterator itr = _blocks.begin(), end = _blocks.end();
+         itr != end;
+         ++itr)
+    {
+        ::operator delete(itr->data);
+    }
+}
+
+Arena* Arena::current()
+{
+    return _current;
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    if (alignment & (alignment - 1))
+    { throw std::invalid_argument("Alignment must be a power of two!"); }
+    
+    Block& block = _blocks.back();
+    
+    // Padding to align the address (not just the offset)
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.data + _used);
+    
+    size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    
+    if (_used + padding + size > block.size)
+    {
+        _grow(size + alignment);
+        
+        address = reinterpret_cast<std::uintptr_t>(_blocks.back().data);
+        
+        padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    }
+    
+    char* memory = _blocks.back().data + _used + padding;
+    
+    _used += padding + size;
+    
+    return memory;
+}
+
+bool Arena::owns(const void* p) const
+{
+    // Pointer comparisons across allocations are only
+    // guaranteed to be meaningful with std::less
+    std::less<const void*> less;
+    
+    for (std::vector<Block>::const_iterator itr = _blocks.begin(), end = _blocks.end();
+         itr != end;
+         ++itr)
+    {
+        if (! less(p, itr->data) && less(p, itr->data + itr->size)) return true;
+    }
+    
+    return false;
+}
+
+Arena::size_t Arena::size() const
+{
+    return _full + _used;
+}
+
+Arena::size_t Arena::capacity() const
+{
+    size_t total = 0;
+    
+    for (std::vector<Block>::const_iterator itr = _blocks.begin(), end = _blocks.end();
+         itr != end;
+         ++itr)
+    {
+        total += itr->size;
+    }
+    
+    return total;
+}
+
+Arena::size_t Arena::blocks() const
+{
+    return _blocks.size();
+}
+
+void* Arena::acquire(Arena* arena, size_t size, size_t alignment)
+{
+    if (arena && arena == _current) return arena->allocate(size, alignment);
+    
+    return ::operator new(size);
+}
+
+void Arena::release(Arena* arena, void* p)
+{
+    if (! arena || ! arena->owns(p)) ::operator delete(p);
+}
+
+void Arena::_grow(size_t size)
+{
+    if (size < _blockSize) size = _blockSize;
+    
+    Block block = { static_cast<char*>(::operator new(size)), size };
+    
+    try
+    {
+        _blocks.push_back(block);
+    }
+    
+    catch (...)
+    {
+        ::operator delete(block.data);
+        
+        throw;
+    }
+    
+    // The rest of the previous block is abandoned
+    _full += _used;
+    
+    _used = 0;
+}
+
+Arena::Scope::Scope(Arena& arena)
+: _previous(_current), _open(true)
+{
+    _current = &arena;
+}
+
+Arena::Scope::~Scope()
+{
+    close();
+}
+
+void Arena::Scope::close()
+{
+    if (_open)
+    {
+        _current = _previous;
+        
+        _open = false;
+    }
+}
@@ -0,0 +1,219 @@
+/********************************************************************************************//*!
+*
+*  @file        AudioBuffer.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "AudioBuffer.hpp"
+#include "Sample.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+AudioBuffer::AudioBuffer(size_t size)
+: _size(0), _capacity(0)
+{
+    _channels[LEFT] = _channels[RIGHT] = nullptr;
+
+    resize(size);
+
+    clear();
+}
+
+AudioBuffer::AudioBuffer(const AudioBuffer& other)
+: _size(0), _capacity(0)
+{
+    _channels[LEFT] = _channels[RIGHT] = nullptr;
+
+    resize(other._size);
+
+    std::copy(other.left(), other.left() + _size, left());
+    std::copy(other.right(), other.right() + _size, right());
+}
+
+AudioBuffer& AudioBuffer::operator= (const AudioBuffer& other)
+{
+    if (this != &other)
+    {
+        resize(other._size);
+
+        std::copy(other.left(), other.left() + _size, left());
+        std::copy(other.right(), other.right() + _size, right());
+    }
+
+    return *this;
+}
+
+void AudioBuffer::_allocate(size_t capacity)
+{
+    // Round the capacity up to a multiple of the alignment
+    // so that the right channel starts aligned as well
+    const size_t perAlignment = alignment / sizeof(double);
+
+    capacity = ((capacity + perAlignment - 1) / perAlignment) * perAlignment;
+
+    // Over-allocate by one alignment to be able to align manually
+    _memory.reset(new double [2 * capacity + perAlignment]);
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_memory.get());
+
+    address = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+
+    _channels[LEFT] = reinterpret_cast<double*>(address);
+    _channels[RIGHT] = _channels[LEFT] + capacity;
+
+    _capacity = capacity;
+}
+
+void AudioBuffer::resize(size_t size)
+{
+    if (size > _capacity)
+    {
+        _allocate(size);
+    }
+
+    _size = size;
+}
+
+AudioBuffer::size_t AudioBuffer::size() const
+{
+    return _size;
+}
+
+AudioBuffer::size_t AudioBuffer::capacity() const
+{
+    return _capacity;
+}
+
+double* AudioBuffer::channel(unsigned short channel)
+{
+    return _channels[channel];
+}
+
+const double* AudioBuffer::channel(unsigned short channel) const
+{
+    return _channels[channel];
+}
+
+double* AudioBuffer::left()
+{
+    return _channels[LEFT];
+}
+
+const double* AudioBuffer::left() const
+{
+    return _channels[LEFT];
+}
+
+double* AudioBuffer::right()
+{
+    return _channels[RIGHT];
+}
+
+const double* AudioBuffer::right() const
+{
+    return _channels[RIGHT];
+}
+
+Sample AudioBuffer::operator[] (size_t frame) const
+{
+    return Sample(_channels[LEFT][frame], _channels[RIGHT][frame]);
+}
+
+void AudioBuffer::clear()
+{
+    std::fill(left(), left() + _size, 0.0);
+    std::fill(right(), right() + _size, 0.0);
+}
+
+void AudioBuffer::add(const AudioBuffer& other)
+{
+    double* l = left();
+    double* r = right();
+
+    const double* otherLeft = other.left();
+    const double* otherRight = other.right();
+
+    const size_t size = std::min(_size, other._size);
+
+    for (size_t n = 0; n < size; ++n)
+    {
+        l[n] += otherLeft[n];
+        r[n] += otherRight[n];
+    }
+}
+
+void AudioBuffer::multiply(const AudioBuffer& other)
+{
+    double* l = left();
+    double* r = right();
+
+    const double* otherLeft = other.left();
+    const double* otherRight = other.right();
+
+    const size_t size = std::min(_size, other._size);
+
+    for (size_t n = 0; n < size; ++n)
+    {
+        l[n] *= otherLeft[n];
+        r[n] *= otherRight[n];
+    }
+}
+
+void AudioBuffer::gain(double amp)
+{
+    pan(amp, amp);
+}
+
+void AudioBuffer::pan(double leftAmp, double rightAmp)
+{
+    double* l = left();
+    double* r = right();
+
+    for (size_t n = 0; n < _size; ++n)
+    {
+        l[n] *= leftAmp;
+        r[n] *= rightAmp;
+    }
+}
+
+void AudioBuffer::panRamp(double leftStart, double leftEnd,
+                          double rightStart, double rightEnd)
+{
+    if (! _size) return;
+
+    double* l = left();
+    double* r = right();
+
+    const double leftIncr = (leftEnd - leftStart) / _size;
+    const double rightIncr = (rightEnd - rightStart) / _size;
+
+    // Computing the gain from the frame index rather than
+    // accumulating an increment keeps iterations independent
+    for (size_t n = 0; n < _size; ++n)
+    {
+        l[n] *= leftStart + leftIncr * (n + 1);
+        r[n] *= rightStart + rightIncr * (n + 1);
+    }
+}
+
+void AudioBuffer::upmix()
+{
+    std::copy(left(), left() + _size, right());
+}
+
+void AudioBuffer::interleave(double* output) const
+{
+    const double* l = left();
+    const double* r = right();
+
+    for (size_t n = 0; n < _size; ++n)
+    {
+        *output++ = l[n];
+        *output++ = r[n];
+    }
+}
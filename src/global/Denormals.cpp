@@ -0,0 +1,76 @@
+/********************************************************************************************//*!
+*
+*  @file        Denormals.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "Denormals.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ANTHEM_DENORMALS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+#if defined(ANTHEM_DENORMALS_SSE)
+    
+    // Flush-to-zero (bit 15) and denormals-are-zero (bit 6) of the MXCSR
+    const unsigned int flushMask = 0x8040;
+    
+#elif defined(__aarch64__)
+    
+    // Flush-to-zero (bit 24) of the FPCR, which covers inputs too
+    const unsigned long flushMask = 1ul << 24;
+    
+    inline unsigned long getFpcr()
+    {
+        unsigned long fpcr;
+        
+        asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+        
+        return fpcr;
+    }
+    
+    inline void setFpcr(unsigned long fpcr)
+    {
+        asm volatile("msr fpcr, %0" : : "r"(fpcr));
+    }
+    
+#endif
+}
+
+DenormalGuard::DenormalGuard()
+: _state(0)
+{
+#if defined(ANTHEM_DENORMALS_SSE)
+    
+    _state = _mm_getcsr();
+    
+    _mm_setcsr(static_cast<unsigned int>(_state) | flushMask);
+    
+#elif defined(__aarch64__)
+    
+    _state = getFpcr();
+    
+    setFpcr(_state | flushMask);
+    
+#endif
+}
+
+DenormalGuard::~DenormalGuard()
+{
+#if defined(ANTHEM_DENORMALS_SSE)
+    
+    _mm_setcsr(static_cast<unsigned int>(_state));
+    
+#elif defined(__aarch64__)
+    
+    setFpcr(_state);
+    
+#endif
+}
@@ -0,0 +1,90 @@
+/********************************************************************************************//*!
+*
+*  @file        EngineContext.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "EngineContext.hpp"
+#include "Global.hpp"
+
+#include <stdexcept>
+
+thread_local EngineContext* EngineContext::_current = nullptr;
+
+EngineContext::EngineContext(unsigned int samplerate, double tempo)
+: _samplerate(samplerate),
+  _nyquistLimit(samplerate / 2),
+  _tableIncrement(0)
+{
+    if (! samplerate)
+    { throw std::invalid_argument("Samplerate must be greater than zero!"); }
+    
+    _tableIncrement = static_cast<double>(Global::wavetableLength) / samplerate;
+    
+    setTempo(tempo);
+}
+
+EngineContext& EngineContext::current()
+{
+    return (_current) ? *_current : getDefault();
+}
+
+EngineContext& EngineContext::getDefault()
+{
+    static EngineContext context;
+    
+    return context;
+}
+
+unsigned int EngineContext::getSamplerate() const
+{
+    return _samplerate;
+}
+
+unsigned int EngineContext::getNyquistLimit() const
+{
+    return _nyquistLimit;
+}
+
+double EngineContext::getTableIncrement() const
+{
+    return _tableIncrement;
+}
+
+void EngineContext::setTempo(double tempo)
+{
+    if (tempo <= 0)
+    { throw std::invalid_argument("Tempo must be greater than zero!"); }
+    
+    _tempo = tempo;
+}
+
+double EngineContext::getTempo() const
+{
+    return _tempo;
+}
+
+EngineContext::Scope::Scope(EngineContext& context)
+: _previous(_current), _open(true)
+{
+    _current = &context;
+}
+
+EngineContext::Scope::~Scope()
+{
+    close();
+}
+
+void EngineContext::Scope::close()
+{
+    if (_open)
+    {
+        _current = _previous;
+        
+        _open = false;
+    }
+}
@@ -0,0 +1,104 @@
+/********************************************************************************************//*!
+*
+*  @file        FFT.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "FFT.hpp"
+#include "Global.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+FFT::FFT(size_t size)
+: _size(size), _reversed(size), _twiddles(size / 2)
+{
+    if (size < 2 || (size & (size - 1)))
+    { throw std::invalid_argument("FFT size must be a power of two!"); }
+
+    size_t bits = 0;
+
+    while ((static_cast<size_t>(1) << bits) < size) ++bits;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t reversed = 0;
+
+        for (size_t b = 0; b < bits; ++b)
+        {
+            if (i & (static_cast<size_t>(1) << b))
+            {
+                reversed |= static_cast<size_t>(1) << (bits - 1 - b);
+            }
+        }
+
+        _reversed[i] = reversed;
+    }
+
+    for (size_t k = 0; k < size / 2; ++k)
+    {
+        _twiddles[k] = std::polar(1.0, -Global::twoPi * k / size);
+    }
+}
+
+FFT::size_t FFT::size() const
+{
+    return _size;
+}
+
+void FFT::forward(complex_t* data) const
+{
+    _transform(data, false);
+}
+
+void FFT::inverse(complex_t* data) const
+{
+    _transform(data, true);
+
+    const double scale = 1.0 / _size;
+
+    for (size_t i = 0; i < _size; ++i)
+    {
+        data[i] *= scale;
+    }
+}
+
+void FFT::_transform(complex_t* data, bool inverse) const
+{
+    // Bit-reversal permutation
+    for (size_t i = 0; i < _size; ++i)
+    {
+        if (i < _reversed[i])
+        {
+            std::swap(data[i], data[_reversed[i]]);
+        }
+    }
+
+    for (size_t length = 2; length <= _size; length *= 2)
+    {
+        const size_t half = length / 2;
+
+        // Stride through the twiddle table for this stage
+        const size_t stride = _size / length;
+
+        for (size_t start = 0; start < _size; start += length)
+        {
+            for (size_t k = 0; k < half; ++k)
+            {
+                complex_t twiddle = _twiddles[k * stride];
+
+                if (inverse) twiddle = std::conj(twiddle);
+
+                const complex_t odd = data[start + k + half] * twiddle;
+
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
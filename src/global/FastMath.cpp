@@ -0,0 +1,331 @@
+/********************************************************************************************//*!
+*
+*  @file        FastMath.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "FastMath.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANTHEM_FASTMATH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#if defined(ANTHEM_FASTMATH_SSE2)
+    
+    /*! FastMath::exp2() for two values at once */
+    inline __m128d _exp2(__m128d x)
+    {
+        const __m128d underflow = _mm_cmplt_pd(x, _mm_set1_pd(-1022));
+        
+        x = _mm_min_pd(x, _mm_set1_pd(1023));
+        
+        x = _mm_max_pd(x, _mm_set1_pd(-1022));
+        
+        // Rounds to nearest, so |f| <= 0.5
+        const __m128d magic = _mm_set1_pd(6755399441055744.0);
+        
+        const __m128d shifted = _mm_add_pd(x, magic);
+        
+        const __m128d f = _mm_sub_pd(x, _mm_sub_pd(shifted, magic));
+        
+        __m128d p = _mm_set1_pd(1.5310082026189776e-05);
+        
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.00015469731913299257));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.0013333450557189508));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.009618025603165279));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.055504109412186045));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.24022651213593738));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(0.6931471805459287));
+        p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(1));
+        
+        // Move n + 1023 from the low mantissa bits into the exponent bits
+        const __m128i biased = _mm_add_epi64(_mm_castpd_si128(shifted), _mm_set1_epi64x(1023));
+        
+        const __m128i bits = _mm_slli_epi64(biased, 52);
+        
+        return _mm_andnot_pd(underflow, _mm_mul_pd(p, _mm_castsi128_pd(bits)));
+    }
+    
+    /*! FastMath::log2() for two values at once */
+    inline __m128d _log2(__m128d x)
+    {
+        const __m128i bits = _mm_castpd_si128(x);
+        
+        // Convert the biased exponents to doubles by writing them
+        // into the mantissa of 2^52 and subtracting 2^52 again
+        const __m128i biased = _mm_srli_epi64(bits, 52);
+        
+        const __m128d magic = _mm_set1_pd(4503599627370496.0);
+        
+        __m128d exponent = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(biased, _mm_castpd_si128(magic))),
+                                      _mm_set1_pd(4503599627370496.0 + 1023));
+        
+        // The mantissa, scaled to [1, 2)
+        const __m128i mantissa = _mm_and_si128(bits, _mm_set1_epi64x(0x000FFFFFFFFFFFFFll));
+        
+        __m128d m = _mm_castsi128_pd(_mm_or_si128(mantissa, _mm_set1_epi64x(0x3FF0000000000000ll)));
+        
+        // Center the mantissa around 1
+        const __m128d above = _mm_cmpgt_pd(m, _mm_set1_pd(1.4142135623730951));
+        
+        m = _mm_mul_pd(m, _mm_or_pd(_mm_and_pd(above, _mm_set1_pd(0.5)),
+                                    _mm_andnot_pd(above, _mm_set1_pd(1))));
+        
+        exponent = _mm_add_pd(exponent, _mm_and_pd(above, _mm_set1_pd(1)));
+        
+        const __m128d one = _mm_set1_pd(1);
+        
+        const __m128d s = _mm_div_pd(_mm_sub_pd(m, one), _mm_add_pd(m, one));
+        
+        const __m128d z = _mm_mul_pd(s, s);
+        
+        __m128d p = _mm_set1_pd(0.34072512545525535);
+        
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.4116729971842692));
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.5770835801232524));
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.961796673368783));
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(2.885390081790061));
+        
+        return _mm_add_pd(exponent, _mm_mul_pd(s, p));
+    }
+    
+    /*! FastMath::_sin() for two values at once */
+    inline __m128d _sine(__m128d x, int offset)
+    {
+        // Round half away from zero like the scalar version, |x| < 1e5 fits in 32 bits
+        const __m128d half = _mm_or_pd(_mm_and_pd(x, _mm_set1_pd(-0.0)), _mm_set1_pd(0.5));
+        
+        __m128i quadrant = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(0.6366197723675814)), half));
+        
+        const __m128d q = _mm_cvtepi32_pd(quadrant);
+        
+        const __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(q, _mm_set1_pd(1.5707963267341256))),
+                                     _mm_mul_pd(q, _mm_set1_pd(6.077100506506192e-11)));
+        
+        const __m128d z = _mm_mul_pd(r, r);
+        
+        // Spread the two 32-bit quadrants over the two 64-bit lanes
+        quadrant = _mm_add_epi32(quadrant, _mm_set1_epi32(offset));
+        
+        quadrant = _mm_shuffle_epi32(quadrant, _MM_SHUFFLE(1, 1, 0, 0));
+        
+        const __m128i one = _mm_set1_epi32(1);
+        
+        const __m128d odd = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+        
+        __m128d c = _mm_set1_pd(-1.1470745597729725e-11);
+        
+        c = _mm_add_pd(_mm_mul_pd(c, z), _mm_set1_pd(2.08767569878681e-09));
+        c = _mm_sub_pd(_mm_mul_pd(c, z), _mm_set1_pd(2.755731922398589e-07));
+        c = _mm_add_pd(_mm_mul_pd(c, z), _mm_set1_pd(2.48015873015873e-05));
+        c = _mm_sub_pd(_mm_mul_pd(c, z), _mm_set1_pd(0.001388888888888889));
+        c = _mm_add_pd(_mm_mul_pd(c, z), _mm_set1_pd(0.041666666666666664));
+        c = _mm_sub_pd(_mm_mul_pd(c, z), _mm_set1_pd(0.5));
+        c = _mm_add_pd(_mm_mul_pd(c, z), _mm_set1_pd(1));
+        
+        __m128d s = _mm_set1_pd(1.6059043836821613e-10);
+        
+        s = _mm_sub_pd(_mm_mul_pd(s, z), _mm_set1_pd(2.505210838544172e-08));
+        s = _mm_add_pd(_mm_mul_pd(s, z), _mm_set1_pd(2.7557319223985893e-06));
+        s = _mm_sub_pd(_mm_mul_pd(s, z), _mm_set1_pd(0.0001984126984126984));
+        s = _mm_add_pd(_mm_mul_pd(s, z), _mm_set1_pd(0.008333333333333333));
+        s = _mm_sub_pd(_mm_mul_pd(s, z), _mm_set1_pd(0.16666666666666666));
+        s = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), s));
+        
+        const __m128d value = _mm_or_pd(_mm_and_pd(odd, c), _mm_andnot_pd(odd, s));
+        
+        // Bit 1 of the quadrant becomes the sign bit
+        const __m128i sign = _mm_slli_epi64(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 62);
+        
+        return _mm_xor_pd(value, _mm_castsi128_pd(sign));
+    }
+    
+    /*! FastMath::tanh() for two values at once */
+    inline __m128d _tanh(__m128d x)
+    {
+        x = _mm_max_pd(_mm_min_pd(x, _mm_set1_pd(20)), _mm_set1_pd(-20));
+        
+        const __m128d small = _mm_and_pd(_mm_cmplt_pd(x, _mm_set1_pd(0.125)),
+                                         _mm_cmpgt_pd(x, _mm_set1_pd(-0.125)));
+        
+        const __m128d z = _mm_mul_pd(x, x);
+        
+        __m128d p = _mm_set1_pd(-0.0035921280365724811);
+        
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.008863235529902197));
+        p = _mm_sub_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.021869488536155203));
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.05396825396825397));
+        p = _mm_sub_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.13333333333333333));
+        p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(0.3333333333333333));
+        
+        p = _mm_sub_pd(x, _mm_mul_pd(_mm_mul_pd(x, z), p));
+        
+        const __m128d e = _exp2(_mm_mul_pd(x, _mm_set1_pd(2.8853900817779268)));
+        
+        const __m128d one = _mm_set1_pd(1);
+        
+        const __m128d large = _mm_div_pd(_mm_sub_pd(e, one), _mm_add_pd(e, one));
+        
+        return _mm_or_pd(_mm_and_pd(small, p), _mm_andnot_pd(small, large));
+    }
+    
+#endif
+}
+
+namespace FastMath
+{
+    void exp2(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            _mm_storeu_pd(output + n, _exp2(_mm_loadu_pd(input + n)));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = exp2(input[n]);
+    }
+    
+    void log2(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            _mm_storeu_pd(output + n, _log2(_mm_loadu_pd(input + n)));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = log2(input[n]);
+    }
+    
+    void pow(const double* input, double exponent, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        const __m128d y = _mm_set1_pd(exponent);
+        
+        const __m128d zero = _mm_setzero_pd();
+        
+        // What pow() returns for bases of 0
+        const __m128d base = _mm_set1_pd((exponent == 0) ? 1 : 0);
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            const __m128d x = _mm_loadu_pd(input + n);
+            
+            const __m128d positive = _mm_cmpgt_pd(x, zero);
+            
+            // Keep non-positive values away from log2()
+            const __m128d safe = _mm_or_pd(_mm_and_pd(positive, x), _mm_andnot_pd(positive, _mm_set1_pd(1)));
+            
+            const __m128d value = _exp2(_mm_mul_pd(y, _log2(safe)));
+            
+            _mm_storeu_pd(output + n, _mm_or_pd(_mm_and_pd(positive, value), _mm_andnot_pd(positive, base)));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = pow(input[n], exponent);
+    }
+    
+    void sin(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            _mm_storeu_pd(output + n, _sine(_mm_loadu_pd(input + n), 0));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = sin(input[n]);
+    }
+    
+    void cos(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            _mm_storeu_pd(output + n, _sine(_mm_loadu_pd(input + n), 1));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = cos(input[n]);
+    }
+    
+    void tanh(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            _mm_storeu_pd(output + n, _tanh(_mm_loadu_pd(input + n)));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = tanh(input[n]);
+    }
+    
+    void dbToAmp(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            const __m128d x = _mm_mul_pd(_mm_loadu_pd(input + n), _mm_set1_pd(dbToLog2));
+            
+            _mm_storeu_pd(output + n, _exp2(x));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = dbToAmp(input[n]);
+    }
+    
+    void ampToDb(const double* input, double* output, std::size_t size)
+    {
+        std::size_t n = 0;
+        
+#if defined(ANTHEM_FASTMATH_SSE2)
+        
+        for (; n + 2 <= size; n += 2)
+        {
+            const __m128d x = _log2(_mm_loadu_pd(input + n));
+            
+            _mm_storeu_pd(output + n, _mm_mul_pd(x, _mm_set1_pd(log2ToDb)));
+        }
+        
+#endif
+        
+        for (; n < size; ++n) output[n] = ampToDb(input[n]);
+    }
+}
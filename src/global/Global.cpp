@@ -9,6 +9,7 @@
 ************************************************************************************************/
 
 #include "Global.hpp"
+#include "EngineContext.hpp"
 #include "Wavetable.hpp"
 #include "Pantable.hpp"
 #include "Notetable.hpp"
@@ -20,23 +21,17 @@ Notetable notetable;
 
 namespace Global
 {
-    unsigned int samplerate = 0;
-    
-    unsigned int nyquistLimit = 0;
-    
     unsigned short wavetableLength = 0;
     
-    double tableIncrement = 0;
-    
     void init(const unsigned int smplr, const unsigned int wavetableLen)
     {
-        samplerate = smplr;
-        nyquistLimit = smplr / 2;
-        
         wavetableLength = wavetableLen;
         
-        tableIncrement = static_cast<double>(wavetableLength) / smplr;
-        
         wavetableDatabase.init();
+        
+        EngineContext& context = EngineContext::getDefault();
+        
+        // After the wavetable length, which the table increment depends on
+        context = EngineContext(smplr, context.getTempo());
     }
 }
\ No newline at end of file
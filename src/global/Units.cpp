@@ -12,22 +12,22 @@
 #include "ModDock.hpp"
 #include "Wavetable.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 Unit::Unit(index_t numDocks)
-: _mods(new ModDock [numDocks]),
-  _numDocks(numDocks), _active(false)
+: _mods(numDocks),
+  _numDocks(numDocks), _active(false),
+  _context(&EngineContext::current())
 { }
 
 Unit::Unit(const Unit& other)
-: _mods(new ModDock [other._numDocks]),
-  _active(other._active)
-{
-    for (index_t i = 0; i < other._numDocks; ++i)
-    {
-        _mods[i] = other._mods[i];
-    }
-}
+: _mods(other._mods),
+  _numDocks(other._numDocks),
+  _active(other._active),
+  _context(other._context)
+{ }
 
 Unit& Unit::operator=(const Unit& other)
 {
@@ -35,12 +35,13 @@ Unit& Unit::operator=(const Unit& other)
     {
         _active = true;
         
-        _mods.reset(new ModDock [other._numDocks]);
+        _numDocks = other._numDocks;
         
-        for (index_t i = 0; i < other._numDocks; ++i)
-        {
-            _mods[i] = other._mods[i];
-        }
+        _mods = other._mods;
+        
+        // Any samplerate-dependent values copied
+        // were calculated in the other's context
+        _context = other._context;
     }
     
     return *this;
@@ -170,8 +171,15 @@ bool Unit::isActive() const
     return _active;
 }
 
+const EngineContext& Unit::getContext() const
+{
+    return *_context;
+}
+
+const double EffectUnit::silenceThreshold = 1e-6;
+
 EffectUnit::EffectUnit(unsigned short numDocks, double dryWet)
-: _dw(dryWet), Unit(numDocks)
+: Unit(numDocks), _dw(dryWet), _quiet(0)
 { }
 
 void EffectUnit::setDryWet(double dw)
@@ -184,6 +192,62 @@ void EffectUnit::setDryWet(double dw)
     _dw = dw;
 }
 
+void EffectUnit::processBlock(double* block, std::size_t size)
+{
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        block[n] = process(block[n]);
+    }
+}
+
+void EffectUnit::processStereo(double* left, double* right, std::size_t size)
+{
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        left[n] = (left[n] + right[n]) * 0.5;
+    }
+    
+    processBlock(left, size);
+    
+    std::copy(left, left + size, right);
+}
+
+bool EffectUnit::render(double* left, double* right, std::size_t size, bool silent)
+{
+    if (! silent)
+    {
+        _quiet = 0;
+        
+        processStereo(left, right, size);
+        
+        return false;
+    }
+    
+    // The tail has decayed, nothing to do
+    if (_quiet > getTailLength()) return true;
+    
+    processStereo(left, right, size);
+    
+    for (std::size_t n = 0; n < size; ++n)
+    {
+        if (std::fabs(left[n]) >= silenceThreshold || std::fabs(right[n]) >= silenceThreshold)
+        {
+            _quiet = 0;
+            
+            return false;
+        }
+    }
+    
+    _quiet += size;
+    
+    return _quiet > getTailLength();
+}
+
+std::size_t EffectUnit::getTailLength() const
+{
+    return 0;
+}
+
 double EffectUnit::getDryWet() const
 {
     return _dw;
@@ -9,6 +9,7 @@
 ************************************************************************************************/
 
 #include "Util.hpp"
+#include "FastMath.hpp"
 #include <cmath>
 #include <string>
 
@@ -63,7 +64,7 @@ namespace Util
         
         double exp = (note - 69) / 12.0;
         
-        return pow(2, exp) * 440;
+        return FastMath::exp2(exp) * 440;
     }
 
     unsigned short freqToNote(double freq)
@@ -73,14 +74,14 @@ namespace Util
 
     double semitonesToFreq(double baseFreq, double semitoneOffset)
     {
-        return pow(2, semitoneOffset / 12.0) * baseFreq;
+        return FastMath::exp2(semitoneOffset / 12.0) * baseFreq;
     }
     
     double freqToSemitones(double baseFreq, double newFreq)
     {
         if (! baseFreq) return 0;
         
-        return (12 * (log(newFreq/baseFreq))) / log(2);
+        return 12 * FastMath::log2(newFreq/baseFreq);
     }
 
     float getPassedTime(clock_t start)
@@ -91,7 +92,7 @@ namespace Util
     double dbToAmp(double baseAmp, double dB)
     {
         // 0 gain means no change
-        return (dB) ? baseAmp * pow(10, (dB/20.0)) : baseAmp;
+        return (dB) ? baseAmp * FastMath::dbToAmp(dB) : baseAmp;
     }
     
     std::string checkFileName(std::string fname, const std::string& fileEnding)
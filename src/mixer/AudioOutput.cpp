@@ -9,13 +9,51 @@
 ************************************************************************************************/
 
 #include "AudioOutput.hpp"
-#include "Global.hpp"
-#include "Sample.hpp"
+#include "EngineContext.hpp"
 #include "Anthem.hpp"
 
-Anthem* AudioOutput::_anthem = 0;
+#include <algorithm>
+#include <chrono>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ANTHEM_RENDER_PTHREAD
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace
+{
+    /*! Raises the calling thread's priority, keeping it if that is not permitted */
+    void raisePriority()
+    {
+#if defined(ANTHEM_RENDER_PTHREAD)
+        
+        sched_param parameters = sched_param();
+        
+        // Just below the maximum, where device threads usually run
+        parameters.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+        
+        // Fails without real-time privileges, which is fine
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+        
+#elif defined(_WIN32)
+        
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+        
+#endif
+    }
+}
 
 AudioOutput::AudioOutput()
+: _anthem(0),
+  _context(&EngineContext::current()),
+  _frames(0),
+  _renderAhead(0),
+  _written(0),
+  _read(0),
+  _underruns(0),
+  _rendering(false)
 {
     try
     {
@@ -37,6 +75,14 @@ AudioOutput::AudioOutput()
     _apiName = getApiName(_api);
 }
 
+AudioOutput::~AudioOutput()
+{
+    // The callback reads from the ring, so close the stream first
+    if (_audio.isStreamOpen()) close();
+    
+    _stopRendering();
+}
+
 void AudioOutput::init(Anthem *anthem)
 {
     _anthem = anthem;
@@ -114,14 +160,32 @@ int AudioOutput::_callback(void *output,
 {
     double* outputBuffer = static_cast<double*>(output);
     
-    for (unsigned int n = 0; n < numberOfFrames; ++n)
+    AudioOutput* self = static_cast<AudioOutput*>(userData);
+    
+    if (self->_renderAhead)
     {
-        Sample sample = _anthem->_tick();
+        self->_copyAhead(outputBuffer, numberOfFrames);
         
-        *outputBuffer++ = sample.left;
-        *outputBuffer++ = sample.right;
+        return 0;
+    }
+    
+    AudioBuffer& buffer = self->_buffer;
+    
+    // The device may ask for more frames than the buffer was sized
+    // for, in which case render in chunks rather than allocating
+    while (numberOfFrames)
+    {
+        unsigned int frames = std::min<unsigned int>(numberOfFrames, buffer.capacity());
+        
+        buffer.resize(frames);
+        
+        self->_anthem->process(buffer);
         
-        _anthem->_update();
+        buffer.interleave(outputBuffer);
+        
+        outputBuffer += 2 * frames;
+        
+        numberOfFrames -= frames;
     }
     
     return 0;
@@ -143,9 +207,17 @@ void AudioOutput::open(id_t id, id_t channels, id_t frames)
     _audio.openStream(&params,
                       NULL,
                       RTAUDIO_FLOAT64,
-                      Global::samplerate,
+                      _context->getSamplerate(),
                       &frames,
-                      &_callback);
+                      &_callback,
+                      this);
+    
+    // RtAudio may have changed the number of frames
+    _buffer.resize(frames);
+    
+    _frames = frames;
+    
+    _resizeRing();
     
     _id = id;
     
@@ -165,10 +237,14 @@ void AudioOutput::close()
     {
         error.printMessage();
     }
+    
+    _stopRendering();
 }
 
 void AudioOutput::start()
 {
+    if (_renderAhead) _startRendering();
+    
     try
     {
         _audio.startStream();
@@ -177,6 +253,8 @@ void AudioOutput::start()
     catch(RtAudioError& error)
     {
         error.printMessage();
+        
+        _stopRendering();
     }
 }
 
@@ -191,6 +269,8 @@ void AudioOutput::stop()
     {
         error.printMessage();
     }
+    
+    _stopRendering();
 }
 
 AudioOutput::id_t AudioOutput::getNumberOfDevices()
@@ -231,4 +311,141 @@ AudioOutput::id_t AudioOutput::getCurrentID() const
 AudioOutput::Device AudioOutput::getCurrentDevice() const
 {
     return _device;
-}
\ No newline at end of file
+}
+
+void AudioOutput::setRenderAhead(unsigned int blocks)
+{
+    const bool streaming = isStreaming();
+    
+    if (streaming) stop();
+    
+    // The render thread must not touch the ring while it is resized
+    _stopRendering();
+    
+    _renderAhead = blocks;
+    
+    _resizeRing();
+    
+    if (streaming) start();
+}
+
+unsigned int AudioOutput::getRenderAhead() const
+{
+    return _renderAhead;
+}
+
+std::size_t AudioOutput::getBufferedFrames() const
+{
+    // Read first: _read never passes _written, so loading _written
+    // afterwards cannot make the difference negative
+    const std::size_t read = _read.load(std::memory_order_acquire);
+    
+    return _written.load(std::memory_order_acquire) - read;
+}
+
+unsigned long AudioOutput::getUnderruns() const
+{
+    return _underruns.load(std::memory_order_relaxed);
+}
+
+void AudioOutput::resetUnderruns()
+{
+    _underruns.store(0, std::memory_order_relaxed);
+}
+
+void AudioOutput::_resizeRing()
+{
+    _ring.assign(2 * _renderAhead * _frames, 0);
+}
+
+void AudioOutput::_startRendering()
+{
+    _stopRendering();
+    
+    if (_ring.empty()) return;
+    
+    _written.store(0);
+    
+    _read.store(0);
+    
+    // Fill the ring before the device starts asking for frames
+    while (_renderBlock());
+    
+    _rendering.store(true);
+    
+    _renderThread = std::thread(&AudioOutput::_render, this);
+}
+
+void AudioOutput::_stopRendering()
+{
+    _rendering.store(false);
+    
+    if (_renderThread.joinable()) _renderThread.join();
+}
+
+void AudioOutput::_render()
+{
+    raisePriority();
+    
+    // While the ring is full, check back every quarter block
+    const std::chrono::duration<double> pause(_frames / (4.0 * _context->getSamplerate()));
+    
+    while (_rendering.load(std::memory_order_acquire))
+    {
+        if (! _renderBlock()) std::this_thread::sleep_for(pause);
+    }
+}
+
+bool AudioOutput::_renderBlock()
+{
+    const std::size_t capacity = _ring.size() / 2;
+    
+    const std::size_t written = _written.load(std::memory_order_relaxed);
+    
+    if (written - _read.load(std::memory_order_acquire) + _frames > capacity) return false;
+    
+    _buffer.resize(_frames);
+    
+    _anthem->process(_buffer);
+    
+    // The ring holds a whole number of blocks, so
+    // a block never wraps around the ring's end
+    _buffer.interleave(&_ring[2 * (written % capacity)]);
+    
+    _written.store(written + _frames, std::memory_order_release);
+    
+    return true;
+}
+
+void AudioOutput::_copyAhead(double* output, std::size_t frames)
+{
+    const std::size_t capacity = _ring.size() / 2;
+    
+    const std::size_t read = _read.load(std::memory_order_relaxed);
+    
+    const std::size_t available = std::min(frames, _written.load(std::memory_order_acquire) - read);
+    
+    const double* ring = _ring.data();
+    
+    if (available)
+    {
+        // Copy up to the ring's end, then on from its start
+        const std::size_t offset = read % capacity;
+        
+        const std::size_t first = std::min(available, capacity - offset);
+        
+        std::copy(ring + 2 * offset, ring + 2 * (offset + first), output);
+        
+        std::copy(ring, ring + 2 * (available - first), output + 2 * first);
+        
+        _read.store(read + available, std::memory_order_release);
+    }
+    
+    // Whatever the render thread has not rendered in time is silence
+    if (available < frames)
+    {
+        std::fill(output + 2 * available, output + 2 * frames, 0.0);
+        
+        _underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
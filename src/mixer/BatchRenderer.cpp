@@ -0,0 +1,565 @@
+/********************************************************************************************//*!
+*
+*  @file        BatchRenderer.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "BatchRenderer.hpp"
+#include "Anthem.hpp"
+#include "AudioBuffer.hpp"
+#include "EngineContext.hpp"
+#include "MidiFile.hpp"
+#include "Parsley.hpp"
+#include "WavefileWriter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock steady_t;
+    
+    /*! Returns the seconds passed since start */
+    double secondsSince(steady_t::time_point start)
+    {
+        return std::chrono::duration<double>(steady_t::now() - start).count();
+    }
+    
+    /*! Reads the next line with any content, split into words */
+    bool nextLine(std::istream& stream,
+                  std::vector<std::string>& words,
+                  unsigned long& number)
+    {
+        std::string line;
+        
+        while (std::getline(stream, line))
+        {
+            ++number;
+            
+            std::istringstream split(line);
+            
+            words.clear();
+            
+            for (std::string word; split >> word; ) words.push_back(word);
+            
+            if (! words.empty() && words[0][0] != '#') return true;
+        }
+        
+        return false;
+    }
+    
+    /*! Returns the error message for a line */
+    std::string where(const std::string& fname, unsigned long number)
+    {
+        return fname + ", line " + std::to_string(number);
+    }
+    
+    /*! Parses a number, throwing ParseError if the word is not one */
+    double toNumber(const std::string& word, const std::string& fname, unsigned long number)
+    {
+        std::istringstream stream(word);
+        
+        double value;
+        
+        if (! (stream >> value) || ! stream.eof())
+        { throw ParseError("Invalid number '" + word + "' in " + where(fname, number)); }
+        
+        return value;
+    }
+    
+    /*! Parses a unit letter (A-D), throwing ParseError if the word is not one */
+    unsigned short toUnit(const std::string& word, const std::string& fname, unsigned long number)
+    {
+        if (word.size() != 1 || word[0] < 'A' || word[0] > 'D')
+        { throw ParseError("Invalid unit '" + word + "' in " + where(fname, number)); }
+        
+        return word[0] - 'A';
+    }
+    
+    /*! Resolves a path relative to the directory of another file */
+    std::string resolve(const std::string& path, const std::string& relativeTo)
+    {
+        const std::string::size_type slash = relativeTo.rfind('/');
+        
+        if (path.empty() || path[0] == '/' || slash == std::string::npos) return path;
+        
+        return relativeTo.substr(0, slash + 1) + path;
+    }
+    
+    /*! Opens a file for reading, throwing FileOpenError if it cannot be opened */
+    void openFile(std::ifstream& file, const std::string& fname)
+    {
+        file.open(fname);
+        
+        if (! file)
+        { throw FileOpenError("Error opening file: " + fname); }
+    }
+    
+    /*! Returns whether a path ends with an extension, ignoring case */
+    bool hasExtension(const std::string& path, const std::string& extension)
+    {
+        if (path.size() <= extension.size()) return false;
+        
+        std::string end = path.substr(path.size() - extension.size());
+        
+        std::transform(end.begin(), end.end(), end.begin(), ::tolower);
+        
+        return end == extension;
+    }
+    
+    /*! Applies a note, controller or tempo event to an Anthem */
+    void apply(Anthem& anthem, const MidiFile::Event& event)
+    {
+        switch (event.type)
+        {
+            case MidiFile::NOTE_ON:
+                anthem.setNote(event.number, true);
+                break;
+                
+            case MidiFile::NOTE_OFF:
+                anthem.setNote(event.number, false);
+                break;
+                
+            case MidiFile::TEMPO:
+                anthem.getContext().setTempo(event.tempo);
+                break;
+                
+            case MidiFile::CONTROL_CHANGE:
+            {
+                const double value = event.value / 127.0;
+                
+                if (event.number == 7) anthem.mixer.setMasterAmp(value);
+                
+                // Centered at 64, so that 0 is hard left and 127 hard right
+                else if (event.number == 10)
+                {
+                    anthem.mixer.setPanValue(std::max(-100.0, (event.value - 64) / 0.63));
+                }
+                
+                else if (event.number >= 16 && event.number <= 19)
+                {
+                    anthem.macros[event.number - 16].setValue(value * 2 - 1);
+                }
+                
+                break;
+            }
+        }
+    }
+}
+
+BatchRenderer::Job::Job()
+: samplerate(48000), tail(1)
+{ }
+
+BatchRenderer::Stats::Stats()
+: frames(0), audioSeconds(0), renderSeconds(0)
+{ }
+
+double BatchRenderer::Stats::speed() const
+{
+    return (renderSeconds > 0) ? audioSeconds / renderSeconds : 0;
+}
+
+BatchRenderer::Report::Report()
+: failed(0), audioSeconds(0), wallSeconds(0)
+{ }
+
+double BatchRenderer::Report::speed() const
+{
+    return (wallSeconds > 0) ? audioSeconds / wallSeconds : 0;
+}
+
+BatchRenderer::BatchRenderer(unsigned int threads, size_t blockSize)
+: _threads(threads), _blockSize(blockSize)
+{
+    if (! blockSize)
+    { throw std::invalid_argument("Block size must be greater than zero!"); }
+    
+    if (! _threads) _threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+BatchRenderer::Report BatchRenderer::render(const std::vector<Job>& jobs) const
+{
+    Report report;
+    
+    report.jobs.resize(jobs.size());
+    
+    const steady_t::time_point start = steady_t::now();
+    
+    // Each worker takes the next job until none are left
+    std::atomic<size_t> next(0);
+    
+    auto work = [&]
+    {
+        for (size_t job; (job = next++) < jobs.size(); )
+        {
+            report.jobs[job] = render(jobs[job]);
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    
+    const size_t count = std::min<size_t>(_threads, jobs.size());
+    
+    for (size_t i = 0; i < count; ++i) workers.emplace_back(work);
+    
+    for (std::vector<std::thread>::iterator itr = workers.begin(), end = workers.end();
+         itr != end;
+         ++itr)
+    {
+        itr->join();
+    }
+    
+    report.wallSeconds = secondsSince(start);
+    
+    for (std::vector<Stats>::const_iterator itr = report.jobs.begin(), end = report.jobs.end();
+         itr != end;
+         ++itr)
+    {
+        if (! itr->error.empty()) ++report.failed;
+        
+        report.audioSeconds += itr->audioSeconds;
+    }
+    
+    return report;
+}
+
+BatchRenderer::Stats BatchRenderer::render(const Job& job) const
+{
+    Stats stats;
+    
+    stats.name = job.name.empty() ? job.output : job.name;
+    
+    const steady_t::time_point start = steady_t::now();
+    
+    try
+    {
+        if (job.tail < 0)
+        { throw std::invalid_argument("Tail must not be negative!"); }
+        
+        std::vector<Event> events;
+        
+        std::unique_ptr<MidiFile> midi;
+        
+        // MIDI files are streamed, notes sorted up front
+        if (! job.midi.empty()) midi.reset(new MidiFile(job.midi, job.samplerate));
+        
+        else
+        {
+            events = job.events;
+            
+            std::stable_sort(events.begin(), events.end(),
+                             [] (const Event& a, const Event& b) { return a.time < b.time; });
+            
+            if (! events.empty() && events.front().time < 0)
+            { throw std::invalid_argument("Event times must not be negative!"); }
+        }
+        
+        std::vector<Event>::const_iterator note = events.begin();
+        
+        MidiFile::Event event;
+        
+        // Reads the next event from either source
+        auto next = [&] () -> bool
+        {
+            if (midi) return midi->next(event);
+            
+            if (note == events.end()) return false;
+            
+            event.type = note->on ? MidiFile::NOTE_ON : MidiFile::NOTE_OFF;
+            event.time = note->time;
+            event.frame = static_cast<MidiFile::frame_t>(note->time * job.samplerate + 0.5);
+            event.channel = 0;
+            event.number = note->note;
+            event.value = note->on ? 127 : 0;
+            event.tempo = 0;
+            
+            ++note;
+            
+            return true;
+        };
+        
+        Anthem anthem(EngineContext(job.samplerate), false);
+        
+        if (job.patch) job.patch(anthem);
+        
+        WavefileWriter writer(job.output, job.samplerate);
+        
+        AudioBuffer buffer(_blockSize);
+        
+        bool pending = next();
+        
+        double last = 0;
+        
+        while (true)
+        {
+            // Apply all events that are due
+            for ( ; pending && event.frame <= stats.frames; pending = next())
+            {
+                apply(anthem, event);
+                
+                last = event.time;
+            }
+            
+            // End the block where the next event starts, or render
+            // the tail once the last one has been applied
+            const size_t end = pending ? event.frame
+                                       : static_cast<size_t>((last + job.tail) * job.samplerate + 0.5);
+            
+            if (stats.frames >= end) break;
+            
+            const size_t frames = std::min(_blockSize, end - stats.frames);
+            
+            buffer.resize(frames);
+            
+            anthem.process(buffer);
+            
+            writer.write(buffer);
+            
+            stats.frames += frames;
+        }
+        
+        writer.close();
+    }
+    
+    catch(std::exception& error)
+    {
+        stats.error = error.what();
+    }
+    
+    stats.renderSeconds = secondsSince(start);
+    
+    if (job.samplerate) stats.audioSeconds = static_cast<double>(stats.frames) / job.samplerate;
+    
+    return stats;
+}
+
+unsigned int BatchRenderer::threads() const
+{
+    return _threads;
+}
+
+BatchRenderer::size_t BatchRenderer::blockSize() const
+{
+    return _blockSize;
+}
+
+std::vector<BatchRenderer::Job> BatchRenderer::loadManifest(const std::string& fname)
+{
+    std::ifstream file;
+    
+    openFile(file, fname);
+    
+    std::vector<Job> jobs;
+    
+    std::vector<std::string> words;
+    
+    unsigned long number = 0;
+    
+    while (nextLine(file, words, number))
+    {
+        if (words.size() < 3 || words.size() > 5)
+        { throw ParseError("Expected output, patch, notes, [samplerate] and [tail] in " + where(fname, number)); }
+        
+        Job job;
+        
+        job.output = resolve(words[0], fname);
+        
+        if (words[1] != "-") job.patch = loadPatch(resolve(words[1], fname));
+        
+        const std::string notes = resolve(words[2], fname);
+        
+        if (hasExtension(notes, ".mid") || hasExtension(notes, ".midi")) job.midi = notes;
+        
+        else job.events = loadNotes(notes);
+        
+        if (words.size() > 3)
+        {
+            const double samplerate = toNumber(words[3], fname, number);
+            
+            if (samplerate < 1 || samplerate != static_cast<unsigned int>(samplerate))
+            { throw ParseError("Invalid samplerate in " + where(fname, number)); }
+            
+            job.samplerate = static_cast<unsigned int>(samplerate);
+        }
+        
+        if (words.size() > 4) job.tail = toNumber(words[4], fname, number);
+        
+        jobs.push_back(job);
+    }
+    
+    return jobs;
+}
+
+BatchRenderer::patch_t BatchRenderer::loadPatch(const std::string& fname)
+{
+    std::ifstream file;
+    
+    openFile(file, fname);
+    
+    std::vector<patch_t> parameters;
+    
+    std::vector<std::string> words;
+    
+    unsigned long number = 0;
+    
+    while (nextLine(file, words, number))
+    {
+        const std::string& key = words[0];
+        
+        if (key == "operator" && words.size() == 4)
+        {
+            const unsigned short unit = toUnit(words[1], fname, number);
+            
+            const std::string& parameter = words[2];
+            
+            const double value = toNumber(words[3], fname, number);
+            
+            if (parameter == "active")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setActive(value != 0); });
+            }
+            
+            else if (parameter == "wavetable")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setWavetable(value); });
+            }
+            
+            else if (parameter == "level")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setLevel(value); });
+            }
+            
+            else if (parameter == "ratio")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setRatio(value); });
+            }
+            
+            else if (parameter == "offset")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setFrequencyOffset(value); });
+            }
+            
+            else if (parameter == "semitones")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.operators[unit].setSemitoneOffset(value); });
+            }
+            
+            else throw ParseError("Unknown operator parameter '" + parameter + "' in " + where(fname, number));
+        }
+        
+        else if (key == "noise" && words.size() == 3)
+        {
+            const std::string& parameter = words[1];
+            
+            const double value = toNumber(words[2], fname, number);
+            
+            if (parameter == "active")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.noise.setActive(value != 0); });
+            }
+            
+            else if (parameter == "color")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.noise.setColor(value); });
+            }
+            
+            else if (parameter == "amp")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.noise.setAmp(value); });
+            }
+            
+            else if (parameter == "seed")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.noise.setSeed(value); });
+            }
+            
+            else throw ParseError("Unknown noise parameter '" + parameter + "' in " + where(fname, number));
+        }
+        
+        else if (words.size() == 2)
+        {
+            const double value = toNumber(words[1], fname, number);
+            
+            if (key == "algorithm")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.fm.setAlgorithm(value); });
+            }
+            
+            else if (key == "master")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.mixer.setMasterAmp(value); });
+            }
+            
+            else if (key == "pan")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.mixer.setPanValue(value); });
+            }
+            
+            else if (key == "tempo")
+            {
+                parameters.push_back([=] (Anthem& anthem) { anthem.getContext().setTempo(value); });
+            }
+            
+            else throw ParseError("Unknown parameter '" + key + "' in " + where(fname, number));
+        }
+        
+        else throw ParseError("Invalid parameter line in " + where(fname, number));
+    }
+    
+    return [parameters] (Anthem& anthem)
+    {
+        for (std::vector<patch_t>::const_iterator itr = parameters.begin(), end = parameters.end();
+             itr != end;
+             ++itr)
+        {
+            (*itr)(anthem);
+        }
+    };
+}
+
+std::vector<BatchRenderer::Event> BatchRenderer::loadNotes(const std::string& fname)
+{
+    std::ifstream file;
+    
+    openFile(file, fname);
+    
+    std::vector<Event> events;
+    
+    std::vector<std::string> words;
+    
+    unsigned long number = 0;
+    
+    while (nextLine(file, words, number))
+    {
+        if (words.size() != 3 || (words[2] != "on" && words[2] != "off"))
+        { throw ParseError("Expected seconds, note and on or off in " + where(fname, number)); }
+        
+        const double time = toNumber(words[0], fname, number);
+        
+        const double note = toNumber(words[1], fname, number);
+        
+        if (time < 0)
+        { throw ParseError("Negative time in " + where(fname, number)); }
+        
+        if (note < 0 || note > 127 || note != static_cast<unsigned char>(note))
+        { throw ParseError("Invalid note in " + where(fname, number)); }
+        
+        Event event = { time, static_cast<unsigned char>(note), words[2] == "on" };
+        
+        events.push_back(event);
+    }
+    
+    return events;
+}
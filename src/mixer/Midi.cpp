@@ -13,9 +13,8 @@
 
 #include <stdexcept>
 
-Anthem* Midi::_anthem = 0;
-
 Midi::Midi()
+: _anthem(0)
 {
     // Try to open default midi port if any
     if (_midi.getPortCount())
@@ -36,14 +35,14 @@ void Midi::init(Anthem *anthem)
 {
     _anthem = anthem;
     
-    _midi.setCallback(&_callback);
+    _midi.setCallback(&_callback, this);
 }
 
 void Midi::_callback(double timestamp,
                      std::vector<byte_t>* message,
                      void* userData)
 {
-    _anthem->setNote((*message)[1], (*message)[2]);
+    static_cast<Midi*>(userData)->_anthem->setNote((*message)[1], (*message)[2]);
 }
 
 void Midi::openPort(byte_t portID)
@@ -0,0 +1,385 @@
+/********************************************************************************************//*!
+*
+*  @file        MidiFile.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "MidiFile.hpp"
+#include "Parsley.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+const std::size_t MidiFile::_bufferSize;
+
+namespace
+{
+    /*! Reads a big-endian integer of count bytes */
+    uint32_t readBigEndian(std::istream& stream, unsigned short count)
+    {
+        char bytes [4];
+        
+        if (! stream.read(bytes, count)) return 0;
+        
+        uint32_t value = 0;
+        
+        for (unsigned short i = 0; i < count; ++i)
+        {
+            value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+        }
+        
+        return value;
+    }
+}
+
+MidiFile::MidiFile(const std::string& fname, unsigned int samplerate)
+: _file(fname, std::ios::in | std::ios::binary),
+  _fname(fname),
+  _samplerate(samplerate)
+{
+    if (! samplerate)
+    { throw std::invalid_argument("Samplerate must be greater than zero!"); }
+    
+    if (! _file)
+    { throw FileOpenError("Error opening MIDI file: " + fname); }
+    
+    char id [4];
+    
+    if (! _file.read(id, 4) || memcmp(id, "MThd", 4))
+    { throw ParseError("Not a MIDI file: " + fname); }
+    
+    const uint32_t headerSize = readBigEndian(_file, 4);
+    
+    _format = readBigEndian(_file, 2);
+    
+    const uint16_t tracks = readBigEndian(_file, 2);
+    
+    _division = readBigEndian(_file, 2);
+    
+    if (! _file || headerSize < 6)
+    { throw ParseError("Invalid header in MIDI file: " + fname); }
+    
+    if (_format > 1)
+    { throw ParseError("Only format 0 and 1 MIDI files are supported: " + fname); }
+    
+    if (! _division)
+    { throw ParseError("Invalid division in MIDI file: " + fname); }
+    
+    std::streamoff position = 8 + headerSize;
+    
+    _file.seekg(position);
+    
+    // Only note where the tracks are, unknown chunks are skipped
+    while (_chunks.size() < tracks && _file.read(id, 4))
+    {
+        const uint32_t size = readBigEndian(_file, 4);
+        
+        if (! _file)
+        { throw ParseError("Truncated chunk in MIDI file: " + fname); }
+        
+        position += 8;
+        
+        if (! memcmp(id, "MTrk", 4))
+        {
+            _chunks.push_back(std::make_pair(position, position + size));
+        }
+        
+        position += size;
+        
+        _file.seekg(position);
+    }
+    
+    if (_chunks.size() < tracks)
+    { throw ParseError("Missing tracks in MIDI file: " + fname); }
+    
+    if (_format == 0 && tracks != 1)
+    { throw ParseError("Format 0 MIDI file with more than one track: " + fname); }
+    
+    rewind();
+}
+
+void MidiFile::rewind()
+{
+    _file.clear();
+    
+    _tracks.resize(_chunks.size());
+    
+    for (std::size_t i = 0; i < _chunks.size(); ++i)
+    {
+        Track& track = _tracks[i];
+        
+        track.position = _chunks[i].first;
+        track.end = _chunks[i].second;
+        track.buffer.clear();
+        track.index = 0;
+        track.tick = 0;
+        track.status = 0;
+        track.done = false;
+        
+        _advance(track);
+    }
+    
+    _tempoTick = 0;
+    
+    _tempoTime = 0;
+    
+    // SMPTE division: negative frames per second in the upper
+    // byte (-29 meaning 29.97) and ticks per frame in the lower
+    if (_division & 0x8000)
+    {
+        const int fps = -static_cast<signed char>(_division >> 8);
+        
+        const double frames = (fps == 29) ? 29.97 : fps;
+        
+        _secondsPerTick = 1 / (frames * (_division & 0xFF));
+    }
+    
+    // 120 beats per minute until the first tempo event
+    else _secondsPerTick = 0.5 / _division;
+}
+
+bool MidiFile::next(Event& event)
+{
+    while (true)
+    {
+        // The track with the earliest next event, the
+        // first one of them if several are equally early
+        Track* track = nullptr;
+        
+        for (std::vector<Track>::iterator itr = _tracks.begin(), end = _tracks.end();
+             itr != end;
+             ++itr)
+        {
+            if (! itr->done && (! track || itr->tick < track->tick)) track = &(*itr);
+        }
+        
+        if (! track) return false;
+        
+        const uint64_t tick = track->tick;
+        
+        byte_t status = _read(*track);
+        
+        bool returned = false;
+        
+        if (status == 0xFF)
+        {
+            const byte_t type = _read(*track);
+            
+            const uint32_t length = _readVariable(*track);
+            
+            // Meta events cancel the running status
+            track->status = 0;
+            
+            if (type == 0x2F)
+            {
+                track->done = true;
+                
+                continue;
+            }
+            
+            else if (type == 0x51 && length == 3)
+            {
+                uint32_t microseconds = _read(*track) << 16;
+                
+                microseconds |= _read(*track) << 8;
+                
+                microseconds |= _read(*track);
+                
+                if (! microseconds)
+                { throw ParseError("Invalid tempo in MIDI file: " + _fname); }
+                
+                event.time = _toSeconds(tick);
+                
+                // With SMPTE timing, ticks do not depend on the tempo
+                if (! (_division & 0x8000))
+                {
+                    _tempoTick = tick;
+                    
+                    _tempoTime = event.time;
+                    
+                    _secondsPerTick = microseconds / (1e6 * _division);
+                }
+                
+                event.type = TEMPO;
+                event.channel = event.number = event.value = 0;
+                event.tempo = 6e7 / microseconds;
+                
+                returned = true;
+            }
+            
+            else _skip(*track, length);
+        }
+        
+        // System exclusive
+        else if (status == 0xF0 || status == 0xF7)
+        {
+            track->status = 0;
+            
+            _skip(*track, _readVariable(*track));
+        }
+        
+        else
+        {
+            byte_t first;
+            
+            if (status & 0x80)
+            {
+                if (status > 0xEF)
+                { throw ParseError("Invalid status byte in MIDI file: " + _fname); }
+                
+                track->status = status;
+                
+                first = _read(*track);
+            }
+            
+            // Running status, the byte is already data
+            else
+            {
+                if (! track->status)
+                { throw ParseError("Data byte without status in MIDI file: " + _fname); }
+                
+                first = status;
+                
+                status = track->status;
+            }
+            
+            const byte_t kind = status & 0xF0;
+            
+            // Program change and channel pressure have one data byte
+            const byte_t second = (kind == 0xC0 || kind == 0xD0) ? 0 : _read(*track);
+            
+            if (kind == 0x80 || kind == 0x90 || kind == 0xB0)
+            {
+                if (kind == 0xB0) event.type = CONTROL_CHANGE;
+                
+                else event.type = (kind == 0x90 && second) ? NOTE_ON : NOTE_OFF;
+                
+                event.time = _toSeconds(tick);
+                event.channel = status & 0x0F;
+                event.number = first & 0x7F;
+                event.value = second & 0x7F;
+                event.tempo = 0;
+                
+                returned = true;
+            }
+        }
+        
+        _advance(*track);
+        
+        if (returned)
+        {
+            event.frame = static_cast<frame_t>(std::floor(event.time * _samplerate + 0.5));
+            
+            return true;
+        }
+    }
+}
+
+unsigned short MidiFile::getFormat() const
+{
+    return _format;
+}
+
+std::size_t MidiFile::getTrackCount() const
+{
+    return _tracks.size();
+}
+
+uint16_t MidiFile::getDivision() const
+{
+    return _division;
+}
+
+unsigned int MidiFile::getSamplerate() const
+{
+    return _samplerate;
+}
+
+MidiFile::byte_t MidiFile::_read(Track& track)
+{
+    if (track.index == track.buffer.size())
+    {
+        if (track.position >= track.end)
+        { throw ParseError("Truncated track in MIDI file: " + _fname); }
+        
+        const std::streamoff size = std::min<std::streamoff>(_bufferSize, track.end - track.position);
+        
+        track.buffer.resize(size);
+        
+        _file.clear();
+        
+        _file.seekg(track.position);
+        
+        if (! _file.read(&track.buffer[0], size))
+        { throw ParseError("Truncated track in MIDI file: " + _fname); }
+        
+        track.position += size;
+        
+        track.index = 0;
+    }
+    
+    return track.buffer[track.index++];
+}
+
+uint32_t MidiFile::_readVariable(Track& track)
+{
+    uint32_t value = 0;
+    
+    // At most four bytes, seven bits each
+    for (unsigned short i = 0; i < 4; ++i)
+    {
+        const byte_t byte = _read(track);
+        
+        value = (value << 7) | (byte & 0x7F);
+        
+        if (! (byte & 0x80)) return value;
+    }
+    
+    throw ParseError("Invalid variable-length quantity in MIDI file: " + _fname);
+}
+
+void MidiFile::_skip(Track& track, uint32_t count)
+{
+    const std::size_t buffered = track.buffer.size() - track.index;
+    
+    if (count <= buffered)
+    {
+        track.index += count;
+        
+        return;
+    }
+    
+    // Drop the buffer and continue after the skipped bytes
+    track.position += count - buffered;
+    
+    track.buffer.clear();
+    
+    track.index = 0;
+    
+    if (track.position > track.end)
+    { throw ParseError("Truncated track in MIDI file: " + _fname); }
+}
+
+void MidiFile::_advance(Track& track)
+{
+    // Tracks without an end-of-track event just end
+    if (track.index == track.buffer.size() && track.position >= track.end)
+    {
+        track.done = true;
+        
+        return;
+    }
+    
+    track.tick += _readVariable(track);
+}
+
+double MidiFile::_toSeconds(uint64_t tick)
+{
+    return _tempoTime + (tick - _tempoTick) * _secondsPerTick;
+}
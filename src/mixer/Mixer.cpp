@@ -9,6 +9,7 @@
 ************************************************************************************************/
 
 #include "Mixer.hpp"
+#include "AudioBuffer.hpp"
 #include "Global.hpp"
 #include "Crossfader.hpp"
 #include "Sample.hpp"
@@ -18,9 +19,12 @@ Mixer::Mixer(double amp)
 
 : Unit(2),
   _masterAmp(amp), _recording(false),
-  _pan(new CrossfadeUnit)
+  _pan(Arena::make<CrossfadeUnit>())
 
 {
+    _gainLeft = _pan->left() * _masterAmp;
+    _gainRight = _pan->right() * _masterAmp;
+    
     // Initialize ModDocks
     _mods[MASTER_AMP].setHigherBoundary(1);
     _mods[MASTER_AMP].setLowerBoundary(0);
@@ -34,8 +38,10 @@ Mixer::Mixer(double amp)
 Mixer::Mixer(const Mixer& other)
 : Unit(other),
   _masterAmp(other._masterAmp),
+  _gainLeft(other._gainLeft),
+  _gainRight(other._gainRight),
   _recording(other._recording),
-  _pan(new CrossfadeUnit(*other._pan)),
+  _pan(Arena::make<CrossfadeUnit>(*other._pan)),
   _wavefile(other._wavefile)
 { }
 
@@ -47,6 +53,10 @@ Mixer& Mixer::operator= (const Mixer& other)
         
         _masterAmp = other._masterAmp;
         
+        _gainLeft = other._gainLeft;
+        
+        _gainRight = other._gainRight;
+        
         _recording = other._recording;
         
         *_pan = *other._pan;
@@ -57,7 +67,7 @@ Mixer& Mixer::operator= (const Mixer& other)
     return *this;
 }
 
-Sample Mixer::process(Sample sample)
+void Mixer::process(AudioBuffer& buffer, bool silent)
 {
     // Modulate panning value
     if (_mods[PAN].inUse())
@@ -70,20 +80,24 @@ Sample Mixer::process(Sample sample)
         _masterAmp = _mods[MASTER_AMP].tick();
     }
     
-    // Attenuate samples with panning
-    sample.left *= _pan->left();
-    sample.right *= _pan->right();
+    // Combine panning and master amplitude
+    double left = _pan->left() * _masterAmp;
+    double right = _pan->right() * _masterAmp;
     
-    // Apply master amplitude
-    sample *= _masterAmp;
+    // Ramp from the last block's gains to avoid zipper noise
+    if (! silent)
+    {
+        buffer.panRamp(_gainLeft, left, _gainRight, right);
+    }
+    
+    _gainLeft = left;
+    _gainRight = right;
     
     // Send to wavefile if recording
     if (_recording)
     {
-        _wavefile.process(sample);
+        _wavefile.process(buffer);
     }
-    
-    return sample;
 }
 
 void Mixer::setMasterAmp(double amp)
@@ -9,10 +9,13 @@
 ************************************************************************************************/
 
 #include "Wavefile.hpp"
-#include "Global.hpp"
+#include "AudioBuffer.hpp"
+#include "EngineContext.hpp"
 #include "Util.hpp"
 #include "Sample.hpp"
+#include "Parsley.hpp"
 
+#include <cstring>
 #include <stdint.h>
 #include <stdexcept>
 
@@ -30,7 +33,7 @@ Wavefile::Wavefile(const std::string& fname, unsigned short channels)
     
 	_header.channels = channels;    // 1 = mono, 2 = stereo
     
-	_header.samplerate = Global::samplerate;
+	_header.samplerate = EngineContext::current().getSamplerate();
     
     _header.bits = 16;
     
@@ -40,23 +43,16 @@ Wavefile::Wavefile(const std::string& fname, unsigned short channels)
     
 	memcpy(_header.waveId, "data", 4*sizeof(char));
     
-    open(fname);
+    // Without a name, the file is only created once written
+    if (! fname.empty()) open(fname);
 }
 
 Wavefile::Wavefile(const Wavefile& other)
 : _fname(other._fname),
   _file(other._fname, std::ios::out | std::ios::binary | std::ios::trunc),
-  _header(other._header)
-{
-    // Copy buffer data
-    for(std::deque<std::unique_ptr<Sample>>::const_iterator itr = other._buffer.begin(),
-        end = other._buffer.begin();
-        itr != end;
-        ++itr)
-    {
-        _buffer.push_back(std::unique_ptr<Sample>(new Sample(*(*itr))));
-    }
-}
+  _header(other._header),
+  _buffer(other._buffer)
+{ }
 
 Wavefile& Wavefile::operator= (const Wavefile& other)
 {
@@ -70,14 +66,7 @@ Wavefile& Wavefile::operator= (const Wavefile& other)
         
         _header = other._header;
         
-        // Copy buffer data
-        for(std::deque<std::unique_ptr<Sample>>::const_iterator itr = other._buffer.begin(),
-            end = other._buffer.begin();
-            itr != end;
-            ++itr)
-        {
-            _buffer.push_back(std::unique_ptr<Sample>(new Sample(*(*itr))));
-        }
+        _buffer = other._buffer;
     }
     
     return *this;
@@ -103,7 +92,18 @@ void Wavefile::close()
 
 void Wavefile::process(const Sample &sample)
 {
-    _buffer.push_back(std::unique_ptr<Sample>(new Sample(sample)));
+    _buffer.push_back(sample);
+}
+
+void Wavefile::process(const AudioBuffer& buffer)
+{
+    const double* left = buffer.left();
+    const double* right = buffer.right();
+    
+    for (AudioBuffer::size_t n = 0, end = buffer.size(); n < end; ++n)
+    {
+        _buffer.push_back(Sample(left[n], right[n]));
+    }
 }
 
 void Wavefile::flush()
@@ -113,6 +113,8 @@ void Wavefile::flush()
 
 void Wavefile::write()
 {
+    if (! _file.is_open()) open(std::string());
+    
     unsigned int totalSamples = static_cast<unsigned int>(_buffer.size());
     
     _header.waveSize = totalSamples * _header.align;
@@ -127,11 +129,11 @@ void Wavefile::write()
     for (unsigned long n = 0; n < twoTotalSamples;)
     {
         // Convert to 16 bit integer
-        (*_buffer.front()) *= 32767;
+        _buffer.front() *= 32767;
         
         // Write to both channels (first channel 1, then channel 2)
-        outBuffer[n++] = _buffer.front()->left;
-        outBuffer[n++] = _buffer.front()->right;
+        outBuffer[n++] = _buffer.front().left;
+        outBuffer[n++] = _buffer.front().right;
         
         _buffer.pop_front();
     }
@@ -140,4 +142,127 @@ void Wavefile::write()
     if (! _file.write(reinterpret_cast<char*>(&_header), sizeof(_header)) ||
         ! _file.write(reinterpret_cast<char*>(outBuffer), _header.waveSize))
     { throw std::runtime_error("Error writing to file"); }
-}
\ No newline at end of file
+}
+
+std::vector<double> Wavefile::load(const std::string& fname, unsigned int* samplerate)
+{
+    std::ifstream file(fname, std::ios::in | std::ios::binary);
+    
+    if (! file)
+    { throw FileOpenError("Error opening wavefile: " + fname); }
+    
+    char id [4];
+    
+    uint32_t size;
+    
+    if (! file.read(id, 4) || memcmp(id, "RIFF", 4) ||
+        ! file.read(reinterpret_cast<char*>(&size), 4) ||
+        ! file.read(id, 4) || memcmp(id, "WAVE", 4))
+    { throw ParseError("Not a wavefile: " + fname); }
+    
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint32_t rate = 0;
+    uint16_t bits = 0;
+    
+    std::vector<char> data;
+    
+    // Walk the chunks, only the format and data chunks are of interest
+    while (file.read(id, 4) && file.read(reinterpret_cast<char*>(&size), 4))
+    {
+        if (! memcmp(id, "fmt ", 4))
+        {
+            std::vector<char> fmt(size);
+            
+            if (size < 16 || ! file.read(&fmt[0], size))
+            { throw ParseError("Invalid format chunk in wavefile: " + fname); }
+            
+            memcpy(&format, &fmt[0], 2);
+            memcpy(&channels, &fmt[2], 2);
+            memcpy(&rate, &fmt[4], 4);
+            memcpy(&bits, &fmt[14], 2);
+            
+            // WAVE_FORMAT_EXTENSIBLE stores the actual
+            // format in the first bytes of the sub-format
+            if (format == 0xFFFE && size >= 26)
+            {
+                memcpy(&format, &fmt[24], 2);
+            }
+        }
+        
+        else if (! memcmp(id, "data", 4))
+        {
+            data.resize(size);
+            
+            if (size && ! file.read(&data[0], size))
+            { throw ParseError("Truncated data chunk in wavefile: " + fname); }
+        }
+        
+        else file.seekg(size, std::ios::cur);
+        
+        // Chunks are padded to an even size
+        if (size & 1) file.seekg(1, std::ios::cur);
+    }
+    
+    if (! channels || ! bits)
+    { throw ParseError("Missing format chunk in wavefile: " + fname); }
+    
+    const bool isFloat = format == 3;
+    
+    if ((format != 1 && ! isFloat) ||
+        (isFloat && bits != 32 && bits != 64) ||
+        (! isFloat && bits != 8 && bits != 16 && bits != 24 && bits != 32))
+    { throw ParseError("Unsupported sample format in wavefile: " + fname); }
+    
+    const std::size_t bytes = bits / 8;
+    
+    const std::size_t frames = data.size() / (bytes * channels);
+    
+    std::vector<double> samples(frames, 0);
+    
+    const char* byte = data.empty() ? nullptr : &data[0];
+    
+    for (std::size_t n = 0; n < frames; ++n)
+    {
+        for (unsigned short c = 0; c < channels; ++c, byte += bytes)
+        {
+            double value;
+            
+            if (isFloat && bits == 32)
+            {
+                float f;
+                
+                memcpy(&f, byte, 4);
+                
+                value = f;
+            }
+            
+            else if (isFloat) memcpy(&value, byte, 8);
+            
+            // 8 bit samples are unsigned
+            else if (bits == 8) value = (static_cast<uint8_t>(*byte) - 128) / 128.0;
+            
+            else
+            {
+                // Little-endian, assemble into the top of
+                // a 32 bit integer to keep the sign
+                uint32_t word = 0;
+                
+                for (std::size_t b = 0; b < bytes; ++b)
+                {
+                    word |= static_cast<uint32_t>(static_cast<uint8_t>(byte[b])) << (32 - bits + 8 * b);
+                }
+                
+                value = static_cast<int32_t>(word) / 2147483648.0;
+            }
+            
+            samples[n] += value;
+        }
+        
+        samples[n] /= channels;
+    }
+    
+    if (samplerate) *samplerate = rate;
+    
+    return samples;
+}
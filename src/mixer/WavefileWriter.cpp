@@ -0,0 +1,142 @@
+/********************************************************************************************//*!
+*
+*  @file        WavefileWriter.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+************************************************************************************************/
+
+#include "WavefileWriter.hpp"
+#include "AudioBuffer.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    /*! Converts a sample to 16 bit, clipping it to [-1, 1] */
+    inline int16_t toInt16(double sample)
+    {
+        if (sample > 1) sample = 1;
+        
+        else if (sample < -1) sample = -1;
+        
+        return static_cast<int16_t>(sample * 32767);
+    }
+}
+
+WavefileWriter::WavefileWriter(const std::string& path, unsigned int samplerate)
+: _path(path),
+  _samplerate(samplerate),
+  _frames(0),
+  _file(path, std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    if (! _file)
+    { throw std::runtime_error("Error creating wavefile: " + path); }
+    
+    // Placeholder sizes until close()
+    _writeHeader();
+}
+
+WavefileWriter::~WavefileWriter()
+{
+    try
+    {
+        close();
+    }
+    
+    catch(...)
+    { }
+}
+
+void WavefileWriter::write(const AudioBuffer& buffer)
+{
+    const AudioBuffer::size_t size = buffer.size();
+    
+    // Four bytes per frame, the data size is stored in 32 bits
+    if ((_frames + size) * 4 > 0xFFFFFFFF - 36)
+    { throw std::runtime_error("Wavefile too large: " + _path); }
+    
+    const double* left = buffer.left();
+    const double* right = buffer.right();
+    
+    _block.resize(2 * size);
+    
+    for (AudioBuffer::size_t n = 0; n < size; ++n)
+    {
+        _block[2 * n] = toInt16(left[n]);
+        _block[2 * n + 1] = toInt16(right[n]);
+    }
+    
+    if (size && ! _file.write(reinterpret_cast<const char*>(&_block[0]), 4 * size))
+    { throw std::runtime_error("Error writing to wavefile: " + _path); }
+    
+    _frames += size;
+}
+
+void WavefileWriter::close()
+{
+    if (! _file.is_open()) return;
+    
+    _file.seekp(0);
+    
+    _writeHeader();
+    
+    _file.close();
+    
+    if (_file.fail())
+    { throw std::runtime_error("Error writing to wavefile: " + _path); }
+}
+
+WavefileWriter::size_t WavefileWriter::frames() const
+{
+    return _frames;
+}
+
+const std::string& WavefileWriter::path() const
+{
+    return _path;
+}
+
+void WavefileWriter::_writeHeader()
+{
+    // Same layout as the header of Wavefile
+    struct
+    {
+        uint8_t riffId[4];
+        uint32_t riffSize;
+        uint8_t wavetype[4];
+        uint8_t fmtId[4];
+        uint32_t fmtSize;
+        uint16_t fmtCode;
+        uint16_t channels;
+        uint32_t samplerate;
+        uint32_t byterate;
+        uint16_t align;
+        uint16_t bits;
+        uint8_t waveId[4];
+        uint32_t waveSize;
+        
+    } header;
+    
+    memcpy(header.riffId, "RIFF", 4);
+    memcpy(header.wavetype, "WAVE", 4);
+    memcpy(header.fmtId, "fmt ", 4);
+    memcpy(header.waveId, "data", 4);
+    
+    header.fmtSize = 16;
+    header.fmtCode = 1;
+    header.channels = 2;
+    header.samplerate = _samplerate;
+    header.bits = 16;
+    header.align = 4;
+    header.byterate = _samplerate * header.align;
+    
+    header.waveSize = static_cast<uint32_t>(_frames * header.align);
+    header.riffSize = header.waveSize + sizeof(header) - 8;
+    
+    if (! _file.write(reinterpret_cast<const char*>(&header), sizeof(header)))
+    { throw std::runtime_error("Error writing to wavefile: " + _path); }
+}
@@ -80,7 +80,10 @@ void CrossfadeUnit::setValue(double value)
     
     _index = value + 100;
     
-    _curr = _table->interpolate(_index);
+    // The last value has nothing to interpolate with
+    if (_index >= _table->size() - 1) _curr = (*_table)[_table->size() - 1];
+    
+    else _curr = _table->interpolate(_index);
 }
 
 double CrossfadeUnit::getValue() const
@@ -153,11 +156,7 @@ double Crossfader::getValue() const
 
 double Crossfader::modulate(double sample, double depth, double maximum)
 {
-    // Modulate value
-    if (_mods[VALUE].inUse())
-    {
-        _index = _mods[VALUE].tick() + 100;
-    }
+    modulateValue();
     
     // Get left and right ticks (if a ModUnit is available) and fade them appropriately to current
     // crossfading values (left() and right())
@@ -169,6 +168,16 @@ double Crossfader::modulate(double sample, double depth, double maximum)
     return (left + right) * _amp;
 }
 
+void Crossfader::modulateValue()
+{
+    // Through CrossfadeUnit::setValue() so that the
+    // crossfading values follow the modulated value
+    if (_mods[VALUE].inUse())
+    {
+        CrossfadeUnit::setValue(_mods[VALUE].tick());
+    }
+}
+
 void Crossfader::setLeftUnit(ModUnit* unit)
 {
     _leftUnit = unit;
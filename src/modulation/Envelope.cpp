@@ -12,10 +12,17 @@
 #include "Global.hpp"
 #include "ModDock.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
+const EnvelopeSegment::length_t Envelope::blockSize;
+
 Envelope::Envelope(bool sustainEnabled)
 : ModEnvelopeSegmentSequenceFlexible(7,1),
+  _lastTick(0),
   _sustainEnabled(sustainEnabled),
-  _lastTick(0)
+  _position(0),
+  _blockLength(0)
 {
     _currSegment = _segments.begin() + Segments::DELAY;
     
@@ -24,7 +31,7 @@ Envelope::Envelope(bool sustainEnabled)
     // too long to be noticed too much but just enough
     // to prevent transitions between loops from being
     // too abrupt
-    _segments[CONNECTOR].setLength(Global::samplerate / 40.0);
+    _segments[CONNECTOR].setLength(_context->getSamplerate() / 40.0);
     
     // Initial settings
     /*
@@ -154,6 +161,109 @@ double Envelope::_tick()
     return _lastTick;
 }
 
+void Envelope::renderBlock(double* block, EnvelopeSegment::length_t size)
+{
+    while (size)
+    {
+        // The same transitions as in _tick(), but
+        // only once per segment instead of per sample
+        if (_currSample >= _currSegment->getLength())
+        {
+            if (_currSegmentNum == Segments::RELEASE)
+            {
+                std::fill(block, block + size, 0.0);
+                
+                _currSample += size;
+                
+                return;
+            }
+            
+            else if (_currSegmentNum == Hidden::CONNECTOR)
+            {
+                _changeSegment(_loopStart);
+            }
+            
+            else if (_currSegment == _loopEnd && (_loopInf || _loopCount++ < _loopMax))
+            {
+                _resetLoop();
+            }
+            
+            else if (_currSegmentNum == Segments::C && _sustainEnabled)
+            {
+                std::fill(block, block + size, _lastTick);
+                
+                _currSample += size;
+                
+                return;
+            }
+            
+            else
+            {
+                _changeSegment(++_currSegment);
+                
+                // Segments without length hold the last tick for a sample
+                if (! _currSegment->getLength())
+                {
+                    *block++ = _lastTick;
+                    
+                    EnvelopeSegmentSequence::update();
+                    
+                    --size;
+                    
+                    continue;
+                }
+            }
+        }
+        
+        const EnvelopeSegment::length_t length = _currSegment->getLength();
+        
+        // Segments without length still tick once
+        // (their end level) after a transition
+        EnvelopeSegment::length_t run = (_currSample < length) ? length - _currSample : 1;
+        
+        if (run > size) run = size;
+        
+        _currSegment->generate(block, run);
+        
+        _lastTick = block[run - 1];
+        
+        _currSample += run;
+        
+        block += run;
+        
+        size -= run;
+    }
+}
+
+void Envelope::render(EnvelopeSegment::length_t size)
+{
+    if (size > blockSize)
+    { throw std::invalid_argument("Cannot render more than Envelope::blockSize levels at once!"); }
+    
+    // The levels are rendered from the current position,
+    // whatever was left of the previous block is dropped
+    _position = _blockLength = 0;
+    
+    renderBlock(_block, size);
+    
+    _blockLength = size;
+}
+
+void Envelope::update()
+{
+    // The segments are already past the rendered levels
+    if (_position < _blockLength) ++_position;
+    
+    else EnvelopeSegmentSequence::update();
+}
+
+void Envelope::reset()
+{
+    _position = _blockLength = 0;
+    
+    ModEnvelopeSegmentSequenceFlexible::reset();
+}
+
 double Envelope::modulate(double sample, double depth, double maximum)
 {
     // Modulate
@@ -162,7 +272,9 @@ double Envelope::modulate(double sample, double depth, double maximum)
         _amp = _mods[AMP].tick();
     }
     
-    return sample + (maximum * _tick() * depth * _amp);
+    const double level = (_position < _blockLength) ? _block[_position] : _tick();
+    
+    return sample + (maximum * level * depth * _amp);
 }
 
 void Envelope::setLoopStart(segment_t segment)
@@ -245,6 +357,9 @@ double Envelope::getSegmentLevel(segment_t segment) const
 
 void Envelope::noteOff()
 {
+    // Tick from the release on
+    _position = _blockLength = 0;
+    
     // If we aren't already in the release segmentment
     if (_currSegmentNum != Segments::RELEASE)
     {
@@ -12,9 +12,17 @@
 #include "Global.hpp"
 #include "Wavetable.hpp"
 #include "ModDock.hpp"
+#include "Util.hpp"
+#include "FastMath.hpp"
 
+#include <algorithm>
 #include <cmath>
 
+const std::size_t EnvelopeSegment::_shapeSize = 512;
+
+// Radical curves are too steep to interpolate over the first steps
+const double EnvelopeSegment::_shapeExact = 8.0 / EnvelopeSegment::_shapeSize;
+
 EnvelopeSegment::EnvelopeSegment(double startLevel,
                double endLevel,
                length_t len,
@@ -23,6 +31,9 @@ EnvelopeSegment::EnvelopeSegment(double startLevel,
 : _startLevel(startLevel),
   _endLevel(endLevel),
   _rate(rate),
+  _shapeSequence(0),
+  _shapeRate(-1),
+  _shape(_shapeSize + 1),
   _curr(0),
   _len(len),
   GenUnit(3) // three ModDocks
@@ -42,6 +53,49 @@ EnvelopeSegment::EnvelopeSegment(double startLevel,
     
     _calculateRange();
     _calculateIncr();
+    _calculateShape();
+}
+
+EnvelopeSegment::EnvelopeSegment(const EnvelopeSegment& other)
+: GenUnit(other),
+  _rate(other._rate),
+  _shapeSequence(0),
+  _shapeRate(-1),
+  _shape(_shapeSize + 1),
+  _startLevel(other._startLevel),
+  _endLevel(other._endLevel),
+  _range(other._range),
+  _curr(other._curr),
+  _incr(other._incr),
+  _len(other._len)
+{
+    _calculateShape();
+}
+
+EnvelopeSegment& EnvelopeSegment::operator= (const EnvelopeSegment& other)
+{
+    if (this != &other)
+    {
+        GenUnit::operator=(other);
+        
+        _rate = other._rate;
+        
+        _startLevel = other._startLevel;
+        
+        _endLevel = other._endLevel;
+        
+        _range = other._range;
+        
+        _curr = other._curr;
+        
+        _incr = other._incr;
+        
+        _len = other._len;
+        
+        _calculateShape();
+    }
+    
+    return *this;
 }
 
 void EnvelopeSegment::reset()
@@ -60,6 +114,93 @@ void EnvelopeSegment::_calculateIncr()
     _incr = (_len) ? 1.0/_len : 0;
 }
 
+void EnvelopeSegment::_calculateShape()
+{
+    const double rate = _rate;
+    
+    // Linear segments need no table, but it stays allocated
+    // so that it is never reallocated under the audio thread
+    if (rate == 1)
+    {
+        _publishShape(nullptr, rate);
+        
+        return;
+    }
+    
+    double values [_shapeSize + 1];
+    
+    for (std::size_t n = 0; n <= _shapeSize; ++n)
+    {
+        values[n] = static_cast<double>(n) / _shapeSize;
+    }
+    
+    FastMath::pow(values, rate, values, _shapeSize + 1);
+    
+    // Steep curves underflow near their start
+    std::transform(values, values + _shapeSize + 1, values, Util::flushDenormal);
+    
+    _publishShape(values, rate);
+}
+
+void EnvelopeSegment::_publishShape(const double* values, double rate)
+{
+    // Only ever written by one thread, so no read-modify-write
+    const unsigned long sequence = _shapeSequence.load(std::memory_order_relaxed);
+    
+    _shapeSequence.store(sequence + 1, std::memory_order_relaxed);
+    
+    // Keeps the writes below from moving before the odd value
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    if (values)
+    {
+        for (std::size_t n = 0; n <= _shapeSize; ++n)
+        {
+            _shape[n].store(values[n], std::memory_order_relaxed);
+        }
+    }
+    
+    _shapeRate.store(rate, std::memory_order_relaxed);
+    
+    _shapeSequence.store(sequence + 2, std::memory_order_release);
+}
+
+double EnvelopeSegment::_shapeValue() const
+{
+    if (_rate == 1) return _curr;
+    
+    const unsigned long sequence = _shapeSequence.load(std::memory_order_acquire);
+    
+    // The rate is being modulated, the table is being
+    // written or the curve is too steep here, so compute
+    // the value exactly
+    if ((sequence & 1) ||
+        _rate != _shapeRate.load(std::memory_order_relaxed) ||
+        _curr < _shapeExact)
+    {
+        return Util::flushDenormal(FastMath::pow(_curr, _rate));
+    }
+    
+    const double position = _curr * _shapeSize;
+    
+    const std::size_t integral = static_cast<std::size_t>(position);
+    
+    const double lower = _shape[integral].load(std::memory_order_relaxed);
+    
+    const double upper = _shape[integral + 1].load(std::memory_order_relaxed);
+    
+    // Keeps the reads above from moving after the check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    
+    // Written in the meantime, the values may be torn
+    if (_shapeSequence.load(std::memory_order_relaxed) != sequence)
+    {
+        return Util::flushDenormal(FastMath::pow(_curr, _rate));
+    }
+    
+    return lower + (upper - lower) * (position - integral);
+}
+
 void EnvelopeSegment::update()
 {
     // Increment _curr
@@ -98,7 +239,44 @@ double EnvelopeSegment::tick()
         _calculateRange();
     }
     
-    return _range * std::pow(_curr, _rate) + _startLevel;
+    return _range * _shapeValue() + _startLevel;
+}
+
+void EnvelopeSegment::generate(double* block, length_t size)
+{
+    if (_mods[RATE].inUse()        ||
+        _mods[START_LEVEL].inUse() ||
+        _mods[END_LEVEL].inUse())
+    {
+        for (length_t n = 0; n < size; ++n)
+        {
+            block[n] = tick();
+            
+            update();
+        }
+        
+        return;
+    }
+    
+    length_t n = 0;
+    
+    if (_len)
+    {
+        for ( ; n < size && _curr < 1; ++n)
+        {
+            block[n] = _range * _shapeValue() + _startLevel;
+            
+            _curr += _incr;
+        }
+    }
+    
+    // Past the end of the segment
+    for ( ; n < size; ++n)
+    {
+        block[n] = _endLevel;
+        
+        _curr += _incr;
+    }
 }
 
 void EnvelopeSegment::setLength(EnvelopeSegment::length_t sampleLength)
@@ -171,6 +349,8 @@ void EnvelopeSegment::setRate(double rate)
     _rate = rate;
     
     _mods[RATE].setBaseValue(_rate);
+    
+    _calculateShape();
 }
 
 double EnvelopeSegment::getRate() const
@@ -199,7 +379,7 @@ EnvelopeSegmentSequence::EnvelopeSegmentSequence(const EnvelopeSegmentSequence&
 {
     _currSegment = _segments.begin() + _currSegmentNum;
     
-    std::vector<EnvelopeSegment>::const_iterator itr = other._loopStart;
+    segmentVec::const_iterator itr = other._loopStart;
     
     _loopStart = _segments.begin() + std::distance(other._segments.begin(), itr);
     
@@ -226,7 +406,7 @@ EnvelopeSegmentSequence& EnvelopeSegmentSequence::operator= (const EnvelopeSegme
         
         _currSegment = _segments.begin() + _currSegmentNum;
         
-        std::vector<EnvelopeSegment>::const_iterator itr = other._loopStart;
+        segmentVec::const_iterator itr = other._loopStart;
         
         _loopStart = _segments.begin() + std::distance(other._segments.begin(), itr);
         
@@ -247,7 +427,11 @@ void EnvelopeSegmentSequence::reset()
         itr->reset();
     }
     
-    _changeSegment(_segments.begin());
+    _currSegment = _segments.begin();
+    
+    _changeSegment(_currSegment);
+    
+    _loopCount = 0;
 }
 
 void EnvelopeSegmentSequence::setSegmentRate(segment_t segment, double rate)
@@ -386,7 +570,17 @@ void EnvelopeSegmentSequence::update()
     _currSegment->update();
 }
 
-double EnvelopeSegmentSequence::tick()
+void EnvelopeSegmentSequence::advance(unsigned long samples)
+{
+    for ( ; samples; --samples)
+    {
+        _checkSegment();
+        
+        update();
+    }
+}
+
+void EnvelopeSegmentSequence::_checkSegment()
 {
     if (_currSample >= _currSegment->getLength())
     {
@@ -404,7 +598,12 @@ double EnvelopeSegmentSequence::tick()
         // else change
         else _changeSegment(_currSegment);
     }
+}
 
+double EnvelopeSegmentSequence::tick()
+{
+    _checkSegment();
+    
     return _currSegment->tick();
 }
 
@@ -533,7 +732,7 @@ ModEnvelopeSegmentSequenceFlexible::ModEnvelopeSegmentSequenceFlexible(segment_t
 
 void ModEnvelopeSegmentSequenceFlexible::setSegmentLength(segment_t segment, unsigned long ms)
 {
-    _segments[segment].setLength(ms * (Global::samplerate/1000.0));
+    _segments[segment].setLength(ms * (_context->getSamplerate()/1000.0));
 }
 
 unsigned long ModEnvelopeSegmentSequenceFlexible::getSegmentLength(segment_t segment) const
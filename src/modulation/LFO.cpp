@@ -14,7 +14,11 @@
 #include "Oscillator.hpp"
 #include "ModDock.hpp"
 #include "Global.hpp"
+#include "Util.hpp"
+#include "FastMath.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 LFO::LFO(short wt, double freq, double amp, double phaseOffset)
@@ -112,8 +116,17 @@ double LFO::modulate(double sample, double depth, double maximum)
     return sample + (maximum * Oscillator::tick() * depth * _amp);
 }
 
+const unsigned short LFOSequence::_bakePoints = 256;
+
+// Radical curves are too steep to interpolate over the first steps
+const double LFOSequence::_bakeExact = 4.0 / LFOSequence::_bakePoints;
+
+const unsigned short LFOSequence::_bakeChunk = 32;
+
 LFOSequence::LFOSequence(unsigned short seqLength, double rate)
-: ModEnvelopeSegmentSequence(seqLength,1), _lfos(seqLength)
+: ModEnvelopeSegmentSequence(seqLength,1), _lfos(seqLength),
+  _isBaked(false), _bakeDirty(true), _bakeable(false),
+  _bakeNext(0), _bakedSamples(0)
 {
     setLoopStart(0);
     setLoopEnd(seqLength - 1);
@@ -137,6 +150,8 @@ LFOSequence::LFOSequence(unsigned short seqLength, double rate)
     _mods[RATE].setHigherBoundary(10);
     _mods[RATE].setLowerBoundary(0);
     _mods[RATE].setBaseValue(rate);
+    
+    _resizeBaked();
 }
 
 double LFOSequence::getScaledModFreqValue(double freq) const
@@ -151,7 +166,7 @@ double LFOSequence::getScaledModFreqValue(double freq) const
     // To go from samples to Hertz, simply
     // divide the samplerate by the length
     // in samples e.g. 44100 / 22050 = 2 Hz
-    double temp = Global::samplerate / static_cast<double>(_segLen);
+    double temp = _context->getSamplerate() / static_cast<double>(_segLen);
     
     // Multiply by wanted frequency
     return freq * temp;
@@ -159,14 +174,18 @@ double LFOSequence::getScaledModFreqValue(double freq) const
 
 void LFOSequence::_setScaledModFreq(segment_t seg)
 {
+    _unbake();
+    
     // Set scaled frequency to frequency of lfo
     _lfos[seg].lfo.setFrequency(getScaledModFreqValue(_lfos[seg].freq));
 }
 
 void LFOSequence::_resizeSegmentsFromRate(double rate)
 {
+    _unbake();
+    
     // get the period, divide up into _segNum pieces
-    _segLen = (Global::samplerate / rate) / _segments.size();
+    _segLen = (_context->getSamplerate() / rate) / _segments.size();
     
     // Set all segments' lengths
     for (int i = 0; i < _segments.size(); i++)
@@ -228,18 +247,71 @@ void LFOSequence::setSegmentRate(segment_t seg, double rate)
     if (seg >= _segments.size())
     { throw std::invalid_argument("Segment out of range for LFOSequence!"); }
     
+    _unbake();
+    
     _segments[seg].setRate(rate);
 }
 
+void LFOSequence::setSegmentStartLevel(segment_t seg, double lv)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setSegmentStartLevel(seg, lv);
+}
+
+void LFOSequence::setSegmentEndLevel(segment_t seg, double lv)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setSegmentEndLevel(seg, lv);
+}
+
+void LFOSequence::setLinkedLevel(segment_t seg, double lv)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setLinkedLevel(seg, lv);
+}
+
+void LFOSequence::setLoopStart(segment_t seg)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setLoopStart(seg);
+}
+
+void LFOSequence::setLoopEnd(segment_t seg)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setLoopEnd(seg);
+}
+
+void LFOSequence::setLoopMax(unsigned short n)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setLoopMax(n);
+}
+
+void LFOSequence::setLoopInf(bool state)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setLoopInf(state);
+}
+
 void LFOSequence::setModWavetable(segment_t seg, unsigned short wt)
 {
     if (seg >= _segments.size())
     { throw std::invalid_argument("Segment out of range for LFOSequence!"); }
     
+    _unbake();
+    
     _lfos[seg].lfo.setWavetable(wt);
 }
 
-std::shared_ptr<Wavetable> LFOSequence::getModWavetable(segment_t seg) const
+std::shared_ptr<const Wavetable> LFOSequence::getModWavetable(segment_t seg) const
 {
     if (seg >= _segments.size())
     { throw std::invalid_argument("Segment out of range for LFOSequence!"); }
@@ -252,6 +324,8 @@ void LFOSequence::setModDepth(segment_t seg, double depth)
     if (seg >= _segments.size())
     { throw std::invalid_argument("Segment out of range for LFOSequence!"); }
     
+    _unbake();
+    
     _segments[seg].setModUnitDepth(EnvelopeSegment::START_LEVEL, 0, depth);
     _segments[seg].setModUnitDepth(EnvelopeSegment::END_LEVEL, 0, depth);
 }
@@ -288,6 +362,8 @@ void LFOSequence::setModPhaseOffset(segment_t seg, double degrees)
     if (seg >= _segments.size())
     { throw std::invalid_argument("Segment out of range for LFOSequence!"); }
     
+    _unbake();
+    
     _lfos[seg].lfo.setPhaseOffset(degrees);
 }
 
@@ -332,6 +408,8 @@ void LFOSequence::insertSegment(segment_t pos, const EnvelopeSegment& seg)
     _resizeSegmentsFromRate(_rate);
     
     _lfos.insert(_lfos.begin() + pos, LFOSequence_LFO());
+    
+    _resizeBaked();
 }
 
 void LFOSequence::insertSegment(segment_t pos)
@@ -353,6 +431,8 @@ void LFOSequence::addSegment()
         _resizeSegmentsFromRate(_rate);
         
         _lfos.push_back(LFOSequence_LFO());
+        
+        _resizeBaked();
     }
 }
 
@@ -393,6 +473,8 @@ void LFOSequence::removeSegment(segment_t seg)
     _resizeSegmentsFromRate(_rate);
     
     _lfos.erase(_lfos.begin() + seg);
+    
+    _resizeBaked();
 }
 
 void LFOSequence::setModUnitDepth_Segment(segment_t segNum,
@@ -403,6 +485,8 @@ void LFOSequence::setModUnitDepth_Segment(segment_t segNum,
     if (segNum >= _segments.size())
     { throw std::invalid_argument("Segment index out of range!"); }
     
+    _unbake();
+    
     if (dockNum == MOD_DEPTH)
     {
         // The depth ModDock is not part of the LFO but of the segment
@@ -440,6 +524,8 @@ void LFOSequence::attachMod_Segment(segment_t segNum,
     if (segNum >= _segments.size())
     { throw std::invalid_argument("Segment index out of range!"); }
     
+    _unbake();
+    
     if (dockNum == MOD_DEPTH)
     {
         // Attach the depth ModUnit to the EnvelopeSegment's dock
@@ -460,6 +546,8 @@ void LFOSequence::detachMod_Segment(segment_t segNum,
     if (segNum >= _segments.size())
     { throw std::invalid_argument("Segment index out of range!"); }
     
+    _unbake();
+    
     if (dockNum == MOD_DEPTH)
     {
         _segments[segNum].detachMod(EnvelopeSegment::END_LEVEL, modNum);
@@ -473,6 +561,8 @@ void LFOSequence::setSidechain_Segment(segment_t segNum, index_t dockNum, index_
     if (segNum >= _segments.size())
     { throw std::invalid_argument("Segment index out of range!"); }
     
+    _unbake();
+    
     if (dockNum == MOD_DEPTH)
     {
         // Unsidechain the master from the internal LFO
@@ -491,6 +581,8 @@ void LFOSequence::unSidechain_Segment(segment_t segNum, index_t dockNum, index_t
     if (segNum >= _segments.size())
     { throw std::invalid_argument("Segment index out of range!"); }
     
+    _unbake();
+    
     if (dockNum == MOD_DEPTH)
     {
         // Unsidechain the master and slave
@@ -557,11 +649,175 @@ unsigned long LFOSequence::dockSize_Segment(segment_t segNum, index_t dockNum) c
     else return _lfos[segNum].lfo.dockSize(dockNum);
 }
 
+void LFOSequence::reset()
+{
+    // The baked table is relative to the current position
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::reset();
+}
+
+void LFOSequence::setSegmentModDockBaseValue(segment_t segNum, index_t dockNum, double value)
+{
+    _unbake();
+    
+    ModEnvelopeSegmentSequence::setSegmentModDockBaseValue(segNum, dockNum, value);
+}
+
+bool LFOSequence::isBaked() const
+{
+    return _isBaked;
+}
+
+bool LFOSequence::_isBakeable() const
+{
+    // The sequence's rate must be constant and it
+    // must loop over all segments forever
+    if (_mods[RATE].inUse() || ! _segLen) return false;
+    
+    if (_loopStart != _segments.begin() || _loopEnd != _segments.end() || ! _loopInf)
+    { return false; }
+    
+    for (segment_t seg = 0; seg < _segments.size(); ++seg)
+    {
+        const EnvelopeSegment& segment = _segments[seg];
+        
+        // Only the segment's own LFO may modulate it
+        if (segment.dockInUse(EnvelopeSegment::RATE)                 ||
+            segment.dockSize(EnvelopeSegment::START_LEVEL) != 1     ||
+            segment.dockSize(EnvelopeSegment::END_LEVEL) != 1)
+        { return false; }
+        
+        const LFO& lfo = _lfos[seg].lfo;
+        
+        if (lfo.dockInUse(LFO::FREQ) || lfo.dockInUse(LFO::PHASE) || lfo.dockInUse(LFO::AMP))
+        { return false; }
+        
+        // The LFO must be back at the same phase after a whole cycle
+        const double cycles = _lfos[seg].freq * _segments.size();
+        
+        if (std::fabs(cycles - std::floor(cycles + 0.5)) > 1e-9) return false;
+    }
+    
+    return true;
+}
+
+void LFOSequence::_unbake()
+{
+    // Bring the segments' LFOs up to date before
+    // anything changes how they are updated
+    if (_bakedSamples)
+    {
+        for (lfoVec::iterator itr = _lfos.begin(), end = _lfos.end();
+             itr != end;
+             ++itr)
+        {
+            itr->lfo.advance(_bakedSamples);
+        }
+        
+        _bakedSamples = 0;
+    }
+    
+    _isBaked = false;
+    
+    _bakeDirty = true;
+}
+
+void LFOSequence::_resizeBaked()
+{
+    _unbake();
+    
+    _baked.resize(_segments.size() * (_bakePoints + 1));
+}
+
+void LFOSequence::_bake()
+{
+    if (_bakeDirty)
+    {
+        _bakeDirty = false;
+        
+        _bakeNext = 0;
+        
+        // Never allocate here, segments are only added
+        // or removed together with resizing the table
+        _bakeable = _isBakeable() && _baked.size() == _segments.size() * (_bakePoints + 1);
+    }
+    
+    if (! _bakeable) return;
+    
+    const unsigned long end = std::min<unsigned long>(_bakeNext + _bakeChunk, _baked.size());
+    
+    // The LFOs are at this position in the cycle, since they are
+    // updated as usual while baking, it is re-read every call
+    const double now = static_cast<double>(_currSegmentNum) * _segLen + _currSample;
+    
+    for (; _bakeNext < end; ++_bakeNext)
+    {
+        const segment_t seg = _bakeNext / (_bakePoints + 1);
+        
+        const double position = static_cast<double>(_bakeNext % (_bakePoints + 1)) / _bakePoints;
+        
+        _baked[_bakeNext] = _evaluate(seg, position, _segLen * (seg + position) - now);
+    }
+    
+    _isBaked = (_bakeNext == _baked.size());
+}
+
+double LFOSequence::_evaluate(segment_t seg, double position, double offset) const
+{
+    const EnvelopeSegment& segment = _segments[seg];
+    
+    const LFO& lfo = _lfos[seg].lfo;
+    
+    const double modulation = lfo.peek(offset) * lfo.getAmp();
+    
+    // What the levels' ModDocks would return
+    const double start = segment.getStartLevel() + modulation * segment.getModUnitDepth(EnvelopeSegment::START_LEVEL, 0);
+    
+    const double end = segment.getEndLevel() + modulation * segment.getModUnitDepth(EnvelopeSegment::END_LEVEL, 0);
+    
+    const double startLevel = std::max(0.0, std::min(1.0, start));
+    
+    const double endLevel = std::max(0.0, std::min(1.0, end));
+    
+    return (endLevel - startLevel) * Util::flushDenormal(FastMath::pow(position, segment.getRate())) + startLevel;
+}
+
+double LFOSequence::_replay()
+{
+    // Change segments (and reset loops) as usual, once per segment
+    if (_currSample >= _currSegment->getLength()) EnvelopeSegmentSequence::tick();
+    
+    const double position = static_cast<double>(_currSample) / _segLen;
+    
+    // The LFO is behind by the samples it was not updated for
+    if (position < _bakeExact && _currSegment->getRate() < 1)
+    {
+        return _evaluate(_currSegmentNum, position, _bakedSamples);
+    }
+    
+    const double index = position * _bakePoints;
+    
+    const unsigned long integral = static_cast<unsigned long>(index);
+    
+    const double* values = &_baked[_currSegmentNum * (_bakePoints + 1) + integral];
+    
+    return values[0] + (values[1] - values[0]) * (index - integral);
+}
+
 void LFOSequence::update()
 {
     ModEnvelopeSegmentSequence::update();
     
-    for (std::vector<LFOSequence_LFO>::iterator itr = _lfos.begin(), end = _lfos.end();
+    // The LFOs are caught up with in _unbake()
+    if (isBaked())
+    {
+        ++_bakedSamples;
+        
+        return;
+    }
+    
+    for (lfoVec::iterator itr = _lfos.begin(), end = _lfos.end();
          itr != end;
          ++itr)
     {
@@ -583,27 +839,39 @@ double LFOSequence::modulate(double sample, double depth, double)
         _amp =  _mods[AMP].tick();
     }
     
-    return sample * tick() * depth * _amp;
+    if (! _isBaked) _bake();
+    
+    const double value = (_isBaked) ? _replay() : tick();
+    
+    return sample * value * depth * _amp;
 }
 
+const unsigned short LFOUnit::maxControlRate = 256;
+
 LFOUnit::LFOUnit(Mode mode)
-: ModUnit(1), _fader(new Crossfader)
+: ModUnit(1), _fader(Arena::make<Crossfader>()),
+  _block(32), _gain(0), _syncTempo(0)
 {
     _mods[AMP].setHigherBoundary(1);
     _mods[AMP].setLowerBoundary(0);
     _mods[AMP].setBaseValue(1);
     
+    _syncBeats[A] = _syncBeats[B] = 0;
+    
     setMode(mode);
 }
 
 LFOUnit::LFOUnit(const LFOUnit& other)
 : ModUnit(other),
-  _fader(new Crossfader(*other._fader))
+  _fader(Arena::make<Crossfader>(*other._fader)),
+  _block(other._block.size()), _gain(0), _syncTempo(0)
 {
     for (unsigned short i = 0; i < 2; ++i)
     {
         _lfoSequences[i] = other._lfoSequences[i];
         _lfos[i] = other._lfos[i];
+        
+        _syncBeats[i] = other._syncBeats[i];
     }
     
     setMode(other._mode);
@@ -621,8 +889,14 @@ LFOUnit& LFOUnit::operator= (const LFOUnit& other)
         {
             _lfoSequences[i] = other._lfoSequences[i];
             _lfos[i] = other._lfos[i];
+            
+            _syncBeats[i] = other._syncBeats[i];
         }
         
+        _block.resize(other._block.size());
+        
+        _syncTempo = 0;
+        
         setMode(other._mode);
     }
     
@@ -669,6 +943,11 @@ void LFOUnit::setMode(Mode mode)
 {
     _mode = mode;
     
+    // Start over from the new units' current value
+    _primed = false;
+    
+    _position = _block.size();
+    
     switch(mode)
     {
         case Mode::SEQ:
@@ -696,27 +975,134 @@ LFOUnit::Mode LFOUnit::getMode() const
     return _mode;
 }
 
-void LFOUnit::update()
+void LFOUnit::setControlRate(unsigned short samples)
+{
+    if (! samples || samples > maxControlRate)
+    { throw std::invalid_argument("Control rate must be between 1 and LFOUnit::maxControlRate!"); }
+    
+    _block.resize(samples);
+    
+    _position = samples;
+}
+
+unsigned short LFOUnit::getControlRate() const
+{
+    return _block.size();
+}
+
+void LFOUnit::setSyncBeats(bool unit, double beats)
+{
+    if (beats < 0)
+    { throw std::invalid_argument("Beats cannot be less than zero!"); }
+    
+    _syncBeats[unit] = beats;
+    
+    // Apply on the next control period
+    _syncTempo = 0;
+}
+
+double LFOUnit::getSyncBeats(bool unit) const
+{
+    return _syncBeats[unit];
+}
+
+void LFOUnit::_sync()
 {
+    _syncTempo = _context->getTempo();
+    
+    for (unsigned short i = 0; i < 2; ++i)
+    {
+        if (! _syncBeats[i]) continue;
+        
+        const double Hz = _context->getTempo() / (60 * _syncBeats[i]);
+        
+        _lfos[i].setFrequency(std::min(Hz, 100.0));
+        
+        _lfoSequences[i].setRate(std::min(Hz, 10.0));
+    }
+}
+
+double LFOUnit::_evaluate()
+{
+    ModUnit* left = (_mode == Mode::LFO) ? static_cast<ModUnit*>(&_lfos[A]) : &_lfoSequences[A];
+    
+    ModUnit* right = (_mode == Mode::LFO) ? static_cast<ModUnit*>(&_lfos[B]) : &_lfoSequences[B];
+    
+    // LFOs add their value to the sample they modulate while
+    // LFOSequences multiply it, so pass 0 or 1 to get the value
+    const double sample = (_mode == Mode::LFO) ? 0 : 1;
+    
+    double value = 0;
+    
+    // Units the crossfader is turned away from are not evaluated
+    if (_fader->left())
+    {
+        value += left->modulate(sample, 1, 1) * _fader->left();
+    }
+    
+    if (_fader->right())
+    {
+        value += right->modulate(sample, 1, 1) * _fader->right();
+    }
+    
+    _gain = (_fader->left() + _fader->right()) * _fader->getAmp();
+    
+    return value * _fader->getAmp();
+}
+
+void LFOUnit::_render()
+{
+    const unsigned short period = _block.size();
+    
+    if (_syncTempo != _context->getTempo()) _sync();
+    
+    // Once per control period, like the units themselves
+    _fader->modulateValue();
+    
+    if (! _primed)
+    {
+        _last = _evaluate();
+        
+        _primed = true;
+    }
+    
+    // Advance the units to the end of the period
     switch(_mode)
     {
         case Mode::SEQ:
         {
-            _lfoSequences[0].update();
-            _lfoSequences[1].update();
+            _lfoSequences[A].advance(period);
+            _lfoSequences[B].advance(period);
             
             break;
         }
             
         case Mode::LFO:
         {
-            _lfos[0].update();
-            _lfos[1].update();
+            _lfos[A].advance(period);
+            _lfos[B].advance(period);
             
             break;
         }
     }
     
+    const double next = _evaluate();
+    
+    const double step = (next - _last) / period;
+    
+    for (unsigned short n = 0; n < period; ++n)
+    {
+        _block[n] = _last + step * n;
+    }
+    
+    _last = next;
+    
+    _position = 0;
+}
+
+void LFOUnit::update()
+{
+    if (++_position >= _block.size()) _render();
 }
 
 double LFOUnit::modulate(double sample, double depth, double maximum)
@@ -728,7 +1114,15 @@ double LFOUnit::modulate(double sample, double depth, double maximum)
     
     if (! _active) return sample;
     
-    // Tick the crossfaded value from the lfos and multiply by the envelope
-    // value and the total amplitude value
-    return _fader->modulate(sample, depth, maximum) * _amp;
+    // Only before the first update
+    if (_position >= _block.size()) _render();
+    
+    // The crossfaded value from the lfos multiplied
+    // by the envelope value and the total amplitude value
+    if (_mode == Mode::LFO)
+    {
+        return (sample * _gain + maximum * depth * _block[_position]) * _amp;
+    }
+    
+    else return sample * depth * _block[_position] * _amp;
 }
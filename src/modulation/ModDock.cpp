@@ -13,8 +13,19 @@
 
 #include <stdexcept>
 
+const std::size_t ModDock::_reserved = 4;
+
 ModDock::ModDock()
-{ }
+{
+    // Inside an Arena, reserve space for a few ModUnits there so
+    // that attaching them later doesn't allocate from the heap
+    if (Arena::current())
+    {
+        _nonMasterItems.reserve(_reserved);
+        _masterItems.reserve(_reserved);
+        _modItems.reserve(_reserved);
+    }
+}
 
 ModDock::ModDock(double lowerBoundary,
                  double higherBoundary,
@@ -246,7 +257,7 @@ void ModDock::setDepth(index_t index, double depth)
     _modItems[index].depth = _modItems[index].baseDepth = depth;
 }
 
-double ModDock::getDepth(index_t index)
+double ModDock::getDepth(index_t index) const
 {
     if (index >= _modItems.size())
     { throw std::out_of_range("ModDock index out of bounds!"); }
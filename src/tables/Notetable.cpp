@@ -9,13 +9,14 @@
 ************************************************************************************************/
 
 #include "Notetable.hpp"
+#include "Global.hpp"
 
 #include <fstream>
 
 Notetable::Notetable()
 : LookupTable<double>(128, "Notes")
 {
-    std::ifstream file("/Users/petergoldsborough/Documents/Anthem/rsc/notes.table");
+    std::ifstream file(ANTHEM_RESOURCE_PATH "notes.table");
     
     // 128 MIDI notes. Number hasn't changed in the
     // last 30 years, probably wont't too soon.
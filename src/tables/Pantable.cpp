@@ -10,6 +10,7 @@
 
 #include "Pantable.hpp"
 #include "Parsley.hpp"
+#include "Global.hpp"
 
 #include <string>
 #include <fstream>
@@ -17,7 +18,7 @@
 PantableDatabase::PantableDatabase()
 {
     // The pantable configuration file
-    TextParsley textParser("/Users/petergoldsborough/Documents/Anthem/rsc/pantables/pantables.md");
+    TextParsley textParser(ANTHEM_RESOURCE_PATH "pantables/pantables.md");
     
     std::vector<std::string> config = textParser.getAllWords();
     
@@ -31,7 +32,7 @@ PantableDatabase::PantableDatabase()
     
     for (auto& name : config)
     {
-        file.open("/Users/petergoldsborough/Documents/Anthem/rsc/pantables/" + name + ".table");
+        file.open(ANTHEM_RESOURCE_PATH "pantables/" + name + ".table");
         
         if (! file)
         { throw FileOpenError("Error opening Pantable!"); }
@@ -10,9 +10,13 @@
 
 #include "Wavetable.hpp"
 #include "Parsley.hpp"
+#include "Global.hpp"
 
 #include <fstream>
 #include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 Wavetable::Wavetable(double* data,
                      index_t length,
@@ -277,28 +281,125 @@ void Wavetable::_mathematicalTriangle()
     _data.push_back(_data.front());
 }
 
+const WavetableDatabase::index_t WavetableDatabase::maxReaders;
+
+WavetableDatabase::WavetableDatabase()
+: _epoch(1)
+{
+    for (index_t i = 0; i < maxReaders; ++i)
+    {
+        _readers[i].store(0);
+    }
+}
+
 void WavetableDatabase::init()
 {
     // The wavetable configuration file
-    TextParsley textParser("/Users/petergoldsborough/Documents/Anthem/rsc/wavetables/wavetables.md");
+    TextParsley textParser(ANTHEM_RESOURCE_PATH "wavetables/wavetables.md");
     
     std::string fname;
     
     auto names = textParser.getAllWords();
     
+    std::lock_guard<std::mutex> lock(_mutex);
+    
     _tables.resize(names.size());
     
+    _current.reset(new std::atomic<const Wavetable*> [names.size()]);
+    
     // Fetch all wavetable names and read their respective data files
     for (index_t i = 0; i < names.size(); ++i)
     {
         // Read wavetables with i as their id and push them into the _tables vector.
-        _tables[i] = std::make_shared<Wavetable>(_readWavetable(names[i]), Global::wavetableLength, names[i]);
+        _tables[i] = std::make_shared<Wavetable>(_readWavetable(names[i]), Global::wavetableLength + 1, names[i]);
+        
+        _current[i].store(_tables[i].get());
+    }
+}
+
+WavetableDatabase::ReadGuard::ReadGuard(WavetableDatabase& database)
+: _database(database)
+{
+    // A replace() after this load retires tables in this epoch or
+    // later, so they are kept for as long as the slot holds it
+    const unsigned long epoch = _database._epoch.load();
+    
+    // Must be visible before any table is read. If collect() does
+    // not see the slot yet, no table it frees can be read anymore
+    for (_slot = 0; _slot < maxReaders; ++_slot)
+    {
+        unsigned long free = 0;
+        
+        if (_database._readers[_slot].compare_exchange_strong(free, epoch)) return;
+    }
+    
+    throw std::runtime_error("Too many wavetable readers!");
+}
+
+WavetableDatabase::ReadGuard::~ReadGuard()
+{
+    _database._readers[_slot].store(0);
+}
+
+void WavetableDatabase::replace(index_t wavetable, std::shared_ptr<const Wavetable> table)
+{
+    if (! table)
+    { throw std::invalid_argument("Wavetable cannot be null!"); }
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        if (wavetable >= _tables.size())
+        { throw std::out_of_range("Wavetable id out of range!"); }
+        
+        _current[wavetable].store(table.get());
+        
+        // Readers created in this epoch or before may still be
+        // using the old table, readers created later cannot
+        const unsigned long epoch = _epoch.fetch_add(1);
+        
+        _retired.push_back(retired_t(epoch, _tables[wavetable]));
+        
+        _tables[wavetable] = table;
+    }
+    
+    collect();
+}
+
+void WavetableDatabase::collect()
+{
+    std::vector<retired_t> freed;
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        // The epoch the oldest live reader was created in, readers
+        // created from now on only see the current tables
+        unsigned long oldest = std::numeric_limits<unsigned long>::max();
+        
+        for (index_t i = 0; i < maxReaders; ++i)
+        {
+            const unsigned long epoch = _readers[i].load();
+            
+            if (epoch && epoch < oldest) oldest = epoch;
+        }
+        
+        std::vector<retired_t>::iterator end =
+        std::partition(_retired.begin(), _retired.end(),
+                       [&] (const retired_t& retired)
+                       { return retired.first >= oldest; });
+        
+        freed.assign(end, _retired.end());
+        
+        _retired.erase(end, _retired.end());
     }
+    
+    // Tables are destroyed here, outside the lock
 }
 
 double* WavetableDatabase::_readWavetable(const std::string &name) const
 {
-    std::ifstream file("../../../rsc/wavetables/" + name + ".wavetable");
+    std::ifstream file(ANTHEM_RESOURCE_PATH "wavetables/" + name + ".wavetable");
     
     if (! file.good())
     {
@@ -329,7 +430,7 @@ void WavetableDatabase::writeWavetable(const std::string &name,
                                        const Wavetable& wavetable,
                                        bool addToDefaults) const
 {
-    std::ofstream file("../../../rsc/wavetables/" + name + ".wavetable", std::ios::binary);
+    std::ofstream file(ANTHEM_RESOURCE_PATH "wavetables/" + name + ".wavetable", std::ios::binary);
     
     if (! file.good())
     {
@@ -349,7 +450,7 @@ void WavetableDatabase::writeWavetable(const std::string &name,
     {
         file.close();
         
-        file.open("../../../rsc/wavetables/wavetables.md", std::ios::app);
+        file.open(ANTHEM_RESOURCE_PATH "wavetables/wavetables.md", std::ios::app);
         
         if (! file.good())
         {
@@ -370,12 +471,9 @@ WavetableDatabase::index_t WavetableDatabase::size() const
     return _tables.size();
 }
 
-std::shared_ptr<Wavetable>& WavetableDatabase::operator[](index_t wavetable)
-{
-    return _tables[wavetable];
-}
-
-const std::shared_ptr<Wavetable>& WavetableDatabase::operator[](index_t wavetable) const
+std::shared_ptr<const Wavetable> WavetableDatabase::operator[](index_t wavetable) const
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+    
     return _tables[wavetable];
 }
@@ -0,0 +1,142 @@
+/********************************************************************************************//*!
+*
+*  @file        ConvolutionReverbTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks ConvolutionReverb against direct convolution and while its IR is replaced.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "ConvolutionReverb.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    std::vector<double> noise(std::size_t size)
+    {
+        std::vector<double> samples(size);
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            samples[n] = (std::rand() / static_cast<double>(RAND_MAX)) * 2 - 1;
+        }
+        
+        return samples;
+    }
+    
+    /*! The wet signal must be the direct convolution with the normalized IR, one partition late */
+    void testConvolution()
+    {
+        ConvolutionReverb reverb(64, 1);
+        
+        reverb.setActive(true);
+        
+        const std::vector<double> ir = noise(300);
+        
+        reverb.setImpulseResponse(ir);
+        
+        check(reverb.getTailLength() == 6 * 64, "the tail is the IR plus the latency");
+        
+        double energy = 0;
+        
+        for (std::size_t n = 0; n < ir.size(); ++n) energy += ir[n] * ir[n];
+        
+        const std::vector<double> input = noise(2000);
+        
+        std::vector<double> output(input);
+        
+        // Uneven sizes, so that blocks end everywhere in the partitions
+        const std::size_t sizes [] = { 37, 64, 5, 1, 50 };
+        
+        for (std::size_t n = 0, block = 0; n < output.size(); ++block)
+        {
+            const std::size_t size = std::min(sizes[block % 5], output.size() - n);
+            
+            reverb.processBlock(&output[n], size);
+            
+            n += size;
+        }
+        
+        double maximum = 0;
+        
+        for (std::size_t n = 64; n < output.size(); ++n)
+        {
+            double expected = 0;
+            
+            for (std::size_t k = 0; k < ir.size() && k <= n - 64; ++k)
+            {
+                expected += ir[k] * input[n - 64 - k];
+            }
+            
+            expected /= std::sqrt(energy);
+            
+            maximum = std::max(maximum, std::fabs(output[n] - expected));
+        }
+        
+        check(maximum < 1e-9, "the output matches direct convolution");
+        
+        reverb.clearImpulseResponse();
+        
+        double sample = 0.5;
+        
+        reverb.processBlock(&sample, 1);
+        
+        check(sample == 0.5 && ! reverb.hasImpulseResponse(), "signals pass through without an IR");
+    }
+    
+    /*! Replaces the IR while another thread processes, run with -fsanitize=thread or address */
+    void testConcurrentReplace()
+    {
+        ConvolutionReverb reverb(64, 0.5);
+        
+        reverb.setActive(true);
+        
+        std::atomic<bool> done(false);
+        
+        std::thread audio([&] ()
+        {
+            std::vector<double> block = noise(100);
+            
+            while (! done.load()) reverb.processBlock(&block[0], block.size());
+        });
+        
+        for (unsigned short i = 0; i < 200; ++i)
+        {
+            if (i % 10) reverb.setImpulseResponse(noise(64 + i * 7));
+            
+            else reverb.clearImpulseResponse();
+        }
+        
+        done.store(true);
+        
+        audio.join();
+        
+        check(reverb.hasImpulseResponse(), "the last IR is set");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testConvolution();
+    
+    testConcurrentReplace();
+    
+    return Test::finish();
+}
@@ -0,0 +1,141 @@
+/********************************************************************************************//*!
+*
+*  @file        DenormalBenchmark.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Times decaying effect tails with and without a DenormalGuard.
+*
+*  @details     Excites each effect with a short burst of noise and then renders silence until
+*               long after the tail has decayed below the smallest normal double, timing every
+*               block. Prints the mean and worst time per block for both modes. The unflushed
+*               one-pole is not part of Anthem, it shows what a tail costs on this CPU when
+*               neither the guard nor the explicit flushing catches its denormals. Build it like
+*               the tests, see Test.hpp, but with optimizations.
+*
+************************************************************************************************/
+
+#include "Delay.hpp"
+#include "Reverb.hpp"
+#include "Filter.hpp"
+#include "Denormals.hpp"
+#include "Global.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock steady_t;
+    
+    /*! The number of samples rendered per block, as in a typical audio callback */
+    const std::size_t blockSize = 256;
+    
+    /*! The number of blocks rendered after the burst, about 13 seconds at 48 kHz */
+    const std::size_t blocks = 2500;
+    
+    /*! A one-pole feedback loop that never flushes its state */
+    struct OnePole
+    {
+        OnePole() : state(0) { }
+        
+        void processBlock(double* block, std::size_t size)
+        {
+            for (std::size_t n = 0; n < size; ++n)
+            {
+                state = block[n] + 0.99 * state;
+                
+                block[n] = state;
+            }
+        }
+        
+        double state;
+    };
+    
+    struct Timing
+    {
+        double mean;
+        
+        double worst;
+    };
+    
+    /*! Renders the tail of a copy of the prototype and returns the time per block in microseconds */
+    template <typename Unit>
+    Timing render(const Unit& prototype)
+    {
+        Unit unit(prototype);
+        
+        std::vector<double> block(blockSize);
+        
+        for (std::size_t n = 0; n < blockSize; ++n)
+        {
+            block[n] = (std::rand() / static_cast<double>(RAND_MAX)) * 2 - 1;
+        }
+        
+        unit.processBlock(&block[0], blockSize);
+        
+        Timing timing = { 0, 0 };
+        
+        for (std::size_t i = 0; i < blocks; ++i)
+        {
+            std::fill(block.begin(), block.end(), 0);
+            
+            const steady_t::time_point start = steady_t::now();
+            
+            unit.processBlock(&block[0], blockSize);
+            
+            const double time = std::chrono::duration<double, std::micro>(steady_t::now() - start).count();
+            
+            timing.mean += time / blocks;
+            
+            timing.worst = std::max(timing.worst, time);
+        }
+        
+        return timing;
+    }
+    
+    template <typename Unit>
+    void measure(const Unit& prototype, const std::string& name)
+    {
+        const Timing unguarded = render(prototype);
+        
+        Timing guarded;
+        
+        {
+            DenormalGuard guard;
+            
+            guarded = render(prototype);
+        }
+        
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << unguarded.mean << std::setw(12) << unguarded.worst
+                  << std::setw(12) << guarded.mean << std::setw(12) << guarded.worst << std::endl;
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    std::cout << "Time per block of " << blockSize << " samples in microseconds\n\n"
+              << std::left << std::setw(20) << "" << std::right
+              << std::setw(24) << "without guard" << std::setw(24) << "with guard" << "\n"
+              << std::left << std::setw(20) << "" << std::right
+              << std::setw(12) << "mean" << std::setw(12) << "worst"
+              << std::setw(12) << "mean" << std::setw(12) << "worst" << std::endl;
+    
+    measure(Filter(Filter::LOW_PASS, 1000, 8), "Filter");
+    
+    measure(Delay(0.1, 4, 0.001, 0.5), "Delay");
+    
+    measure(Reverb(4, 0.001, 1), "Reverb");
+    
+    measure(OnePole(), "unflushed one-pole");
+}
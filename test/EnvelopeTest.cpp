@@ -0,0 +1,134 @@
+/********************************************************************************************//*!
+*
+*  @file        EnvelopeTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks Envelope's block rendering against ticking it per sample.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "Envelope.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    using Test::check;
+    
+    void setup(Envelope& envelope)
+    {
+        envelope.setSegmentLength(Envelope::DELAY, 2);
+        
+        envelope.setSegmentLevel(Envelope::ATTACK, 0.9);
+        envelope.setSegmentLength(Envelope::ATTACK, 10);
+        envelope.setSegmentRate(Envelope::ATTACK, 0.6);
+        
+        envelope.setSegmentLevel(Envelope::A, 0.4);
+        envelope.setSegmentLength(Envelope::A, 15);
+        envelope.setSegmentRate(Envelope::A, 1.5);
+        
+        envelope.setSegmentLevel(Envelope::B, 0.7);
+        envelope.setSegmentLength(Envelope::B, 5);
+        
+        envelope.setSegmentLevel(Envelope::C, 0.5);
+        envelope.setSegmentLength(Envelope::C, 8);
+        
+        envelope.setLoopStart(Envelope::A);
+        envelope.setLoopEnd(Envelope::C);
+        envelope.setLoopMax(3);
+        
+        envelope.setSegmentLength(Envelope::RELEASE, 20);
+        envelope.setSegmentRate(Envelope::RELEASE, 0.8);
+    }
+    
+    /*! Runs both envelopes for a number of samples, the first one in blocks */
+    double run(Envelope& rendered, Envelope& ticked, unsigned long samples)
+    {
+        // Uneven sizes, so that blocks end everywhere in the segments
+        const EnvelopeSegment::length_t sizes [] = { 37, 64, 5, 1, 50 };
+        
+        double maximum = 0;
+        
+        for (unsigned long n = 0, block = 0; n < samples; ++block)
+        {
+            EnvelopeSegment::length_t size = sizes[block % 5];
+            
+            if (size > samples - n) size = samples - n;
+            
+            rendered.render(size);
+            
+            for (EnvelopeSegment::length_t i = 0; i < size; ++i, ++n)
+            {
+                const double difference = rendered.modulate(0, 1, 1) - ticked.modulate(0, 1, 1);
+                
+                maximum = std::max(maximum, std::fabs(difference));
+                
+                rendered.update();
+                
+                ticked.update();
+            }
+        }
+        
+        return maximum;
+    }
+    
+    void testNoteOff()
+    {
+        Envelope rendered, ticked;
+        
+        setup(rendered);
+        
+        setup(ticked);
+        
+        check(run(rendered, ticked, 8000) < 1e-9, "rendered levels match the ticked ones");
+        
+        rendered.noteOff();
+        
+        ticked.noteOff();
+        
+        check(run(rendered, ticked, 2000) < 1e-9, "the release matches after a note-off between blocks");
+    }
+    
+    void testReset()
+    {
+        Envelope rendered, ticked;
+        
+        setup(rendered);
+        
+        setup(ticked);
+        
+        run(rendered, ticked, 1000);
+        
+        // In the middle of a block, the rest of it must be dropped
+        rendered.render(Envelope::blockSize);
+        
+        rendered.modulate(0, 1, 1);
+        
+        rendered.update();
+        
+        rendered.reset();
+        
+        ticked.reset();
+        
+        check(run(rendered, ticked, 3000) < 1e-9, "reset() in the middle of a block starts over");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testNoteOff();
+    
+    testReset();
+    
+    return Test::finish();
+}
@@ -0,0 +1,118 @@
+/********************************************************************************************//*!
+*
+*  @file        FMTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks FM synthesis on an OperatorBank against the Operator path.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "FM.hpp"
+#include "Operator.hpp"
+#include "OperatorBank.hpp"
+#include "LFO.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    using Test::check;
+    
+    void setup(Operator* operators, LFO& lfo, unsigned short inactive)
+    {
+        for (unsigned short i = FM::A; i <= FM::D; ++i)
+        {
+            operators[i].setRatio(1 + i * 0.5);
+            
+            operators[i].setNote(57);
+            
+            operators[i].setLevel(0.2 + 0.2 * i);
+            
+            operators[i].setActive(i != inactive);
+        }
+        
+        operators[FM::B].attachMod(Operator::LEVEL, &lfo);
+        
+        operators[FM::D].attachMod(Operator::LEVEL, &lfo);
+    }
+    
+    /*! Renders with both paths, inactive is the Operator to leave off (4 for none) */
+    void testAlgorithm(unsigned short algorithm, unsigned short inactive)
+    {
+        LFO lfo(0, 3);
+        
+        lfo.setActive(true);
+        
+        Operator operators [4];
+        
+        FM fm(&operators[FM::A], &operators[FM::B], &operators[FM::C], &operators[FM::D], algorithm);
+        
+        OperatorBank bank;
+        
+        Operator banked [4];
+        
+        for (unsigned short i = FM::A; i <= FM::D; ++i)
+        {
+            banked[i].bind(bank, bank.slot(i, 0));
+        }
+        
+        FM bankFM(&banked[FM::A], &banked[FM::B], &banked[FM::C], &banked[FM::D], algorithm);
+        
+        setup(operators, lfo, inactive);
+        
+        setup(banked, lfo, inactive);
+        
+        bool equal = true;
+        
+        for (unsigned long n = 0; n < 4800; ++n)
+        {
+            const double expected = fm.tick();
+            
+            for (unsigned short i = FM::A; i <= FM::D; ++i) operators[i].update();
+            
+            for (unsigned short i = FM::A; i <= FM::D; ++i)
+            {
+                if (banked[i].isActive()) banked[i].modulateLevel();
+            }
+            
+            double sample;
+            
+            bankFM.tick(bank, &sample);
+            
+            bank.update();
+            
+            lfo.update();
+            
+            if (sample != expected) equal = false;
+        }
+        
+        std::ostringstream what;
+        
+        what << "algorithm " << algorithm << " with operator " << inactive << " inactive matches";
+        
+        check(equal, what.str());
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    for (unsigned short algorithm = 0; algorithm < 12; ++algorithm)
+    {
+        for (unsigned short inactive = FM::A; inactive <= FM::D + 1; ++inactive)
+        {
+            testAlgorithm(algorithm, inactive);
+        }
+    }
+    
+    return Test::finish();
+}
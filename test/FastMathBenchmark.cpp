@@ -0,0 +1,161 @@
+/********************************************************************************************//*!
+*
+*  @file        FastMathBenchmark.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Times FastMath against libm and checks its block versions.
+*
+*  @details     Prints the time per value of the libm function, the scalar FastMath function
+*               and its block version, together with the largest error against libm over the
+*               documented domain. Returns non-zero if a block version does not return exactly
+*               what the scalar version does. Build it like the tests, see Test.hpp, but with
+*               optimizations.
+*
+************************************************************************************************/
+
+#include "FastMath.hpp"
+#include "Test.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    typedef std::chrono::steady_clock steady_t;
+    
+    /*! The number of values per pass */
+    const std::size_t size = 4096;
+    
+    /*! The number of passes timed per function */
+    const std::size_t passes = 500;
+    
+    /*! Keeps the compiler from dropping the timed loops */
+    volatile double sink;
+    
+    /*! Returns the nanoseconds per value that process takes to fill output from input */
+    template <typename Process>
+    double time(const std::vector<double>& input, std::vector<double>& output, Process process)
+    {
+        const steady_t::time_point start = steady_t::now();
+        
+        for (std::size_t pass = 0; pass < passes; ++pass)
+        {
+            process(&input[0], &output[0]);
+            
+            sink = output[pass % size];
+        }
+        
+        return std::chrono::duration<double, std::nano>(steady_t::now() - start).count() / (passes * size);
+    }
+    
+    /*! Times and checks one function, with values evenly spread over [minimum, maximum] */
+    template <typename Exact, typename Scalar, typename Block>
+    void measure(const std::string& name,
+                 double minimum,
+                 double maximum,
+                 bool relative,
+                 Exact exact,
+                 Scalar scalar,
+                 Block block)
+    {
+        std::vector<double> input(size);
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            input[n] = minimum + (maximum - minimum) * n / (size - 1);
+        }
+        
+        std::vector<double> expected(size), output(size), blocked(size);
+        
+        const double libm = time(input, expected, [&] (const double* in, double* out)
+        {
+            for (std::size_t n = 0; n < size; ++n) out[n] = exact(in[n]);
+        });
+        
+        const double fast = time(input, output, [&] (const double* in, double* out)
+        {
+            for (std::size_t n = 0; n < size; ++n) out[n] = scalar(in[n]);
+        });
+        
+        const double fastBlock = time(input, blocked, block);
+        
+        double error = 0;
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            double difference = std::fabs(output[n] - expected[n]);
+            
+            if (relative) difference /= std::fabs(expected[n]);
+            
+            error = std::max(error, difference);
+        }
+        
+        check(std::equal(output.begin(), output.end(), blocked.begin()),
+              "the block version of " + name + " matches the scalar version");
+        
+        std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << libm << std::setw(10) << fast << std::setw(10) << fastBlock
+                  << std::scientific << std::setprecision(1) << std::setw(12) << error
+                  << (relative ? " relative" : " absolute") << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << "Nanoseconds per value\n\n"
+              << std::left << std::setw(10) << "" << std::right
+              << std::setw(10) << "libm" << std::setw(10) << "scalar" << std::setw(10) << "block"
+              << std::setw(12) << "error" << std::endl;
+    
+    measure("exp2", -30, 30, true,
+            [] (double x) { return std::exp2(x); },
+            [] (double x) { return FastMath::exp2(x); },
+            [] (const double* in, double* out) { FastMath::exp2(in, out, size); });
+    
+    measure("log2", 1e-6, 1e6, false,
+            [] (double x) { return std::log2(x); },
+            [] (double x) { return FastMath::log2(x); },
+            [] (const double* in, double* out) { FastMath::log2(in, out, size); });
+    
+    measure("pow", 1e-3, 10, true,
+            [] (double x) { return std::pow(x, 2.7); },
+            [] (double x) { return FastMath::pow(x, 2.7); },
+            [] (const double* in, double* out) { FastMath::pow(in, 2.7, out, size); });
+    
+    measure("sin", -1e3, 1e3, false,
+            [] (double x) { return std::sin(x); },
+            [] (double x) { return FastMath::sin(x); },
+            [] (const double* in, double* out) { FastMath::sin(in, out, size); });
+    
+    measure("cos", -1e3, 1e3, false,
+            [] (double x) { return std::cos(x); },
+            [] (double x) { return FastMath::cos(x); },
+            [] (const double* in, double* out) { FastMath::cos(in, out, size); });
+    
+    measure("tanh", -5, 5, false,
+            [] (double x) { return std::tanh(x); },
+            [] (double x) { return FastMath::tanh(x); },
+            [] (const double* in, double* out) { FastMath::tanh(in, out, size); });
+    
+    measure("dbToAmp", -120, 24, true,
+            [] (double dB) { return std::pow(10, dB / 20); },
+            [] (double dB) { return FastMath::dbToAmp(dB); },
+            [] (const double* in, double* out) { FastMath::dbToAmp(in, out, size); });
+    
+    measure("ampToDb", 1e-6, 16, false,
+            [] (double amp) { return 20 * std::log10(amp); },
+            [] (double amp) { return FastMath::ampToDb(amp); },
+            [] (const double* in, double* out) { FastMath::ampToDb(in, out, size); });
+    
+    return Test::finish();
+}
@@ -0,0 +1,146 @@
+/********************************************************************************************//*!
+*
+*  @file        LFOSequenceTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks that changes to a baked LFOSequence reach its output.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "LFO.hpp"
+#include "EnvelopeSegment.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    using Test::check;
+    
+    /*! Makes the protected base value setter reachable */
+    struct Sequence : public LFOSequence
+    {
+        using LFOSequence::setSegmentModDockBaseValue;
+    };
+    
+    void setup(Sequence& sequence, bool bakeable)
+    {
+        // Away from the 0-1 clamp, where baking is less exact
+        const double levels [] = { 0.2, 0.8, 0.4, 0.6, 0.5 };
+        
+        for (unsigned short seg = 0; seg < sequence.size(); ++seg)
+        {
+            sequence.setLinkedLevel(seg, levels[seg % 5]);
+            
+            sequence.setSegmentRate(seg, 0.5 + 0.5 * seg);
+            
+            sequence.setModDepth(seg, 0.1);
+        }
+        
+        sequence.setSegmentStartLevel(0, levels[(sequence.size() - 1) % 5]);
+        
+        sequence.setRate(6);
+        
+        // Looping a limited number of times keeps the output
+        // identical for a while but rules out baking
+        if (! bakeable) sequence.setLoopMax(64);
+    }
+    
+    /*! Runs both sequences for a number of samples, returns the maximum difference */
+    double run(Sequence& baked, Sequence& live, unsigned long samples)
+    {
+        double maximum = 0;
+        
+        for (unsigned long n = 0; n < samples; ++n)
+        {
+            maximum = std::max(maximum, std::fabs(baked.modulate(1, 1, 1) - live.modulate(1, 1, 1)));
+            
+            baked.update();
+            
+            live.update();
+        }
+        
+        return maximum;
+    }
+    
+    void testReset()
+    {
+        Sequence baked, live;
+        
+        setup(baked, true);
+        
+        setup(live, false);
+        
+        run(baked, live, 3000);
+        
+        check(baked.isBaked() && ! live.isBaked(), "only the first sequence is baked");
+        
+        baked.reset();
+        
+        live.reset();
+        
+        check(run(baked, live, 24000) < 1e-3, "reset() is followed when baked");
+    }
+    
+    void testBaseValue()
+    {
+        Sequence baked, live;
+        
+        setup(baked, true);
+        
+        setup(live, false);
+        
+        run(baked, live, 3000);
+        
+        baked.setSegmentModDockBaseValue(2, EnvelopeSegment::END_LEVEL, 0.3);
+        
+        live.setSegmentModDockBaseValue(2, EnvelopeSegment::END_LEVEL, 0.3);
+        
+        check(run(baked, live, 24000) < 1e-3, "setSegmentModDockBaseValue() is followed when baked");
+    }
+    
+    void testIncremental()
+    {
+        Sequence baked, live;
+        
+        setup(baked, true);
+        
+        setup(live, false);
+        
+        run(baked, live, 3000);
+        
+        baked.setLinkedLevel(1, 0.7);
+        
+        live.setLinkedLevel(1, 0.7);
+        
+        check(! baked.isBaked(), "a change stops the replay at once");
+        
+        const double difference = run(baked, live, 1);
+        
+        check(! baked.isBaked(), "the table is not baked in a single call");
+        
+        check(std::max(difference, run(baked, live, 24000)) < 1e-3, "the output is live while baking");
+        
+        check(baked.isBaked(), "baking completes over a few calls");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testReset();
+    
+    testBaseValue();
+    
+    testIncremental();
+    
+    return Test::finish();
+}
@@ -0,0 +1,164 @@
+/********************************************************************************************//*!
+*
+*  @file        LFOUnitTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks LFOUnit's control-rate rendering against per-sample evaluation.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "LFO.hpp"
+#include "Crossfader.hpp"
+#include "Macro.hpp"
+#include "EngineContext.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    void setLevels(LFOSequence& sequence)
+    {
+        const double levels [] = { 0.1, 0.9, 0.3, 0.7, 0.5 };
+        
+        for (unsigned short seg = 0; seg < 5; ++seg)
+        {
+            sequence.setLinkedLevel(seg, levels[seg]);
+            
+            sequence.setSegmentRate(seg, 0.5 + 0.25 * seg);
+        }
+    }
+    
+    /*! The sequence's period must follow setRate() exactly, whatever the control rate */
+    void testSequencePeriod()
+    {
+        const double rate = 4.8;
+        
+        LFOUnit unit(LFOUnit::Mode::SEQ);
+        
+        unit.setActive(true);
+        
+        unit.fader().setValue(-100);
+        
+        setLevels(unit.seqs(LFOUnit::A));
+        
+        unit.seqs(LFOUnit::A).setRate(rate);
+        
+        LFOSequence reference;
+        
+        setLevels(reference);
+        
+        reference.setRate(rate);
+        
+        const unsigned long period = EngineContext::getDefault().getSamplerate() / rate;
+        
+        check(unit.seqs(LFOUnit::A).getSegmentLength() * 5 == period,
+              "segment lengths add up to the period set with setRate()");
+        
+        const unsigned short control = unit.getControlRate();
+        
+        // Sequences bake their tables a few values per call, and
+        // are only exact relative to each other once both are done
+        for (unsigned long n = 0; n < 2 * period; ++n)
+        {
+            unit.modulate(1, 1, 1);
+            
+            reference.modulate(1, 1, 1);
+            
+            unit.update();
+            
+            reference.update();
+        }
+        
+        check(unit.seqs(LFOUnit::A).isBaked() && reference.isBaked(), "both sequences are baked");
+        
+        std::vector<double> output(5 * period);
+        
+        double maximum = 0;
+        
+        for (unsigned long n = 0; n < output.size(); ++n)
+        {
+            output[n] = unit.modulate(1, 1, 1);
+            
+            const double expected = reference.modulate(1, 1, 1);
+            
+            // Exact at the start of each control period, interpolated in between
+            if (n % control == 0) maximum = std::max(maximum, std::fabs(output[n] - expected));
+            
+            unit.update();
+            
+            reference.update();
+        }
+        
+        check(maximum < 1e-9, "control-rate output matches per-sample evaluation");
+        
+        // Two periods are a whole number of control periods here
+        double drift = 0;
+        
+        for (unsigned long n = 0; n + 2 * period < output.size(); n += control)
+        {
+            drift = std::max(drift, std::fabs(output[n] - output[n + 2 * period]));
+        }
+        
+        check(drift < 1e-9, "sequence repeats with the period set with setRate()");
+    }
+    
+    /*! Modulating the crossfader must move it like setting its value does */
+    void testFaderModulation()
+    {
+        LFOUnit set;
+        
+        LFOUnit modulated;
+        
+        Macro macro(1);
+        
+        set.setActive(true);
+        
+        modulated.setActive(true);
+        
+        for (unsigned short i = 0; i < 2; ++i)
+        {
+            set.lfos(i).setFrequency(1 + i);
+            
+            modulated.lfos(i).setFrequency(1 + i);
+        }
+        
+        set.fader().setValue(100);
+        
+        modulated.fader().attachMod(Crossfader::VALUE, &macro);
+        
+        double maximum = 0;
+        
+        for (unsigned long n = 0; n < EngineContext::getDefault().getSamplerate(); ++n)
+        {
+            maximum = std::max(maximum, std::fabs(set.modulate(0, 1, 1) - modulated.modulate(0, 1, 1)));
+            
+            set.update();
+            
+            modulated.update();
+        }
+        
+        check(maximum < 1e-12, "modulation of the crossfader's value is applied");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testSequencePeriod();
+    
+    testFaderModulation();
+    
+    return Test::finish();
+}
@@ -0,0 +1,117 @@
+/********************************************************************************************//*!
+*
+*  @file        LookupTableTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks the four-point interpolation policies of LookupTable.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "LookupTable.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    /*! Returns the largest error of a policy over a table of f, sampled at 0 ... size - 1 */
+    template <typename Policy, typename Function>
+    double error(std::size_t size, Function f)
+    {
+        std::vector<double> values(size);
+        
+        for (std::size_t n = 0; n < size; ++n) values[n] = f(n);
+        
+        const LookupTable<double> table(values.data(), size, "test");
+        
+        double maximum = 0;
+        
+        for (double index = 0; index < size - 1; index += 0.125)
+        {
+            maximum = std::max(maximum, std::fabs(table.interpolate<Policy>(index) - f(index)));
+        }
+        
+        return maximum;
+    }
+    
+    double quadratic(double x)
+    {
+        return 0.5 * x * x - 3 * x + 1;
+    }
+    
+    double cubic(double x)
+    {
+        return 0.1 * x * x * x - x * x + 2 * x - 4;
+    }
+    
+    /*! A sine with a period of 16 samples, stored with a guard sample like a Wavetable */
+    double sine(double x)
+    {
+        return std::sin(2 * 3.141592653589793 * x / 16);
+    }
+    
+    void testPolynomials()
+    {
+        // Away from the ends, clamping does not matter
+        std::vector<double> values(12);
+        
+        for (std::size_t n = 0; n < values.size(); ++n) values[n] = cubic(n);
+        
+        const LookupTable<double> table(values.data(), values.size(), "cubic");
+        
+        double maximum = 0;
+        
+        for (double index = 1; index < 9; index += 0.125)
+        {
+            maximum = std::max(maximum, std::fabs(table.interpolate<LagrangeInterpolation<>>(index) - cubic(index)));
+        }
+        
+        check(maximum < 1e-9, "Lagrange interpolation reproduces a cubic");
+        
+        maximum = 0;
+        
+        for (std::size_t n = 0; n < values.size(); ++n) values[n] = quadratic(n);
+        
+        const LookupTable<double> other(values.data(), values.size(), "quadratic");
+        
+        for (double index = 1; index < 9; index += 0.125)
+        {
+            maximum = std::max(maximum, std::fabs(other.interpolate<HermiteInterpolation<>>(index) - quadratic(index)));
+        }
+        
+        check(maximum < 1e-9, "Hermite interpolation reproduces a quadratic");
+    }
+    
+    void testPeriodic()
+    {
+        // Sixteen samples per period plus the guard
+        const double hermite = error<HermiteInterpolation<PeriodicEdges>>(17, sine);
+        
+        const double lagrange = error<LagrangeInterpolation<PeriodicEdges>>(17, sine);
+        
+        check(hermite < 2e-3, "periodic Hermite interpolation is as exact at the ends as inside");
+        
+        check(lagrange < 2e-3, "periodic Lagrange interpolation is as exact at the ends as inside");
+        
+        check(error<HermiteInterpolation<ClampedEdges>>(17, sine) > 10 * hermite,
+              "clamped Hermite interpolation is worse at the ends of a periodic table");
+    }
+}
+
+int main()
+{
+    testPolynomials();
+    
+    testPeriodic();
+    
+    return Test::finish();
+}
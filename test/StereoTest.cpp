@@ -0,0 +1,162 @@
+/********************************************************************************************//*!
+*
+*  @file        StereoTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks that effects keep the channels of a stereo signal apart.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "Delay.hpp"
+#include "Chorus.hpp"
+#include "Flanger.hpp"
+#include "Filter.hpp"
+#include "ConvolutionReverb.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    std::vector<double> noise(std::size_t size)
+    {
+        std::vector<double> samples(size);
+        
+        for (std::size_t n = 0; n < size; ++n)
+        {
+            samples[n] = (std::rand() / static_cast<double>(RAND_MAX)) * 2 - 1;
+        }
+        
+        return samples;
+    }
+    
+    /*! A signal in the left channel only must stay there, as if processed in mono */
+    void testSeparate(EffectUnit& stereo, EffectUnit& mono, const std::string& name)
+    {
+        std::vector<double> left = noise(4000);
+        
+        std::vector<double> right(left.size(), 0);
+        
+        std::vector<double> expected(left);
+        
+        double difference = 0;
+        
+        double leaked = 0;
+        
+        for (std::size_t n = 0; n < left.size(); n += 100)
+        {
+            stereo.processStereo(&left[n], &right[n], 100);
+            
+            mono.processBlock(&expected[n], 100);
+        }
+        
+        for (std::size_t n = 0; n < left.size(); ++n)
+        {
+            difference = std::max(difference, std::fabs(left[n] - expected[n]));
+            
+            leaked = std::max(leaked, std::fabs(right[n]));
+        }
+        
+        check(difference < 1e-9, name + " processes the left channel like a mono signal");
+        
+        check(leaked == 0, name + " keeps the right channel silent");
+    }
+    
+    void testDelays()
+    {
+        Delay delay(0.01, 4, 0.001, 0.5), monoDelay(0.01, 4, 0.001, 0.5);
+        
+        delay.setDryWet(0.5);
+        
+        monoDelay.setDryWet(0.5);
+        
+        testSeparate(delay, monoDelay, "Delay");
+        
+        // Shorter than a sample
+        Delay shortDelay(0.00001, 4, 0.001, 0.5), monoShortDelay(0.00001, 4, 0.001, 0.5);
+        
+        testSeparate(shortDelay, monoShortDelay, "a sub-sample Delay");
+        
+        AllPassDelay allPass(0.01, 4, 0.001), monoAllPass(0.01, 4, 0.001);
+        
+        testSeparate(allPass, monoAllPass, "AllPassDelay");
+        
+        AllPassDelay shortAllPass(0.00001, 4, 0.001), monoShortAllPass(0.00001, 4, 0.001);
+        
+        testSeparate(shortAllPass, monoShortAllPass, "a sub-sample AllPassDelay");
+    }
+    
+    void testModulated()
+    {
+        Chorus chorus, monoChorus;
+        
+        testSeparate(chorus, monoChorus, "Chorus");
+        
+        // Shorter than a sample at the bottom of the sweep
+        Flanger flanger(0.00002, 0.00001), monoFlanger(0.00002, 0.00001);
+        
+        testSeparate(flanger, monoFlanger, "a sub-sample Flanger");
+        
+        Filter filter(Filter::LOW_PASS, 1000, 2), monoFilter(Filter::LOW_PASS, 1000, 2);
+        
+        testSeparate(filter, monoFilter, "Filter");
+        
+        ConvolutionReverb reverb(64, 0.5), monoReverb(64, 0.5);
+        
+        const std::vector<double> ir = noise(500);
+        
+        reverb.setImpulseResponse(ir);
+        
+        monoReverb.setImpulseResponse(ir);
+        
+        testSeparate(reverb, monoReverb, "ConvolutionReverb");
+    }
+    
+    /*! The same signal in both channels must come out wider */
+    void testChorusWidth()
+    {
+        Chorus chorus(0.02, 0.003, 0.8, 1);
+        
+        std::vector<double> left = noise(48000);
+        
+        std::vector<double> right(left);
+        
+        for (std::size_t n = 0; n < left.size(); n += 100)
+        {
+            chorus.processStereo(&left[n], &right[n], 100);
+        }
+        
+        double difference = 0;
+        
+        for (std::size_t n = 0; n < left.size(); ++n)
+        {
+            difference = std::max(difference, std::fabs(left[n] - right[n]));
+        }
+        
+        check(difference > 0.1, "Chorus decorrelates the channels");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testDelays();
+    
+    testModulated();
+    
+    testChorusWidth();
+    
+    return Test::finish();
+}
@@ -0,0 +1,56 @@
+/********************************************************************************************//*!
+*
+*  @file        Test.hpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       What the test programs share.
+*
+*  @details     Every program in test/ is a standalone executable that reports failed checks
+*               to std::cerr and returns non-zero if any check failed. Build one from the
+*               repository root with all sources, pointing ANTHEM_RESOURCE_PATH at rsc/ so
+*               that Global::init() finds its tables from any working directory:
+*
+*               c++ -std=c++11 -O2 -DANTHEM_RESOURCE_PATH='"'$PWD'/rsc/"' \
+*                   $(find include -type d | sed 's/^/-I/') \
+*                   test/FMTest.cpp $(find src -name '*.cpp') -lrtaudio -lrtmidi -pthread \
+*                   -o FMTest && ./FMTest
+*
+*               RtAudio and RtMidi are only needed because the mixer sources are compiled in.
+*
+************************************************************************************************/
+
+#ifndef __Anthem__Test__
+#define __Anthem__Test__
+
+#include <iostream>
+#include <string>
+
+namespace Test
+{
+    /*! The number of checks that failed so far */
+    static unsigned int failures = 0;
+    
+    /*! Reports what was checked if the condition does not hold */
+    static void check(bool condition, const std::string& what)
+    {
+        if (! condition)
+        {
+            std::cerr << "FAILED: " << what << std::endl;
+            
+            ++failures;
+        }
+    }
+    
+    /*! Returns the exit code for main(), after saying so if all checks passed */
+    static int finish()
+    {
+        if (! failures) std::cout << "All checks passed." << std::endl;
+        
+        return failures ? 1 : 0;
+    }
+}
+
+#endif /* defined(__Anthem__Test__) */
@@ -0,0 +1,129 @@
+/********************************************************************************************//*!
+*
+*  @file        WavetableDatabaseTest.cpp
+*
+*  @author      Peter Goldsborough
+*
+*  @date        19/10/2015
+*
+*  @brief       Checks when the WavetableDatabase frees replaced wavetables.
+*
+*  @details     Returns non-zero if a check fails, see Test.hpp for how to build and run it.
+*
+************************************************************************************************/
+
+#include "Wavetable.hpp"
+#include "Global.hpp"
+#include "Test.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Test::check;
+    
+    /*! Replaces the sine wavetable with a new one, returns the old one without ownership */
+    std::weak_ptr<const Wavetable> replace()
+    {
+        std::weak_ptr<const Wavetable> old = wavetableDatabase[WavetableDatabase::SINE];
+        
+        std::shared_ptr<const Wavetable> table =
+        std::make_shared<Wavetable>(Wavetable::MathematicalWaveform::DIRECT_SAW,
+                                    Global::wavetableLength + 1,
+                                    "test");
+        
+        wavetableDatabase.replace(WavetableDatabase::SINE, table);
+        
+        return old;
+    }
+    
+    /*! Readers that always overlap must not keep tables from being freed forever */
+    void testOverlappingReaders()
+    {
+        std::unique_ptr<WavetableDatabase::ReadGuard> first(new WavetableDatabase::ReadGuard(wavetableDatabase));
+        
+        std::weak_ptr<const Wavetable> old = replace();
+        
+        check(! old.expired(), "a table is kept while a reader that may use it is alive");
+        
+        std::unique_ptr<WavetableDatabase::ReadGuard> second(new WavetableDatabase::ReadGuard(wavetableDatabase));
+        
+        first.reset();
+        
+        wavetableDatabase.collect();
+        
+        check(old.expired(), "a table is freed once its readers are gone, despite newer readers");
+        
+        old = replace();
+        
+        wavetableDatabase.collect();
+        
+        check(! old.expired(), "a table is kept for a reader created before its replacement");
+        
+        second.reset();
+        
+        wavetableDatabase.collect();
+        
+        check(old.expired(), "a table is freed without readers");
+    }
+    
+    /*! Replaces tables while threads read them, run with -fsanitize=thread or address */
+    void testConcurrentReaders()
+    {
+        std::atomic<bool> done(false);
+        
+        std::vector<std::thread> readers;
+        
+        for (unsigned short i = 0; i < 4; ++i)
+        {
+            readers.push_back(std::thread([&] ()
+            {
+                double sum = 0;
+                
+                while (! done.load())
+                {
+                    WavetableDatabase::ReadGuard guard(wavetableDatabase);
+                    
+                    const Wavetable* table = wavetableDatabase.get(WavetableDatabase::SINE);
+                    
+                    for (unsigned int n = 0; n < Global::wavetableLength; n += 64)
+                    {
+                        sum += table->interpolate(n);
+                    }
+                }
+                
+                return sum;
+            }));
+        }
+        
+        for (unsigned short i = 0; i < 200; ++i) replace();
+        
+        done.store(true);
+        
+        for (std::vector<std::thread>::iterator itr = readers.begin(), end = readers.end();
+             itr != end;
+             ++itr)
+        {
+            itr->join();
+        }
+        
+        std::weak_ptr<const Wavetable> old = replace();
+        
+        check(old.expired(), "all tables are freed once the readers are done");
+    }
+}
+
+int main()
+{
+    Global::init(48000, 4095);
+    
+    testOverlappingReaders();
+    
+    testConcurrentReaders();
+    
+    return Test::finish();
+}